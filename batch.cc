@@ -0,0 +1,792 @@
+  // @file batch.cc
+  // @brief Entry point of the headless batch generator.
+  // @author Mamoru Kaminaga
+  // @date 2026-10-17
+  // Copyright 2026 Mamoru Kaminaga
+  // This program is provided with MIT license. See "LICENSE.md".
+#include <limits.h>
+#include <locale.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#include <string>
+#include <vector>
+
+#include "./bitmap.h"
+#include "./canvas.h"
+#include "./deflate.h"
+#include "./distribution.h"
+#include "./exporter.h"
+#include "./generator.h"
+#include "./noise.h"
+#include "./palette.h"
+#include "./palette_builder.h"
+#include "./palette_file.h"
+#include "./png.h"
+#include "./range.h"
+#include "./remapper.h"
+#include "./sampler.h"
+#include "./sequence.h"
+#include "./statistics.h"
+#include "./thread_pool.h"
+#include "./trace.h"
+#include "./common.h"
+
+#define DEFAULT_COLOR_FILE  "./colors/default.txt"
+#define DEFAULT_RANGE_GRID  (20)
+
+  // The 8 bit file holds up to this number of colors.
+#define INDEXED_COLOR_NUM   (256)
+
+namespace {
+  // The region drawn again by the other seed.
+struct Reroll {
+  uint32_t seed;
+  Rect2n region;
+};
+
+  // The options given from the command line.
+struct Option {
+  std::string palette_file;
+  std::string output_file;
+  std::string convert_file;
+  std::string extract_file;
+  std::string remap_file;
+  std::string save_file;
+  std::string trace_file;
+  std::string table_file;
+  std::string format;
+  std::string storage;
+  std::vector<int> range_color_ids;
+  std::vector<Reroll> rerolls;
+  PngOption png;
+  SequenceOption sequence;
+  Distribution distribution;
+  Noise noise;
+  Vector2n palette_grid;
+  Vector2n pixel;
+  uint32_t seed;
+  int extract_samples;
+  int extract_iterations;
+  int frame_num;
+  int thread_num;
+  bool check;
+  bool dither;
+  bool stream;
+  bool map;
+  Option()
+    : palette_file(DEFAULT_COLOR_FILE),
+      format("bmp8"),
+      storage("color"),
+      range_color_ids(DEFAULT_RANGE_GRID, 0),
+      palette_grid(16, 16),
+      pixel(64, 64),
+      seed(0),
+      extract_samples(PALETTE_BUILDER_DEFAULT_SAMPLES),
+      extract_iterations(PALETTE_BUILDER_DEFAULT_ITERATIONS),
+      frame_num(0),
+      thread_num(ThreadPool::GetHardwareThreadNum()),
+      check(false),
+      dither(false),
+      stream(false),
+      map(false) { }
+};
+
+void PrintUsage() {
+  fprintf(stderr,
+      "usage: color01_batch [options] --output FILE\n"
+      "  --palette FILE   palette color file (default %s)\n"
+      "  --palette-size WxH\n"
+      "                   palette grids, up to 65536 colors (default 16x16)\n"
+      "  --extract IMAGE  build the palette from the 8, 24 or 32 bit bitmap\n"
+      "                   IMAGE instead of the palette file, up to %d colors\n"
+      "  --extract-samples N\n"
+      "                   pixels sampled from IMAGE (default %d)\n"
+      "  --extract-iterations N\n"
+      "                   k-means iterations (default %d)\n"
+      "  --range IDS      comma separated palette ids of the range grids\n"
+      "                   (default %d grids of id 0)\n"
+      "  --distribution NAME\n"
+      "                   normal, uniform, exponential, lognormal,\n"
+      "                   triangular or table (default normal)\n"
+      "  --dist-range R   range divided into the grids (default %.2f)\n"
+      "  --dist-sigma S   scale of normal, exponential and lognormal\n"
+      "                   (default %.1f)\n"
+      "  --dist-table FILE\n"
+      "                   CDF values at the points dividing the range\n"
+      "                   equally, for the table distribution\n"
+      "  --noise TYPE     none, value or gradient, the tileable noise field\n"
+      "                   picks the grids (default none)\n"
+      "  --noise-cell N   pixels of the coarsest noise cell (default %d)\n"
+      "  --noise-octaves N\n"
+      "                   octaves of the noise, up to %d (default %d)\n"
+      "  --noise-persistence P\n"
+      "                   amplitude ratio of the octaves (default %.1f)\n"
+      "  --remap IMAGE    map the 8, 24 or 32 bit bitmap IMAGE to the nearest\n"
+      "                   palette colors instead of generating the image, up\n"
+      "                   to %d colors\n"
+      "  --dither         diffuse the errors of --remap by Floyd-Steinberg\n"
+      "  --size WxH       canvas pixels (default 64x64)\n"
+      "  --seed N         random seed (default 0)\n"
+      "  --reroll S:X,Y,W,H\n"
+      "                   draw the region again by the seed S, repeatable\n"
+      "  --frames N       write N frames of the seeds S, S + step, ... as\n"
+      "                   FILE_0000.ext, ..., bmp8, bmp24 or bmp32 only\n"
+      "  --seed-step N    seed step of the frames (default 1)\n"
+      "  --queue N        frames waiting between the stages of the frames\n"
+      "                   (default %d)\n"
+      "  --threads N      number of threads (default all the cores)\n"
+      "  --storage MODE   color: a byte per pixel, bucket: packed range\n"
+      "                   bucket ids (default color)\n"
+      "  --format FORMAT  bmp8, bmp8rle, bmp24, bmp32, png8 or png24 (default\n"
+      "                   bmp8), bmp8, bmp8rle and png8 hold up to 256 colors\n"
+      "  --png-filter FILTER\n"
+      "                   none, sub, up, average, paeth or adaptive (default\n"
+      "                   none)\n"
+      "  --png-level N    compression level 0 to 9 (default 6)\n"
+      "  --output FILE    output file\n"
+      "  --convert FILE   save the palette as the binary palette FILE, no\n"
+      "                   image is made\n"
+      "  --save-palette FILE\n"
+      "                   save the palette as the text palette FILE, no image\n"
+      "                   is made without --output\n"
+      "  --check          test the bucket counts taken while generating\n"
+      "                   against the distribution by the chi-square and\n"
+      "                   the Kolmogorov-Smirnov tests, not with the noise\n"
+      "  --stream         write the rows while generating them, the canvas\n"
+      "                   is not kept in memory\n"
+      "  --mmap           write the rows on the threads directly into the\n"
+      "                   memory mapped file\n"
+      "  --trace FILE     write the Chrome trace-event JSON, the program\n"
+      "                   must be built with ENABLE_TRACE\n",
+      DEFAULT_COLOR_FILE, INDEXED_COLOR_NUM,
+      PALETTE_BUILDER_DEFAULT_SAMPLES, PALETTE_BUILDER_DEFAULT_ITERATIONS,
+      DEFAULT_RANGE_GRID, DISTRIBUTION_DEFAULT_RANGE,
+      DISTRIBUTION_DEFAULT_SIGMA, NOISE_DEFAULT_CELL, NOISE_MAX_OCTAVES,
+      NOISE_DEFAULT_OCTAVES, NOISE_DEFAULT_PERSISTENCE,
+      REMAPPER_MAX_COLOR_NUM, SEQUENCE_DEFAULT_QUEUE);
+}
+bool ParseRange(const char* text, std::vector<int>* color_ids) {
+  color_ids->clear();
+  const char* p = text;
+  char* end = nullptr;
+  while (*p != '\0') {
+    long color_id = strtol(p, &end, 10);
+    if (end == p) return false;
+    color_ids->push_back(static_cast<int>(color_id));
+    p = end;
+    if (*p == ',') ++p;
+  }
+  return !color_ids->empty();
+}
+bool ParseSize(const char* text, Vector2n* pixel) {
+  int x = 0;
+  int y = 0;
+  if (sscanf(text, "%dx%d", &x, &y) != 2) return false;
+  if ((x <= 0) || (y <= 0)) return false;
+  pixel->x = x;
+  pixel->y = y;
+  return true;
+}
+bool ParseReroll(const char* text, Reroll* reroll) {
+  unsigned int seed = 0;
+  int x = 0;
+  int y = 0;
+  int width = 0;
+  int height = 0;
+  if (sscanf(text, "%u:%d,%d,%d,%d", &seed, &x, &y, &width, &height) != 5) {
+    return false;
+  }
+  if ((width <= 0) || (height <= 0)) return false;
+  reroll->seed = seed;
+  reroll->region = Rect2n(x, y, x + width, y + height);
+  return true;
+}
+bool ParsePngFilter(const char* text, PNG_FILTER* filter) {
+  const char* kNames[] = {"none", "sub", "up", "average", "paeth", "adaptive"};
+  for (int i = 0; i <= PNG_FILTER_ADAPTIVE; ++i) {
+    if (strcmp(text, kNames[i]) == 0) {
+      *filter = static_cast<PNG_FILTER>(i);
+      return true;
+    }
+  }
+  return false;
+}
+bool ParseDistribution(const char* text, DISTRIBUTION_TYPE* type) {
+  const char* kNames[] = {
+    "normal", "uniform", "exponential", "lognormal", "triangular", "table"
+  };
+  for (int i = 0; i <= DISTRIBUTION_TABLE; ++i) {
+    if (strcmp(text, kNames[i]) == 0) {
+      *type = static_cast<DISTRIBUTION_TYPE>(i);
+      return true;
+    }
+  }
+  return false;
+}
+bool ParseNoise(const char* text, NOISE_TYPE* type) {
+  const char* kNames[] = {"none", "value", "gradient"};
+  for (int i = 0; i <= NOISE_GRADIENT; ++i) {
+    if (strcmp(text, kNames[i]) == 0) {
+      *type = static_cast<NOISE_TYPE>(i);
+      return true;
+    }
+  }
+  return false;
+}
+bool IsPngFormat(const std::string& format) {
+  return (format == "png8") || (format == "png24");
+}
+bool IsIndexedFormat(const std::string& format) {
+  return (format == "bmp8") || (format == "bmp8rle") || (format == "png8");
+}
+bool ParseOption(int argc, char** argv, Option* option) {
+  for (int i = 1; i < argc; ++i) {
+    // The flags take no value.
+    if (strcmp(argv[i], "--check") == 0) {
+      option->check = true;
+      continue;
+    }
+    if (strcmp(argv[i], "--stream") == 0) {
+      option->stream = true;
+      continue;
+    }
+    if (strcmp(argv[i], "--dither") == 0) {
+      option->dither = true;
+      continue;
+    }
+    if (strcmp(argv[i], "--mmap") == 0) {
+      option->map = true;
+      continue;
+    }
+
+    // Every other option takes one value.
+    if (i + 1 >= argc) return false;
+    const char* key = argv[i];
+    const char* value = argv[++i];
+    if (strcmp(key, "--palette") == 0) {
+      option->palette_file = value;
+    } else if (strcmp(key, "--palette-size") == 0) {
+      if (!ParseSize(value, &option->palette_grid)) return false;
+      const int64_t color_num =
+        static_cast<int64_t>(option->palette_grid.x) * option->palette_grid.y;
+      if (color_num > PALETTE_MAX_COLOR_NUM) return false;
+    } else if (strcmp(key, "--extract") == 0) {
+      option->extract_file = value;
+    } else if (strcmp(key, "--extract-samples") == 0) {
+      option->extract_samples = atoi(value);
+      if (option->extract_samples < 1) return false;
+    } else if (strcmp(key, "--extract-iterations") == 0) {
+      option->extract_iterations = atoi(value);
+      if (option->extract_iterations < 1) return false;
+    } else if (strcmp(key, "--range") == 0) {
+      if (!ParseRange(value, &option->range_color_ids)) return false;
+    } else if (strcmp(key, "--distribution") == 0) {
+      if (!ParseDistribution(value, &option->distribution.type)) return false;
+    } else if (strcmp(key, "--dist-range") == 0) {
+      option->distribution.range = atof(value);
+    } else if (strcmp(key, "--dist-sigma") == 0) {
+      option->distribution.sigma = atof(value);
+    } else if (strcmp(key, "--dist-table") == 0) {
+      option->table_file = value;
+    } else if (strcmp(key, "--noise") == 0) {
+      if (!ParseNoise(value, &option->noise.type)) return false;
+    } else if (strcmp(key, "--noise-cell") == 0) {
+      option->noise.cell = atoi(value);
+    } else if (strcmp(key, "--noise-octaves") == 0) {
+      option->noise.octaves = atoi(value);
+    } else if (strcmp(key, "--noise-persistence") == 0) {
+      option->noise.persistence = atof(value);
+    } else if (strcmp(key, "--remap") == 0) {
+      option->remap_file = value;
+    } else if (strcmp(key, "--size") == 0) {
+      if (!ParseSize(value, &option->pixel)) return false;
+    } else if (strcmp(key, "--seed") == 0) {
+      option->seed = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+    } else if (strcmp(key, "--reroll") == 0) {
+      Reroll reroll;
+      if (!ParseReroll(value, &reroll)) return false;
+      option->rerolls.push_back(reroll);
+    } else if (strcmp(key, "--frames") == 0) {
+      option->frame_num = atoi(value);
+      if (option->frame_num < 1) return false;
+    } else if (strcmp(key, "--seed-step") == 0) {
+      option->sequence.seed_step =
+        static_cast<uint32_t>(strtoul(value, nullptr, 10));
+    } else if (strcmp(key, "--queue") == 0) {
+      option->sequence.queue_size = atoi(value);
+      if (option->sequence.queue_size < 1) return false;
+    } else if (strcmp(key, "--threads") == 0) {
+      option->thread_num = atoi(value);
+      if (option->thread_num < 1) return false;
+    } else if (strcmp(key, "--storage") == 0) {
+      option->storage = value;
+      if ((option->storage != "color") && (option->storage != "bucket")) {
+        return false;
+      }
+    } else if (strcmp(key, "--format") == 0) {
+      option->format = value;
+    } else if (strcmp(key, "--png-filter") == 0) {
+      if (!ParsePngFilter(value, &option->png.filter)) return false;
+    } else if (strcmp(key, "--png-level") == 0) {
+      option->png.level = atoi(value);
+      if ((option->png.level < 0) || (option->png.level > DEFLATE_MAX_LEVEL)) {
+        return false;
+      }
+    } else if (strcmp(key, "--output") == 0) {
+      option->output_file = value;
+    } else if (strcmp(key, "--convert") == 0) {
+      option->convert_file = value;
+    } else if (strcmp(key, "--save-palette") == 0) {
+      option->save_file = value;
+    } else if (strcmp(key, "--trace") == 0) {
+      option->trace_file = value;
+    } else {
+      return false;
+    }
+  }
+  if (option->check && option->stream) return false;
+
+  // The pixels of the noise are not independent, the counts are not tested.
+  if (!IsValidNoise(option->noise)) return false;
+  if (option->check && (option->noise.type != NOISE_NONE)) return false;
+
+  // The table distribution takes the table, the others do not.
+  const bool table = (option->distribution.type == DISTRIBUTION_TABLE);
+  if (table == option->table_file.empty()) return false;
+  if (!table && !IsValidDistribution(option->distribution)) return false;
+  if (!IsIndexedFormat(option->format) && (option->format != "bmp24") &&
+      (option->format != "bmp32") && !IsPngFormat(option->format)) {
+    return false;
+  }
+
+  // The PNG and the RLE bitmap are compressed in the order of the rows,
+  // they are not mapped.
+  if (option->map &&
+      (IsPngFormat(option->format) || (option->format == "bmp8rle"))) {
+    return false;
+  }
+
+  // The frames are the uncompressed bitmaps of the whole canvases.
+  if (option->frame_num > 0) {
+    if ((option->format != "bmp8") && (option->format != "bmp24") &&
+        (option->format != "bmp32")) {
+      return false;
+    }
+    if (option->stream || option->map || option->check ||
+        !option->rerolls.empty() || option->output_file.empty()) {
+      return false;
+    }
+  }
+
+  // The remapped image is not generated, the size is of the image.
+  if (option->dither && option->remap_file.empty()) return false;
+  if (!option->remap_file.empty() &&
+      (option->stream || option->check || (option->frame_num > 0) ||
+       !option->rerolls.empty() || option->output_file.empty())) {
+    return false;
+  }
+
+  // The k-means takes the time of the colors and the remapped image is 8
+  // bit, the palette of the 8 bit file is enough.
+  if ((!option->extract_file.empty() || !option->remap_file.empty()) &&
+      (option->palette_grid.x * option->palette_grid.y > INDEXED_COLOR_NUM)) {
+    return false;
+  }
+  return !option->output_file.empty() || !option->convert_file.empty() ||
+    !option->save_file.empty();
+}
+bool CheckCanvas(
+    const Canvas& canvas,
+    const Range& range,
+    int color_num,
+    bool rerolled) {
+  // The buckets are counted by the update of the whole canvas, they are
+  // tested without reading the canvas again.
+  BucketSampler sampler;
+  sampler.Init(range.GetGrid(), range.GetDistribution());
+  const double kSignificance = 1e-3;
+  if (!rerolled) {
+    std::vector<double> probabilities(range.GetGrid());
+    for (int grid_id = 0; grid_id < range.GetGrid(); ++grid_id) {
+      probabilities[grid_id] = sampler.GetProbability(grid_id);
+    }
+    const std::vector<int64_t>& counts = canvas.GetBucketCounts();
+    const FitResult result = TestCounts(counts, probabilities);
+    const KsResult ks_result = TestCumulative(counts, probabilities);
+    printf("chi-square %.3f, freedom %d, p-value %.6f\n",
+        result.chi_square, result.freedom, result.p_value);
+    printf("ks distance %.6f, p-value %.6f\n",
+        ks_result.distance, ks_result.p_value);
+    return (result.p_value >= kSignificance) &&
+      (ks_result.p_value >= kSignificance);
+  }
+
+  // The rerolled canvas is counted again by the colors. The expected
+  // probability of each color is the sum of its buckets.
+  std::vector<double> probabilities(color_num, 0.0);
+  for (int grid_id = 0; grid_id < range.GetGrid(); ++grid_id) {
+    probabilities[range.GetColorId(grid_id)] +=
+      sampler.GetProbability(grid_id);
+  }
+  std::vector<int64_t> counts(color_num, 0);
+  const Vector2n pixel = canvas.GetPixels();
+  std::vector<uint16_t> color_ids(pixel.x);
+  for (int y = 0; y < pixel.y; ++y) {
+    canvas.GetColorRow(y, color_ids.data());
+    for (int x = 0; x < pixel.x; ++x) ++counts[color_ids[x]];
+  }
+
+  // The check fails only for the clearly broken distribution.
+  const FitResult result = TestCounts(counts, probabilities);
+  printf("chi-square %.3f, freedom %d, p-value %.6f\n",
+      result.chi_square, result.freedom, result.p_value);
+  return result.p_value >= kSignificance;
+}
+std::wstring ToWide(const std::string& text) {
+  // The multi byte names of the locale are converted to the wide names.
+  const size_t size = mbstowcs(nullptr, text.c_str(), 0);
+  if (size == static_cast<size_t>(-1)) return std::wstring();
+  std::vector<wchar_t> buffer(size + 1);
+  mbstowcs(buffer.data(), text.c_str(), buffer.size());
+  return std::wstring(buffer.data());
+}
+bool WriteIndexedBitmap(
+    const Option& option,
+    const Palette& palette,
+    const RowSource& source,
+    ThreadPool* pool) {
+  const std::wstring output_file = ToWide(option.output_file);
+  const wchar_t* file_name = output_file.c_str();
+  if (option.format == "png8") {
+    return StreamPng8(
+        file_name, option.pixel, palette, source, option.png, pool);
+  }
+  if (option.format == "bmp8rle") {
+    return StreamBitmapWin8Rle(
+        file_name, option.pixel, palette, source, pool);
+  }
+  return option.map ?
+    MapBitmapWin8(file_name, option.pixel, palette, source, pool) :
+    StreamBitmapWin8(file_name, option.pixel, palette, source, pool);
+}
+bool WriteIndexedBitmap(
+    const Option& option,
+    const Palette& palette,
+    const WideRowSource& source,
+    ThreadPool* pool) {
+  // The 16 bit color ids do not fit in the 8 bit file.
+  UNREFERENCED_PARAMETER(option);
+  UNREFERENCED_PARAMETER(palette);
+  UNREFERENCED_PARAMETER(source);
+  UNREFERENCED_PARAMETER(pool);
+  return false;
+}
+template<class INDEX>
+bool WriteBitmap(
+    const Option& option,
+    const Palette& palette,
+    const IndexRowSource<INDEX>& source,
+    ThreadPool* pool) {
+  if (IsIndexedFormat(option.format)) {
+    return WriteIndexedBitmap(option, palette, source, pool);
+  }
+  const std::wstring output_file = ToWide(option.output_file);
+  const wchar_t* file_name = output_file.c_str();
+  if (option.format == "png24") {
+    return StreamPng24(
+        file_name, option.pixel, palette, source, option.png, pool);
+  }
+  if (option.map) {
+    return (option.format == "bmp24") ?
+      MapBitmapWin24(file_name, option.pixel, palette, source, pool) :
+      MapBitmapWin32(file_name, option.pixel, palette, source, pool);
+  }
+  return (option.format == "bmp24") ?
+    StreamBitmapWin24(file_name, option.pixel, palette, source, pool) :
+    StreamBitmapWin32(file_name, option.pixel, palette, source, pool);
+}
+  // The color ids are 8 bits for the small palette, 16 bits for the large
+  // palette.
+template<class INDEX>
+bool Stream(
+    const Option& option,
+    const Palette& palette,
+    const Range& range,
+    ThreadPool* pool) {
+  // The generators of the base seed and the rerolled regions.
+  const int width = option.pixel.x;
+  Generator generator;
+  generator.Init(range, option.seed, option.pixel, option.noise);
+  std::vector<Generator> reroll_generators(option.rerolls.size());
+  for (size_t i = 0; i < option.rerolls.size(); ++i) {
+    reroll_generators[i].Init(
+        range, option.rerolls[i].seed, option.pixel, option.noise);
+  }
+
+  // The rerolled regions overwrite the row in the order of the options.
+  IndexRowSource<INDEX> source = [&](int y, INDEX* color_ids) {
+    generator.GenerateSpan(0, y, width, color_ids);
+    for (size_t i = 0; i < option.rerolls.size(); ++i) {
+      const Rect2n& region = option.rerolls[i].region;
+      if ((y < region.top) || (y >= region.bottom)) continue;
+      const int left = (region.left > 0) ? region.left : 0;
+      const int right = (region.right < width) ? region.right : width;
+      if (left >= right) continue;
+      reroll_generators[i].GenerateSpan(
+          left, y, right - left, &color_ids[left]);
+    }
+  };
+
+  // The file is created.
+  return WriteBitmap(option, palette, source, pool);
+}
+template<class INDEX>
+bool MapCanvas(
+    const Option& option,
+    const Palette& palette,
+    const Canvas& canvas,
+    ThreadPool* pool) {
+  IndexRowSource<INDEX> source = [&canvas](int y, INDEX* color_ids) {
+    canvas.GetColorRow(y, color_ids);
+  };
+  return WriteBitmap(option, palette, source, pool);
+}
+  // The palette colors are built from the sampled pixels of the image.
+bool ExtractPalette(const Option& option, ThreadPool* pool, Palette* palette) {
+  TRACE_SCOPE("ExtractPalette");
+  const std::wstring file_name = ToWide(option.extract_file);
+  Vector2n pixel;
+  std::vector<uint32_t> pixels;
+  if (!LoadBitmapColors(
+      file_name.c_str(), option.extract_samples, &pixel, &pixels)) {
+    return false;
+  }
+  std::vector<uint32_t> colors;
+  BuildPalette(pixels.data(), pixels.size(), palette->GetColorNum(),
+      option.extract_iterations, pool, &colors);
+  palette->SetColors(colors.data(), static_cast<int>(colors.size()));
+  return true;
+}
+  // The image is mapped to the palette and written in the size of the
+  // image.
+bool Remap(const Option& option, const Palette& palette, ThreadPool* pool) {
+  TRACE_SCOPE("Remap");
+  Vector2n pixel;
+  std::vector<uint32_t> colors;
+  if (!LoadBitmapColors(
+      ToWide(option.remap_file).c_str(), INT_MAX, &pixel, &colors)) {
+    fprintf(stderr, "Failed to read %s\n", option.remap_file.c_str());
+    return false;
+  }
+  Remapper remapper;
+  remapper.Init(palette, pool);
+  std::vector<uint8_t> color_ids(colors.size());
+  remapper.MapImage(pixel, colors.data(), option.dither, pool,
+      color_ids.data());
+  std::vector<uint32_t>().swap(colors);
+
+  Option image_option = option;
+  image_option.pixel = pixel;
+  const size_t width = static_cast<size_t>(pixel.x);
+  RowSource source = [&color_ids, width](int y, uint8_t* row) {
+    memcpy(row, &color_ids[y * width], width);
+  };
+  if (!WriteBitmap(image_option, palette, source, pool)) {
+    fprintf(stderr, "Failed to create %s\n", option.output_file.c_str());
+    return false;
+  }
+  return true;
+}
+  // The image is made by the options, returns the exit code.
+int Run(const Option& option) {
+  TRACE_SCOPE("Run");
+
+  // The palette is loaded, the default grid is same as the dialog.
+  const Vector2n pallete_grids = option.palette_grid;
+  const int color_num = pallete_grids.x * pallete_grids.y;
+  const bool wide = (color_num > INDEXED_COLOR_NUM);
+  Palette palette;
+  palette.Init(pallete_grids);
+  ThreadPool pool;
+  pool.Create(option.thread_num);
+  int error_line = 0;
+  if (!option.extract_file.empty()) {
+    if (!ExtractPalette(option, &pool, &palette)) {
+      fprintf(stderr, "Failed to read %s\n", option.extract_file.c_str());
+      return 1;
+    }
+  } else if (!palette.LoadColor(
+      ToWide(option.palette_file).c_str(), &error_line)) {
+    if (error_line > 0) {
+      fprintf(stderr, "Wrong color at %s:%d\n",
+          option.palette_file.c_str(), error_line);
+    } else {
+      fprintf(stderr, "Failed to open %s\n", option.palette_file.c_str());
+    }
+    return 1;
+  }
+
+  // The palette is converted to the binary palette.
+  if (!option.convert_file.empty()) {
+    if (!SavePaletteBinary(
+        ToWide(option.convert_file).c_str(),
+        palette.GetPackedColors(),
+        color_num)) {
+      fprintf(stderr, "Failed to create %s\n", option.convert_file.c_str());
+      return 1;
+    }
+  }
+  if (!option.save_file.empty()) {
+    if (!SavePaletteText(
+        ToWide(option.save_file).c_str(),
+        palette.GetPackedColors(),
+        color_num)) {
+      fprintf(stderr, "Failed to create %s\n", option.save_file.c_str());
+      return 1;
+    }
+  }
+  if (option.output_file.empty()) return 0;
+
+  // The 16 bit color ids do not fit in the 8 bit file.
+  if (wide && IsIndexedFormat(option.format)) {
+    fprintf(stderr, "%s holds up to %d colors\n",
+        option.format.c_str(), INDEXED_COLOR_NUM);
+    return 1;
+  }
+  if (!option.remap_file.empty()) {
+    if (!Remap(option, palette, &pool)) return 1;
+    return 0;
+  }
+
+  // The range is set from the mapping.
+  const int range_grids = static_cast<int>(option.range_color_ids.size());
+  if (range_grids > RANGE_MAX_GRID) {
+    fprintf(stderr, "The range holds up to %d grids\n", RANGE_MAX_GRID);
+    return 1;
+  }
+  Range range;
+  range.Init(range_grids);
+  for (int grid_id = 0; grid_id < range_grids; ++grid_id) {
+    const int color_id = option.range_color_ids[grid_id];
+    if ((color_id < 0) || (color_id >= color_num)) {
+      fprintf(stderr, "Illegal color id %d\n", color_id);
+      return 1;
+    }
+    range.SetColorId(grid_id, color_id);
+  }
+
+  // The distribution of the range, the table is read from the file.
+  Distribution distribution = option.distribution;
+  if (!option.table_file.empty()) {
+    if (!LoadDistributionTable(
+        ToWide(option.table_file).c_str(), &distribution.table)) {
+      fprintf(stderr, "Failed to read %s\n", option.table_file.c_str());
+      return 1;
+    }
+  }
+  if (!IsValidDistribution(distribution)) {
+    fprintf(stderr, "Illegal distribution\n");
+    return 1;
+  }
+  range.SetDistribution(distribution);
+
+  // The rows are written while they are generated.
+  if (option.stream) {
+    const bool result = wide ?
+      Stream<uint16_t>(option, palette, range, &pool) :
+      Stream<uint8_t>(option, palette, range, &pool);
+    if (!result) {
+      fprintf(stderr, "Failed to create %s\n", option.output_file.c_str());
+      return 1;
+    }
+    return 0;
+  }
+
+  // The canvas pixels are drawn in random following normal distribution.
+  Canvas canvas;
+  canvas.Init(option.pixel, (option.storage == "bucket") ?
+      CANVAS_STORAGE_BUCKET_ID : CANVAS_STORAGE_COLOR_ID);
+  canvas.SetThreadPool(&pool);
+  canvas.SetNoise(option.noise);
+
+  // The frames are generated and written by the pipeline.
+  if (option.frame_num > 0) {
+    SequenceOption sequence = option.sequence;
+    sequence.frame_num = option.frame_num;
+    sequence.seed = option.seed;
+    sequence.bit_number = atoi(option.format.c_str() + 3);
+    if (!ExportSequence(ToWide(option.output_file).c_str(), canvas, palette,
+        range, sequence, &pool)) {
+      fprintf(stderr, "Failed to create %s\n", option.output_file.c_str());
+      return 1;
+    }
+    return 0;
+  }
+  canvas.Update(palette, range, option.seed);
+  for (size_t i = 0; i < option.rerolls.size(); ++i) {
+    const Reroll& reroll = option.rerolls[i];
+    canvas.UpdateRegion(palette, range, reroll.seed, reroll.region);
+  }
+  if (option.check &&
+      !CheckCanvas(canvas, range, color_num, !option.rerolls.empty())) {
+    fprintf(stderr, "The colors do not follow the distribution\n");
+    return 1;
+  }
+
+  // The file is created, the mapped file is written on the threads.
+  bool result = false;
+  if (option.map) {
+    result = wide ?
+      MapCanvas<uint16_t>(option, palette, canvas, &pool) :
+      MapCanvas<uint8_t>(option, palette, canvas, &pool);
+  } else {
+    const std::wstring output_file = ToWide(option.output_file);
+    if (option.format == "png8") {
+      result = ExportPng8(
+          output_file.c_str(), canvas, palette, option.png, &pool);
+    } else if (option.format == "png24") {
+      result = ExportPng24(
+          output_file.c_str(), canvas, palette, option.png, &pool);
+    } else if (option.format == "bmp8") {
+      result = ExportBitmapWin8(output_file.c_str(), canvas, palette);
+    } else if (option.format == "bmp8rle") {
+      result = ExportBitmapWin8Rle(output_file.c_str(), canvas, palette);
+    } else if (option.format == "bmp24") {
+      result = ExportBitmapWin24(output_file.c_str(), canvas, palette);
+    } else {
+      result = ExportBitmapWin32(output_file.c_str(), canvas, palette);
+    }
+  }
+  if (!result) {
+    fprintf(stderr, "Failed to create %s\n", option.output_file.c_str());
+    return 1;
+  }
+  return 0;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  setlocale(LC_ALL, "");
+
+  Option option;
+  if (!ParseOption(argc, argv, &option)) {
+    PrintUsage();
+    return 1;
+  }
+
+  // The events are recorded through the whole run.
+  const bool trace = !option.trace_file.empty();
+  if (trace && !TraceStart(ToWide(option.trace_file).c_str())) {
+    fprintf(stderr, "Tracing is not compiled, build with ENABLE_TRACE\n");
+    return 1;
+  }
+  const int result = Run(option);
+  if (trace && !TraceStop()) {
+    fprintf(stderr, "Failed to create %s\n", option.trace_file.c_str());
+    return 1;
+  }
+  return result;
+}
@@ -0,0 +1,708 @@
+  // @file bench.cc
+  // @brief Entry point of the benchmark of the generation and the export.
+  // @author Mamoru Kaminaga
+  // @date 2026-10-17
+  // Copyright 2026 Mamoru Kaminaga
+  // This program is provided with MIT license. See "LICENSE.md".
+#include <locale.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "./bitmap.h"
+#include "./canvas.h"
+#include "./cpu.h"
+#include "./exporter.h"
+#include "./generate_worker.h"
+#include "./noise.h"
+#include "./palette.h"
+#include "./palette_file.h"
+#include "./png.h"
+#include "./random.h"
+#include "./range.h"
+#include "./remapper.h"
+#include "./thread_pool.h"
+#include "./common.h"
+
+  // The case is repeated until this time has passed, the fastest run is
+  // taken.
+#define BENCH_MIN_TIME      (0.5)
+
+  // The canvas is drawn into the preview panel of this size.
+#define BENCH_PREVIEW_SIZE  (512)
+
+  // The legacy writers take the whole image as the array of RGBVecotr, they
+  // and the remapper are measured up to this number of pixels.
+#define BENCH_ARRAY_PIXELS  (4096 * 4096)
+
+  // The exported canvas has the range grids and the colors of the dialog.
+#define BENCH_EXPORT_GRID   (20)
+#define BENCH_EXPORT_COLORS (256)
+
+  // The worker case sends this number of the requests at once, as the
+  // button clicked repeatedly.
+#define BENCH_WORKER_BURST  (8)
+
+namespace {
+  // The options given from the command line.
+struct Option {
+  std::vector<int> sizes;
+  std::vector<int> grids;
+  std::vector<int> color_nums;
+  std::string filter;
+  std::string temp_dir;
+  std::string json_file;
+  std::string baseline_file;
+  double min_time;
+  double threshold;
+  int thread_num;
+  Option()
+    : sizes({64, 256, 1024, 4096, 16384}),
+      grids({4, 20, 64}),
+      color_nums({256, 65536}),
+      temp_dir("."),
+      min_time(BENCH_MIN_TIME),
+      threshold(10.0),
+      thread_num(ThreadPool::GetHardwareThreadNum()) { }
+};
+
+  // The result of one case. The items are the pixels, or the colors of the
+  // palette.
+struct Result {
+  std::string name;
+  std::string unit;
+  int64_t items;
+  int iterations;
+  double seconds;
+  double items_per_second;
+};
+
+void PrintUsage() {
+  fprintf(stderr,
+      "usage: color01_bench [options]\n"
+      "  --sizes N,...    canvas widths and heights (default\n"
+      "                   64,256,1024,4096,16384)\n"
+      "  --grids N,...    range grid counts (default 4,20,64)\n"
+      "  --colors N,...   palette color counts, multiples of 256 up to\n"
+      "                   65536 or less than 256 (default 256,65536)\n"
+      "  --filter TEXT    only the cases whose names contain TEXT\n"
+      "  --min-time S     seconds to repeat every case (default %.1f)\n"
+      "  --threads N      number of threads (default all the cores)\n"
+      "  --temp DIR       directory of the temporary files (default .)\n"
+      "  --json FILE      write the results as JSON\n"
+      "  --baseline FILE  compare with the JSON of the earlier results,\n"
+      "                   the exit code is 2 on any regression\n"
+      "  --threshold P    slowdown in percent taken as the regression\n"
+      "                   (default 10)\n",
+      BENCH_MIN_TIME);
+}
+bool ParseList(const char* text, std::vector<int>* values) {
+  values->clear();
+  const char* p = text;
+  char* end = nullptr;
+  while (*p != '\0') {
+    const long value = strtol(p, &end, 10);
+    if ((end == p) || (value < 1) || (value > 65536)) return false;
+    values->push_back(static_cast<int>(value));
+    p = end;
+    if (*p == ',') ++p;
+  }
+  return !values->empty();
+}
+bool ParseOption(int argc, char** argv, Option* option) {
+  for (int i = 1; i < argc; ++i) {
+    // Every option takes one value.
+    if (i + 1 >= argc) return false;
+    const char* key = argv[i];
+    const char* value = argv[++i];
+    if (strcmp(key, "--sizes") == 0) {
+      if (!ParseList(value, &option->sizes)) return false;
+    } else if (strcmp(key, "--grids") == 0) {
+      if (!ParseList(value, &option->grids)) return false;
+    } else if (strcmp(key, "--colors") == 0) {
+      if (!ParseList(value, &option->color_nums)) return false;
+      for (size_t j = 0; j < option->color_nums.size(); ++j) {
+        const int color_num = option->color_nums[j];
+        if ((color_num > 256) && (color_num % 256 != 0)) return false;
+      }
+    } else if (strcmp(key, "--filter") == 0) {
+      option->filter = value;
+    } else if (strcmp(key, "--min-time") == 0) {
+      option->min_time = atof(value);
+      if (option->min_time < 0.0) return false;
+    } else if (strcmp(key, "--threads") == 0) {
+      option->thread_num = atoi(value);
+      if (option->thread_num < 1) return false;
+    } else if (strcmp(key, "--temp") == 0) {
+      option->temp_dir = value;
+    } else if (strcmp(key, "--json") == 0) {
+      option->json_file = value;
+    } else if (strcmp(key, "--baseline") == 0) {
+      option->baseline_file = value;
+    } else if (strcmp(key, "--threshold") == 0) {
+      option->threshold = atof(value);
+      if ((option->threshold < 0.0) || (option->threshold >= 100.0)) {
+        return false;
+      }
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+std::wstring ToWide(const std::string& text) {
+  // The multi byte names of the locale are converted to the wide names.
+  const size_t size = mbstowcs(nullptr, text.c_str(), 0);
+  if (size == static_cast<size_t>(-1)) return std::wstring();
+  std::vector<wchar_t> buffer(size + 1);
+  mbstowcs(buffer.data(), text.c_str(), buffer.size());
+  return std::wstring(buffer.data());
+}
+bool IsSelected(const Option& option, const std::string& name) {
+  return option.filter.empty() ||
+    (name.find(option.filter) != std::string::npos);
+}
+std::string MakeSizeName(int size) {
+  char name[32];
+  snprintf(name, sizeof(name), "%dx%d", size, size);
+  return name;
+}
+  // The palette of the color number is 256 colors wide.
+Vector2n GetPaletteGrid(int color_num) {
+  const int width = (color_num < 256) ? color_num : 256;
+  return Vector2n(width, color_num / width);
+}
+  // The palette ids of the range grids are spread over the palette.
+void InitRange(int grid, int color_num, Range* range) {
+  range->Init(grid);
+  for (int grid_id = 0; grid_id < grid; ++grid_id) {
+    range->SetColorId(grid_id,
+        static_cast<int>(static_cast<int64_t>(grid_id) * color_num / grid));
+  }
+}
+
+class Bench {
+ public:
+  explicit Bench(const Option& option) : option_(option) { }
+
+  // The body is repeated at least once until the minimum time, the
+  // fastest run is taken. False is returned when the body fails.
+  bool Run(
+      const std::string& name,
+      const char* unit,
+      int64_t items,
+      const std::function<bool()>& body) {
+    if (!IsSelected(option_, name)) return true;
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point start = Clock::now();
+    double best = 0.0;
+    int iterations = 0;
+    for (;;) {
+      const Clock::time_point begin = Clock::now();
+      if (!body()) {
+        fprintf(stderr, "Failed %s\n", name.c_str());
+        return false;
+      }
+      const Clock::time_point end = Clock::now();
+      const double seconds = std::chrono::duration<double>(end - begin).count();
+      if ((iterations == 0) || (seconds < best)) best = seconds;
+      ++iterations;
+      if (std::chrono::duration<double>(end - start).count() >=
+          option_.min_time) {
+        break;
+      }
+    }
+    Result result;
+    result.name = name;
+    result.unit = unit;
+    result.items = items;
+    result.iterations = iterations;
+    result.seconds = best;
+    result.items_per_second = (best > 0.0) ? (items / best) : 0.0;
+    printf("%-52s %14.0f %s/s %6d runs\n", name.c_str(),
+        result.items_per_second, unit, iterations);
+    fflush(stdout);
+    results_.push_back(result);
+    return true;
+  }
+  const std::vector<Result>& GetResults() const {
+    return results_;
+  }
+
+ private:
+  const Option& option_;
+  std::vector<Result> results_;
+};
+
+  // The random colors are saved as the text and the binary palettes.
+bool MakePaletteFiles(
+    const std::string& text_file,
+    const std::string& binary_file,
+    int color_num) {
+  PixelRandom random;
+  random.Seed(static_cast<uint32_t>(color_num));
+  std::vector<uint32_t> colors(color_num);
+  random.Fill(0, colors.data(), color_num);
+  FILE* fp = OpenFile(ToWide(text_file).c_str(), L"w");
+  if (fp == nullptr) return false;
+  for (int color_id = 0; color_id < color_num; ++color_id) {
+    colors[color_id] &= 0x00ffffff;
+    const RGBVecotr color = UnpackColor(colors[color_id]);
+    fprintf(fp, "%d, %d, %d,\n", color.r, color.g, color.b);
+  }
+  if (fclose(fp) != 0) return false;
+  return SavePaletteBinary(
+      ToWide(binary_file).c_str(), colors.data(), color_num);
+}
+bool BenchPalette(const Option& option, Bench* bench) {
+  const std::string text_file = option.temp_dir + "/color01_bench.txt";
+  const std::string binary_file = option.temp_dir + "/color01_bench.pal";
+  for (size_t i = 0; i < option.color_nums.size(); ++i) {
+    const int color_num = option.color_nums[i];
+    if (!MakePaletteFiles(text_file, binary_file, color_num)) return false;
+    Palette palette;
+    palette.Init(GetPaletteGrid(color_num));
+    const std::wstring text = ToWide(text_file);
+    const std::wstring binary = ToWide(binary_file);
+    const std::string suffix = "/colors" + std::to_string(color_num);
+    bool result = bench->Run("palette/text" + suffix, "color", color_num,
+        [&]() { return palette.LoadColor(text.c_str()); });
+    result = result && bench->Run("palette/binary" + suffix, "color",
+        color_num, [&]() { return palette.LoadColor(binary.c_str()); });
+    if (!result) return false;
+  }
+  remove(text_file.c_str());
+  remove(binary_file.c_str());
+  return true;
+}
+bool BenchGenerate(const Option& option, ThreadPool* pool, Bench* bench) {
+  // The noise case fills the color storage from the gradient noise.
+  const CANVAS_STORAGE kStorages[] = {
+    CANVAS_STORAGE_COLOR_ID,
+    CANVAS_STORAGE_BUCKET_ID,
+    CANVAS_STORAGE_COLOR_ID,
+  };
+  const NOISE_TYPE kNoiseTypes[] = {NOISE_NONE, NOISE_NONE, NOISE_GRADIENT};
+  const char* kStorageNames[] = {"color", "bucket", "noise"};
+  for (int s = 0; s < 3; ++s) {
+    for (size_t i = 0; i < option.sizes.size(); ++i) {
+      // The canvas is made only for the selected cases.
+      const int size = option.sizes[i];
+      std::vector<std::string> names;
+      bool selected = false;
+      for (size_t j = 0; j < option.grids.size(); ++j) {
+        for (size_t k = 0; k < option.color_nums.size(); ++k) {
+          names.push_back(std::string("generate/") +
+            kStorageNames[s] + "/" + MakeSizeName(size) +
+            "/grid" + std::to_string(option.grids[j]) +
+            "/colors" + std::to_string(option.color_nums[k]));
+          selected = selected || IsSelected(option, names.back());
+        }
+      }
+      if (!selected) continue;
+      Canvas canvas;
+      canvas.Init(Vector2n(size, size), kStorages[s]);
+      canvas.SetThreadPool(pool);
+      Noise noise;
+      noise.type = kNoiseTypes[s];
+      canvas.SetNoise(noise);
+      for (size_t j = 0; j < option.grids.size(); ++j) {
+        for (size_t k = 0; k < option.color_nums.size(); ++k) {
+          const int color_num = option.color_nums[k];
+          Palette palette;
+          palette.Init(GetPaletteGrid(color_num));
+          Range range;
+          InitRange(option.grids[j], color_num, &range);
+          const std::string& name = names[j * option.color_nums.size() + k];
+          uint32_t seed = 0;
+          if (!bench->Run(name, "pixel", static_cast<int64_t>(size) * size,
+              [&]() {
+                canvas.Update(palette, range, seed++);
+                return true;
+              })) {
+            return false;
+          }
+        }
+      }
+    }
+  }
+  return true;
+}
+bool BenchRender(const Option& option, ThreadPool* pool, Bench* bench) {
+  // The cells of the whole canvas are drawn into the preview. The canvas
+  // larger than the preview is drawn from the preview level, the rebuild
+  // case changes the palette every run so the levels are built again.
+  Palette palette;
+  palette.Init(GetPaletteGrid(BENCH_EXPORT_COLORS));
+  Palette other_palette;
+  other_palette.Init(GetPaletteGrid(BENCH_EXPORT_COLORS));
+  std::vector<uint32_t> colors(BENCH_EXPORT_COLORS);
+  for (int i = 0; i < BENCH_EXPORT_COLORS; ++i) {
+    colors[i] = palette.GetPackedColors()[i] ^ 0x010101;
+  }
+  other_palette.SetColors(colors.data(), BENCH_EXPORT_COLORS);
+  Range range;
+  InitRange(BENCH_EXPORT_GRID, BENCH_EXPORT_COLORS, &range);
+  for (size_t i = 0; i < option.sizes.size(); ++i) {
+    const int size = option.sizes[i];
+    const std::string name = "render/" + MakeSizeName(size);
+    const std::string rebuild_name = "render/rebuild/" + MakeSizeName(size);
+    if (!IsSelected(option, name) && !IsSelected(option, rebuild_name)) {
+      continue;
+    }
+    Canvas canvas;
+    canvas.Init(Vector2n(size, size));
+    canvas.SetThreadPool(pool);
+    canvas.SetSize(Vector2n(BENCH_PREVIEW_SIZE, BENCH_PREVIEW_SIZE));
+    canvas.Update(palette, range, 0);
+    canvas.Render(palette);
+    if (!bench->Run(name, "pixel", static_cast<int64_t>(size) * size, [&]() {
+          canvas.Invalidate();
+          canvas.Render(palette);
+          return true;
+        })) {
+      return false;
+    }
+    int run = 0;
+    if (!bench->Run(rebuild_name, "pixel", static_cast<int64_t>(size) * size,
+        [&]() {
+          canvas.Invalidate();
+          canvas.Render(((run++ % 2) == 0) ? other_palette : palette);
+          return true;
+        })) {
+      return false;
+    }
+  }
+  return true;
+}
+bool BenchExport(const Option& option, ThreadPool* pool, Bench* bench) {
+  Palette palette;
+  palette.Init(GetPaletteGrid(BENCH_EXPORT_COLORS));
+  Range range;
+  InitRange(BENCH_EXPORT_GRID, BENCH_EXPORT_COLORS, &range);
+  const std::string file = option.temp_dir + "/color01_bench.out";
+  const std::wstring wide_file = ToWide(file);
+  const wchar_t* file_name = wide_file.c_str();
+
+  // The PNG is measured at the fastest level.
+  PngOption png_option;
+  png_option.level = 1;
+  typedef std::function<bool(const Canvas&)> Writer;
+  const std::vector<std::pair<std::string, Writer> > writers = {
+    {"bmp8", [&](const Canvas& canvas) {
+      return ExportBitmapWin8(file_name, canvas, palette);
+    }},
+    {"bmp8rle", [&](const Canvas& canvas) {
+      return ExportBitmapWin8Rle(file_name, canvas, palette);
+    }},
+    {"bmp24", [&](const Canvas& canvas) {
+      return ExportBitmapWin24(file_name, canvas, palette);
+    }},
+    {"bmp32", [&](const Canvas& canvas) {
+      return ExportBitmapWin32(file_name, canvas, palette);
+    }},
+    {"png8-level1", [&](const Canvas& canvas) {
+      return ExportPng8(file_name, canvas, palette, png_option, pool);
+    }},
+    {"png24-level1", [&](const Canvas& canvas) {
+      return ExportPng24(file_name, canvas, palette, png_option, pool);
+    }},
+  };
+  for (size_t i = 0; i < option.sizes.size(); ++i) {
+    const int size = option.sizes[i];
+    const int64_t pixel_num = static_cast<int64_t>(size) * size;
+    const std::string size_name = MakeSizeName(size);
+    bool selected = IsSelected(option, "export/create8/" + size_name) ||
+      IsSelected(option, "export/create24/" + size_name);
+    for (size_t j = 0; j < writers.size(); ++j) {
+      selected = selected ||
+        IsSelected(option, "export/" + writers[j].first + "/" + size_name);
+    }
+    if (!selected) continue;
+    Canvas canvas;
+    canvas.Init(Vector2n(size, size));
+    canvas.SetThreadPool(pool);
+    canvas.Update(palette, range, 0);
+    for (size_t j = 0; j < writers.size(); ++j) {
+      const Writer& writer = writers[j].second;
+      if (!bench->Run("export/" + writers[j].first + "/" + size_name, "pixel",
+          pixel_num, [&]() { return writer(canvas); })) {
+        return false;
+      }
+    }
+
+    // The legacy writers take the whole image in the arrays.
+    if (pixel_num > BENCH_ARRAY_PIXELS) continue;
+    std::vector<uint8_t> color_ids(pixel_num);
+    std::vector<RGBVecotr> pixels(pixel_num);
+    std::vector<RGBVecotr> colors(BENCH_EXPORT_COLORS);
+    for (int color_id = 0; color_id < BENCH_EXPORT_COLORS; ++color_id) {
+      colors[color_id] = palette.GetColor(color_id);
+    }
+    for (int y = 0; y < size; ++y) {
+      uint8_t* row = &color_ids[static_cast<size_t>(y) * size];
+      canvas.GetColorRow(y, row);
+      for (int x = 0; x < size; ++x) {
+        pixels[static_cast<size_t>(y) * size + x] = colors[row[x]];
+      }
+    }
+    const int array_size = static_cast<int>(pixel_num);
+    bool result = bench->Run("export/create8/" + size_name, "pixel",
+        pixel_num, [&]() {
+          return CreateBitmapWin8(file_name, size, size, colors.data(),
+              BENCH_EXPORT_COLORS, color_ids.data(), array_size);
+        });
+    result = result && bench->Run("export/create24/" + size_name, "pixel",
+        pixel_num, [&]() {
+          return CreateBitmapWin24(
+              file_name, size, size, pixels.data(), array_size);
+        });
+    if (!result) return false;
+  }
+  remove(file.c_str());
+  return true;
+}
+bool BenchRemap(const Option& option, ThreadPool* pool, Bench* bench) {
+  // The random palette, the colors are also the truecolor image.
+  PixelRandom random;
+  random.Seed(BENCH_EXPORT_COLORS);
+  std::vector<uint32_t> colors(BENCH_EXPORT_COLORS);
+  random.Fill(0, colors.data(), BENCH_EXPORT_COLORS);
+  Palette palette;
+  palette.Init(GetPaletteGrid(BENCH_EXPORT_COLORS));
+  palette.SetColors(colors.data(), BENCH_EXPORT_COLORS);
+  Remapper remapper;
+  if (!bench->Run("remap/table", "palette", 1, [&]() {
+        remapper.Init(palette, pool);
+        return true;
+      })) {
+    return false;
+  }
+  remapper.Init(palette, pool);
+
+  // The image is the gradient with the noise, like a photograph. The whole
+  // image is held in the memory as the legacy writers.
+  for (size_t i = 0; i < option.sizes.size(); ++i) {
+    const int size = option.sizes[i];
+    const int64_t pixel_num = static_cast<int64_t>(size) * size;
+    const std::string size_name = MakeSizeName(size);
+    if (!IsSelected(option, "remap/nearest/" + size_name) &&
+        !IsSelected(option, "remap/dither/" + size_name)) {
+      continue;
+    }
+    if (pixel_num > BENCH_ARRAY_PIXELS) continue;
+    std::vector<uint32_t> pixels(pixel_num);
+    for (int y = 0; y < size; ++y) {
+      uint32_t* row = &pixels[static_cast<size_t>(y) * size];
+      random.Fill(static_cast<uint64_t>(y) * size, row, size);
+      for (int x = 0; x < size; ++x) {
+        const uint32_t r = static_cast<uint32_t>(x * 255 / size);
+        const uint32_t g = static_cast<uint32_t>(y * 255 / size);
+        row[x] = ((r << 16) | (g << 8) | (255 - r)) ^ (row[x] & 0x0F0F0F);
+      }
+    }
+    std::vector<uint8_t> color_ids(pixel_num);
+    const Vector2n pixel(size, size);
+    bool result = bench->Run("remap/nearest/" + size_name, "pixel",
+        pixel_num, [&]() {
+          remapper.MapImage(
+              pixel, pixels.data(), false, pool, color_ids.data());
+          return true;
+        });
+    result = result && bench->Run("remap/dither/" + size_name, "pixel",
+        pixel_num, [&]() {
+          remapper.MapImage(
+              pixel, pixels.data(), true, pool, color_ids.data());
+          return true;
+        });
+    if (!result) return false;
+  }
+  return true;
+}
+bool BenchWorker(const Option& option, ThreadPool* pool, Bench* bench) {
+  // The burst of the requests makes one canvas of the last request, the
+  // time is until it is presented.
+  Palette palette;
+  palette.Init(GetPaletteGrid(BENCH_EXPORT_COLORS));
+  Range range;
+  InitRange(BENCH_EXPORT_GRID, BENCH_EXPORT_COLORS, &range);
+  for (size_t i = 0; i < option.sizes.size(); ++i) {
+    const int size = option.sizes[i];
+    const std::string name = "worker/burst/" + MakeSizeName(size);
+    if (!IsSelected(option, name)) continue;
+    Canvas canvas;
+    canvas.Init(Vector2n(size, size), CANVAS_STORAGE_COLOR_ID);
+    std::mutex mutex;
+    std::condition_variable ready;
+    int notified = 0;
+    GenerateWorker worker;
+    worker.Start(canvas, pool->GetThreadNum(), [&]() {
+      std::lock_guard<std::mutex> lock(mutex);
+      ++notified;
+      ready.notify_all();
+    });
+    uint32_t seed = 0;
+    uint32_t last_seed = 0;
+    if (!bench->Run(name, "pixel", static_cast<int64_t>(size) * size,
+        [&]() {
+          for (int j = 0; j < BENCH_WORKER_BURST; ++j) {
+            last_seed = seed++;
+            worker.Request(palette, range, last_seed);
+          }
+          // The canvas of the earlier request may be ready before the
+          // later request, it is presented and the next one is waited.
+          uint32_t presented = 0;
+          do {
+            std::unique_lock<std::mutex> lock(mutex);
+            ready.wait(lock, [&]() { return notified > 0; });
+            notified = 0;
+            lock.unlock();
+            if (!worker.Present(&canvas, &presented)) presented = ~last_seed;
+          } while (presented != last_seed);
+          return true;
+        })) {
+      return false;
+    }
+    worker.Stop();
+
+    // The presented canvas must be the same as drawn directly.
+    Canvas expected;
+    expected.Init(Vector2n(size, size), CANVAS_STORAGE_COLOR_ID);
+    expected.SetThreadPool(pool);
+    expected.Update(palette, range, last_seed);
+    std::vector<uint16_t> row(size);
+    std::vector<uint16_t> expected_row(size);
+    for (int y = 0; y < size; ++y) {
+      canvas.GetColorRow(y, row.data());
+      expected.GetColorRow(y, expected_row.data());
+      if (row != expected_row) {
+        fprintf(stderr, "%s: the presented canvas differs at row %d\n",
+            name.c_str(), y);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+bool WriteJson(const Option& option, const std::vector<Result>& results) {
+  FILE* fp = OpenFile(ToWide(option.json_file).c_str(), L"w");
+  if (fp == nullptr) return false;
+  fprintf(fp, "{\n");
+  fprintf(fp, "  \"threads\": %d,\n", option.thread_num);
+  fprintf(fp, "  \"avx2\": %s,\n", CpuHasAvx2() ? "true" : "false");
+  fprintf(fp, "  \"min_time\": %g,\n", option.min_time);
+  fprintf(fp, "  \"results\": [\n");
+  for (size_t i = 0; i < results.size(); ++i) {
+    const Result& result = results[i];
+    fprintf(fp,
+        "    {\"name\": \"%s\", \"unit\": \"%s\", \"items\": %lld, "
+        "\"iterations\": %d, \"seconds\": %.9f, "
+        "\"items_per_second\": %.1f}%s\n",
+        result.name.c_str(),
+        result.unit.c_str(),
+        static_cast<long long>(result.items),
+        result.iterations,
+        result.seconds,
+        result.items_per_second,
+        (i + 1 < results.size()) ? "," : "");
+  }
+  fprintf(fp, "  ]\n");
+  fprintf(fp, "}\n");
+  return fclose(fp) == 0;
+}
+  // The baseline is the JSON written by this program, the names and the
+  // rates of the results are picked up.
+bool LoadBaseline(
+    const std::string& file_name,
+    std::map<std::string, double>* rates) {
+  std::vector<uint8_t> data;
+  if (!LoadFile(ToWide(file_name).c_str(), &data)) return false;
+  const std::string text(data.begin(), data.end());
+  const std::string kName = "\"name\": \"";
+  const std::string kRate = "\"items_per_second\": ";
+  size_t p = text.find(kName);
+  while (p != std::string::npos) {
+    const size_t name_begin = p + kName.size();
+    const size_t name_end = text.find('"', name_begin);
+    const size_t rate = text.find(kRate, name_end);
+    if ((name_end == std::string::npos) || (rate == std::string::npos)) {
+      return false;
+    }
+    (*rates)[text.substr(name_begin, name_end - name_begin)] =
+      strtod(text.c_str() + rate + kRate.size(), nullptr);
+    p = text.find(kName, rate);
+  }
+  return true;
+}
+  // The number of the cases slower than the baseline by the threshold.
+int Compare(
+    const Option& option,
+    const std::vector<Result>& results,
+    const std::map<std::string, double>& rates) {
+  int regression_num = 0;
+  printf("\n%-52s %8s\n", "compared with the baseline", "change");
+  for (size_t i = 0; i < results.size(); ++i) {
+    const Result& result = results[i];
+    const auto it = rates.find(result.name);
+    if ((it == rates.end()) || (it->second <= 0.0)) continue;
+    const double change =
+      (result.items_per_second / it->second - 1.0) * 100.0;
+    const bool regression = (change < -option.threshold);
+    if (regression) ++regression_num;
+    printf("%-52s %+7.1f%%%s\n", result.name.c_str(), change,
+        regression ? "  REGRESSION" : "");
+  }
+  printf("%d regressions over %.1f%%\n", regression_num, option.threshold);
+  return regression_num;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  setlocale(LC_ALL, "");
+
+  Option option;
+  if (!ParseOption(argc, argv, &option)) {
+    PrintUsage();
+    return 1;
+  }
+
+  // The baseline is read first, not to find it broken after the run.
+  std::map<std::string, double> rates;
+  if (!option.baseline_file.empty() &&
+      !LoadBaseline(option.baseline_file, &rates)) {
+    fprintf(stderr, "Failed to read %s\n", option.baseline_file.c_str());
+    return 1;
+  }
+
+  // The cases are run in the order of the pipeline.
+  ThreadPool pool;
+  pool.Create(option.thread_num);
+  Bench bench(option);
+  if (!BenchPalette(option, &bench) ||
+      !BenchGenerate(option, &pool, &bench) ||
+      !BenchRender(option, &pool, &bench) ||
+      !BenchExport(option, &pool, &bench) ||
+      !BenchRemap(option, &pool, &bench) ||
+      !BenchWorker(option, &pool, &bench)) {
+    return 1;
+  }
+  if (!option.json_file.empty() && !WriteJson(option, bench.GetResults())) {
+    fprintf(stderr, "Failed to create %s\n", option.json_file.c_str());
+    return 1;
+  }
+  if (!option.baseline_file.empty() &&
+      (Compare(option, bench.GetResults(), rates) > 0)) {
+    return 2;
+  }
+  return 0;
+}
@@ -0,0 +1,497 @@
+  // @file bitmap.cc
+  // @brief Bitmap file writers.
+  // @author Mamoru Kaminaga
+  // @date 2017-11-17
+  // Copyright 2017 Mamoru Kaminaga
+  // This program is provided with MIT license. See "LICENSE.md".
+#include <assert.h>
+#include <limits.h>
+#include <wchar.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <cmath>
+#include <vector>
+
+#include "./bitmap.h"
+#include "./cpu.h"
+#include "./trace.h"
+#include "./common.h"
+
+#ifdef CPU_X86
+#include <emmintrin.h>
+#endif
+
+  // The longest run and the longest absolute span of BI_RLE8.
+#define RLE8_MAX_COUNT (255)
+
+namespace {
+  // The number of the same values from the first value, up to num.
+int GetRunLength(const uint8_t* values, int num) {
+  const uint8_t value = values[0];
+  int i = 1;
+#ifdef CPU_X86
+  // The 16 values are compared at once, the run ends at the first mismatch.
+  const __m128i v = _mm_set1_epi8(static_cast<char>(value));
+  for (; i + 16 <= num; i += 16) {
+    const __m128i x =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(&values[i]));
+    const int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(x, v));
+    if (mask != 0xffff) {
+      int count = 0;
+      while (mask & (1 << count)) ++count;
+      return i + count;
+    }
+  }
+#endif
+  while ((i < num) && (values[i] == value)) ++i;
+  return i;
+}
+  // The number of the values before the first run of 3 values, up to num.
+int GetSpanLength(const uint8_t* values, int num) {
+  int i = 0;
+#ifdef CPU_X86
+  // The values are compared with the next 2 values at 16 places at once.
+  for (; i + 18 <= num; i += 16) {
+    const __m128i x0 =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(&values[i]));
+    const __m128i x1 =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(&values[i + 1]));
+    const __m128i x2 =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(&values[i + 2]));
+    const int mask = _mm_movemask_epi8(
+        _mm_and_si128(_mm_cmpeq_epi8(x0, x1), _mm_cmpeq_epi8(x0, x2)));
+    if (mask != 0) {
+      int count = 0;
+      while (!(mask & (1 << count))) ++count;
+      return i + count;
+    }
+  }
+#endif
+  for (; i + 2 < num; ++i) {
+    if ((values[i] == values[i + 1]) && (values[i] == values[i + 2])) {
+      return i;
+    }
+  }
+  return num;
+}
+}  // namespace
+
+void MakeBitmapHeader(
+    int width,
+    int height,
+    int bit_number,
+    int color_num,
+    uint8_t* bitmap_header) {
+  assert(bitmap_header);
+  memset(bitmap_header, 0, BITMAP_HEADER_SIZE);
+
+  // The file type.
+  bitmap_header[0] = 'B';
+  bitmap_header[1] = 'M';
+
+  // The file size, the 32 bit fields can not hold the huge images.
+  const int abs_height = (height < 0) ? -height : height;
+  const uint64_t image_size =
+    static_cast<uint64_t>(GetBitmapRowBytes(width, bit_number)) * abs_height;
+  uint32_t offset_to_image = BITMAP_HEADER_SIZE + color_num * 4;
+  uint64_t file_size = offset_to_image + image_size;
+  uint32_t file_size32 = (file_size <= UINT32_MAX) ?
+    static_cast<uint32_t>(file_size) : 0;
+  uint32_t image_size32 = (file_size <= UINT32_MAX) ?
+    static_cast<uint32_t>(image_size) : 0;
+  memcpy(&bitmap_header[2], &file_size32, 4);
+
+  // The offset.
+  memcpy(&bitmap_header[10], &offset_to_image, 4);
+
+  // The info header size.
+  uint32_t info_header_size = BITMAP_INFO_HEADER_SIZE;
+  memcpy(&bitmap_header[14], &info_header_size, 4);
+
+  // The image width and height, the negative height is top-down.
+  memcpy(&bitmap_header[18], &width, 4);
+  memcpy(&bitmap_header[22], &height, 4);
+
+  // The number of planes.
+  uint16_t plane_num = 1;
+  memcpy(&bitmap_header[26], &plane_num, 2);
+
+  // The bit number.
+  uint16_t bit_number16 = static_cast<uint16_t>(bit_number);
+  memcpy(&bitmap_header[28], &bit_number16, 2);
+
+  // The number of bytes of the image.
+  memcpy(&bitmap_header[34], &image_size32, 4);
+
+  // The used color num in palette.
+  uint32_t used_color_num = color_num;
+  memcpy(&bitmap_header[46], &used_color_num, 4);
+}
+void MakeBitmapColorTable(
+    const RGBVecotr* colors,
+    int color_num,
+    uint8_t* color_table) {
+  assert((color_num == 0) || colors);
+  assert((color_num == 0) || color_table);
+  for (int index = 0; index < color_num; ++index) {
+    color_table[index * 4] = static_cast<uint8_t>(colors[index].b);
+    color_table[index * 4 + 1] = static_cast<uint8_t>(colors[index].g);
+    color_table[index * 4 + 2] = static_cast<uint8_t>(colors[index].r);
+    color_table[index * 4 + 3] = 0;  // Reserved.
+  }
+}
+void MakeBitmapColorTable(
+    const uint32_t* colors,
+    int color_num,
+    uint8_t* color_table) {
+  assert((color_num == 0) || colors);
+  assert((color_num == 0) || color_table);
+  if (color_num > 0) memcpy(color_table, colors, color_num * 4);
+}
+int GetBitmapRowBytes(int width, int bit_number) {
+  return ((width * bit_number + 31) / 32) * 4;
+}
+void EncodeRle8Row(
+    const uint8_t* row,
+    int width,
+    bool last,
+    std::vector<uint8_t>* output) {
+  assert(row);
+  assert(output);
+
+  // Every code takes 2 bytes for 1 value at most, the absolute span of n
+  // values takes n + 3 bytes at most.
+  const size_t begin = output->size();
+  output->resize(begin + static_cast<size_t>(width) * 2 + 2);
+  uint8_t* out = &(*output)[begin];
+  int x = 0;
+  while (x < width) {
+    // The run of 3 or more values is encoded as the count and the value.
+    const int rest = (width - x < RLE8_MAX_COUNT) ? (width - x) :
+      RLE8_MAX_COUNT;
+    const int run = GetRunLength(&row[x], rest);
+    if (run >= 3) {
+      *out++ = static_cast<uint8_t>(run);
+      *out++ = row[x];
+      x += run;
+      continue;
+    }
+
+    // The values until the next run of 3 are the absolute span.
+    const int span = run + GetSpanLength(&row[x + run], rest - run);
+    const int end = x + span;
+    if (span >= 3) {
+      // The absolute span is padded to the 16 bit boundary.
+      *out++ = 0;
+      *out++ = static_cast<uint8_t>(span);
+      memcpy(out, &row[x], span);
+      out += span;
+      if (span & 1) *out++ = 0;
+    } else {
+      // The absolute span needs 3 values at least, the short span is
+      // encoded as the runs of 1 or 2 values.
+      for (int i = x; i < end; ++i) {
+        const int count = ((i + 1 < end) && (row[i] == row[i + 1])) ? 2 : 1;
+        *out++ = static_cast<uint8_t>(count);
+        *out++ = row[i];
+        i += count - 1;
+      }
+    }
+    x = end;
+  }
+
+  // The end of line, or the end of bitmap after the last row.
+  *out++ = 0;
+  *out++ = last ? 1 : 0;
+  output->resize(out - output->data());
+}
+BitmapWriter::BitmapWriter()
+  : fp_(nullptr),
+    compression_(BITMAP_COMPRESSION_NONE),
+    image_offset_(0),
+    image_bytes_(0),
+    row_bytes_(0),
+    pixel_bytes_(0),
+    height_(0),
+    row_num_(0),
+    error_(false) { }
+BitmapWriter::~BitmapWriter() {
+  Close();
+}
+
+bool BitmapWriter::Open(
+    const wchar_t* file_name,
+    int width,
+    int height,
+    int bit_number,
+    const RGBVecotr* colors,
+    int color_num) {
+  assert((color_num == 0) || colors);
+  std::vector<uint32_t> packed_colors(color_num);
+  for (int index = 0; index < color_num; ++index) {
+    packed_colors[index] = PackColor(colors[index]);
+  }
+  return Open(
+      file_name, width, height, bit_number, packed_colors.data(), color_num);
+}
+bool BitmapWriter::Open(
+    const wchar_t* file_name,
+    int width,
+    int height,
+    int bit_number,
+    const uint32_t* colors,
+    int color_num) {
+  return Open(file_name, width, height, bit_number, colors, color_num,
+      BITMAP_COMPRESSION_NONE);
+}
+bool BitmapWriter::Open(
+    const wchar_t* file_name,
+    int width,
+    int height,
+    int bit_number,
+    const uint32_t* colors,
+    int color_num,
+    BITMAP_COMPRESSION compression) {
+  assert(file_name);
+  assert((bit_number == 8) || (bit_number == 24) || (bit_number == 32));
+  assert((color_num == 0) || colors);
+  assert((compression == BITMAP_COMPRESSION_NONE) ||
+      ((bit_number == 8) && (height > 0)));
+
+  // The headers and the color table are written first. The sizes of the
+  // compressed image are written again when the file is closed.
+  uint8_t bitmap_header[BITMAP_HEADER_SIZE];
+  MakeBitmapHeader(width, height, bit_number, color_num, bitmap_header);
+  uint32_t compression32 = compression;
+  memcpy(&bitmap_header[30], &compression32, 4);
+  std::vector<uint8_t> palette(color_num * 4);
+  MakeBitmapColorTable(colors, color_num, palette.data());
+
+  // The file is written in binary mode.
+  fp_ = OpenFile(file_name, L"wb");
+  if (fp_ == nullptr) return false;
+  row_bytes_ = GetBitmapRowBytes(width, bit_number);
+  pixel_bytes_ = width * (bit_number / 8);
+  height_ = (height < 0) ? -height : height;
+  row_num_ = 0;
+  compression_ = compression;
+  image_offset_ = BITMAP_HEADER_SIZE + color_num * 4;
+  image_bytes_ = 0;
+  error_ = false;
+  if (fwrite(bitmap_header, BITMAP_HEADER_SIZE, 1, fp_) != 1) error_ = true;
+  if (color_num > 0) {
+    if (fwrite(palette.data(), palette.size(), 1, fp_) != 1) error_ = true;
+  }
+  return !error_;
+}
+bool BitmapWriter::WriteRow(const uint8_t* row) {
+  assert(fp_);
+  assert(row);
+  assert(row_num_ < height_);
+  if (compression_ == BITMAP_COMPRESSION_RLE8) {
+    // The encoded row is written, pixel_bytes_ is the width of 8 bit rows.
+    encoded_.clear();
+    EncodeRle8Row(row, pixel_bytes_, row_num_ == height_ - 1, &encoded_);
+    if (fwrite(encoded_.data(), encoded_.size(), 1, fp_) != 1) error_ = true;
+    image_bytes_ += encoded_.size();
+    ++row_num_;
+    return !error_;
+  }
+
+  // The row is padded to multiple of 4.
+  const uint8_t padding[4] = {0};
+  if (fwrite(row, pixel_bytes_, 1, fp_) != 1) error_ = true;
+  if (row_bytes_ > pixel_bytes_) {
+    if (fwrite(padding, row_bytes_ - pixel_bytes_, 1, fp_) != 1) {
+      error_ = true;
+    }
+  }
+  ++row_num_;
+  return !error_;
+}
+bool BitmapWriter::Close() {
+  if (fp_ == nullptr) return false;
+  TRACE_COUNTER("BitmapWriter bytes",
+      static_cast<int64_t>((compression_ == BITMAP_COMPRESSION_RLE8) ?
+        image_bytes_ : static_cast<uint64_t>(row_bytes_) * row_num_));
+  if (compression_ == BITMAP_COMPRESSION_RLE8) {
+    // The file size and the image size of the compressed image.
+    const uint64_t file_size = image_offset_ + image_bytes_;
+    uint32_t file_size32 = (file_size <= UINT32_MAX) ?
+      static_cast<uint32_t>(file_size) : 0;
+    uint32_t image_size32 = (file_size <= UINT32_MAX) ?
+      static_cast<uint32_t>(image_bytes_) : 0;
+    if ((fseek(fp_, 2, SEEK_SET) != 0) ||
+        (fwrite(&file_size32, 4, 1, fp_) != 1) ||
+        (fseek(fp_, 34, SEEK_SET) != 0) ||
+        (fwrite(&image_size32, 4, 1, fp_) != 1)) {
+      error_ = true;
+    }
+  }
+  if (fclose(fp_) != 0) error_ = true;
+  fp_ = nullptr;
+
+  // All the rows must be written.
+  return !error_ && (row_num_ == height_);
+}
+
+bool CreateBitmapWin24(
+    const wchar_t* file_name,
+    int width,
+    int height,
+    const RGBVecotr* array,
+    int array_size) {
+  assert(file_name);
+  assert(array);
+  if (array_size < (width * height)) return false;
+
+  BitmapWriter writer;
+  const uint32_t* kNoColors = nullptr;
+  if (!writer.Open(file_name, width, height, 24, kNoColors, 0)) return false;
+
+  // Rows are created form RGB data array, from the bottom row.
+  std::vector<uint8_t> row(width * 3);
+  for (int i = height - 1; i >= 0; --i) {
+    const RGBVecotr* source = &array[i * width];
+    for (int j = 0; j < width; ++j) {
+      row[j * 3] = static_cast<uint8_t>(source[j].b);
+      row[j * 3 + 1] = static_cast<uint8_t>(source[j].g);
+      row[j * 3 + 2] = static_cast<uint8_t>(source[j].r);
+    }
+    if (!writer.WriteRow(row.data())) return false;
+  }
+  return writer.Close();
+}
+bool CreateBitmapWin8(
+    const wchar_t* file_name,
+    int width,
+    int height,
+    const RGBVecotr* colors,
+    int color_num,
+    const uint8_t* indeces,
+    int index_num) {
+  assert(file_name);
+  assert(indeces);
+
+  const int kPaletteColorNum = 256;
+  if (color_num != kPaletteColorNum) return false;
+  if (index_num < (width * height)) return false;
+
+  BitmapWriter writer;
+  if (!writer.Open(file_name, width, height, 8, colors, kPaletteColorNum)) {
+    return false;
+  }
+
+  // Canvas pixel color index, from the bottom row.
+  for (int i = height - 1; i >= 0; --i) {
+    if (!writer.WriteRow(&indeces[i * width])) return false;
+  }
+  return writer.Close();
+}
+bool LoadBitmapColors(
+    const wchar_t* file_name,
+    int sample_num,
+    Vector2n* pixel,
+    std::vector<uint32_t>* colors) {
+  assert(file_name);
+  assert(sample_num > 0);
+  assert(pixel);
+  assert(colors);
+  TRACE_SCOPE("LoadBitmapColors");
+  FILE* fp = OpenFile(file_name, L"rb");
+  if (fp == nullptr) return false;
+
+  // The headers are read, only BI_RGB is supported.
+  const int kPaletteColorNum = 256;
+  uint8_t header[BITMAP_HEADER_SIZE];
+  uint32_t offset_to_image = 0;
+  uint32_t info_header_size = 0;
+  int32_t width = 0;
+  int32_t height = 0;
+  uint16_t plane_num = 0;
+  uint16_t bit_number = 0;
+  uint32_t compression = 0;
+  uint32_t used_color_num = 0;
+  bool result = (fread(header, BITMAP_HEADER_SIZE, 1, fp) == 1) &&
+    (header[0] == 'B') && (header[1] == 'M');
+  if (result) {
+    memcpy(&offset_to_image, &header[10], 4);
+    memcpy(&info_header_size, &header[14], 4);
+    memcpy(&width, &header[18], 4);
+    memcpy(&height, &header[22], 4);
+    memcpy(&plane_num, &header[26], 2);
+    memcpy(&bit_number, &header[28], 2);
+    memcpy(&compression, &header[30], 4);
+    memcpy(&used_color_num, &header[46], 4);
+    result = (info_header_size >= BITMAP_INFO_HEADER_SIZE) &&
+      (width > 0) && (height != 0) && (height != INT32_MIN) &&
+      (plane_num == 1) && (compression == BITMAP_COMPRESSION_NONE) &&
+      ((bit_number == 8) || (bit_number == 24) || (bit_number == 32)) &&
+      (used_color_num <= static_cast<uint32_t>(kPaletteColorNum));
+  }
+
+  // The size of the rows is computed in 64 bits, the rows must be in the
+  // file. The broken header is not trusted for the allocation.
+  const bool top_down = (height < 0);
+  const int abs_height = top_down ? -height : height;
+  uint64_t row_bytes64 = 0;
+  if (result) {
+    row_bytes64 =
+      ((static_cast<uint64_t>(width) * bit_number + 31) / 32) * 4;
+    long file_size = -1;
+    if (fseek(fp, 0, SEEK_END) == 0) file_size = ftell(fp);
+    result = (row_bytes64 <= INT_MAX) && (file_size >= 0) &&
+      (offset_to_image + row_bytes64 * abs_height <=
+       static_cast<uint64_t>(file_size));
+  }
+
+  // The color table of the 8 bit bitmap follows the info header, the
+  // number of its colors is already checked.
+  std::vector<uint32_t> table;
+  if (result && (bit_number == 8)) {
+    const size_t table_num = (used_color_num == 0) ?
+      kPaletteColorNum : static_cast<size_t>(used_color_num);
+    std::vector<uint8_t> bgrx(table_num * 4);
+    result =
+      (fseek(fp, BITMAP_FILE_HEADER_SIZE + info_header_size, SEEK_SET) == 0) &&
+      (fread(bgrx.data(), bgrx.size(), 1, fp) == 1);
+    table.assign(kPaletteColorNum, 0);
+    for (size_t i = 0; result && (i < table_num); ++i) {
+      memcpy(&table[i], &bgrx[i * 4], 4);
+      table[i] &= 0x00FFFFFF;
+    }
+  }
+  if (!result || (fseek(fp, offset_to_image, SEEK_SET) != 0)) {
+    fclose(fp);
+    return false;
+  }
+
+  // The rows not read are skipped. The bottom-up rows are stored from the
+  // bottom row.
+  const double ratio = static_cast<double>(width) * abs_height / sample_num;
+  const int step = (ratio > 1.0) ?
+    static_cast<int>(std::ceil(std::sqrt(ratio))) : 1;
+  pixel->x = (width + step - 1) / step;
+  pixel->y = (abs_height + step - 1) / step;
+  colors->resize(static_cast<size_t>(pixel->x) * pixel->y);
+  const int row_bytes = static_cast<int>(row_bytes64);
+  const int pixel_bytes = bit_number / 8;
+  std::vector<uint8_t> row(row_bytes);
+  for (int i = 0; result && (i < abs_height); ++i) {
+    const int y = top_down ? i : (abs_height - 1 - i);
+    if (y % step != 0) {
+      result = (fseek(fp, row_bytes, SEEK_CUR) == 0);
+      continue;
+    }
+    result = (fread(row.data(), row_bytes, 1, fp) == 1);
+    uint32_t* output = &(*colors)[static_cast<size_t>(y / step) * pixel->x];
+    for (int x = 0; result && (x < pixel->x); ++x) {
+      const uint8_t* p = &row[x * step * pixel_bytes];
+      output[x] = (bit_number == 8) ? table[p[0]] :
+        (p[0] | (p[1] << 8) | (p[2] << 16));
+    }
+  }
+  if (fclose(fp) != 0) result = false;
+  return result;
+}
@@ -0,0 +1,131 @@
+  // @file bitmap.h
+  // @brief Bitmap file writers.
+  // @author Mamoru Kaminaga
+  // @date 2017-11-17
+  // Copyright 2017 Mamoru Kaminaga
+  // This program is provided with MIT license. See "LICENSE.md".
+#ifndef BITMAP_H_
+#define BITMAP_H_
+
+#include <wchar.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+
+#include "./common.h"
+
+#define BITMAP_FILE_HEADER_SIZE           (14)
+#define BITMAP_INFO_HEADER_SIZE           (40)
+#define BITMAP_HEADER_SIZE  (BITMAP_FILE_HEADER_SIZE + BITMAP_INFO_HEADER_SIZE)
+
+  // The compression of the 8 bit bitmap. The run length encoded bitmap is
+  // bottom-up and its size is known only after the last row.
+enum BITMAP_COMPRESSION {
+  BITMAP_COMPRESSION_NONE = 0,
+  BITMAP_COMPRESSION_RLE8 = 1,
+};
+
+  // The headers of the uncompressed bitmap with the color table.
+  // The size fields are 0 when the image is larger than 4 GB.
+void MakeBitmapHeader(
+    int width,
+    int height,
+    int bit_number,
+    int color_num,
+    uint8_t* bitmap_header);
+
+  // The color table of color_num * 4 bytes following the headers.
+  // The packed colors are already in the order of the table.
+void MakeBitmapColorTable(
+    const RGBVecotr* colors,
+    int color_num,
+    uint8_t* color_table);
+void MakeBitmapColorTable(
+    const uint32_t* colors,
+    int color_num,
+    uint8_t* color_table);
+
+  // The bytes of one row, padded to multiple of 4.
+int GetBitmapRowBytes(int width, int bit_number);
+
+  // The row of the color ids is encoded as the runs and the absolute
+  // spans of BI_RLE8, ended by the end of line or the end of bitmap.
+void EncodeRle8Row(
+    const uint8_t* row,
+    int width,
+    bool last,
+    std::vector<uint8_t>* output);
+
+  // The bitmap file is written row by row from the bottom row, so only
+  // one row of the image is kept in memory. The bit number is 8, 24 or 32,
+  // the 8 bit rows may be run length encoded.
+class BitmapWriter {
+ public:
+  BitmapWriter();
+  ~BitmapWriter();
+
+  bool Open(
+      const wchar_t* file_name,
+      int width,
+      int height,
+      int bit_number,
+      const RGBVecotr* colors,
+      int color_num);
+  bool Open(
+      const wchar_t* file_name,
+      int width,
+      int height,
+      int bit_number,
+      const uint32_t* colors,
+      int color_num);
+  bool Open(
+      const wchar_t* file_name,
+      int width,
+      int height,
+      int bit_number,
+      const uint32_t* colors,
+      int color_num,
+      BITMAP_COMPRESSION compression);
+  bool WriteRow(const uint8_t* row);
+  bool Close();
+
+ private:
+  FILE* fp_;
+  BITMAP_COMPRESSION compression_;
+  std::vector<uint8_t> encoded_;
+  uint32_t image_offset_;
+  uint64_t image_bytes_;
+  int row_bytes_;
+  int pixel_bytes_;
+  int height_;
+  int row_num_;
+  bool error_;
+};
+
+bool CreateBitmapWin24(
+    const wchar_t* file_name,
+    int width,
+    int height,
+    const RGBVecotr* array,
+    int array_size);
+
+bool CreateBitmapWin8(
+    const wchar_t* file_name,
+    int width,
+    int height,
+    const RGBVecotr* colors,
+    int color_num,
+    const uint8_t* indeces,
+    int index_num);
+
+  // The uncompressed 8, 24 or 32 bit bitmap is read as the packed colors,
+  // from the top row. Every step-th pixel of every step-th row is read,
+  // the step is chosen to read about sample_num pixels. The pixel is the
+  // size of the colors read.
+bool LoadBitmapColors(
+    const wchar_t* file_name,
+    int sample_num,
+    Vector2n* pixel,
+    std::vector<uint32_t>* colors);
+
+#endif  // BITMAP_H_
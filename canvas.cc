@@ -4,129 +4,344 @@
   // @date 2017-11-17
   // Copyright 2017 Mamoru Kaminaga
   // This program is provided with MIT license. See "LICENSE.md".
+#include <assert.h>
 #include <wchar.h>
-#include <windows.h>
-#include <cmath>
+#include <stdint.h>
+#include <mutex>
 #include <random>
+#include <utility>
 #include <vector>
 
 #include "./canvas.h"
+#include "./generator.h"
+#include "./noise.h"
 #include "./palette.h"
+#include "./preview_pyramid.h"
 #include "./range.h"
-#include "./utility.h"
+#include "./raster.h"
+#include "./thread_pool.h"
+#include "./trace.h"
+#include "./common.h"
 
-#include "./resource.h"
+  // The rows are generated in blocks of about this number of pixels.
+#define CANVAS_BLOCK_PIXELS (1 << 16)
 
-  // Fixed parameters for normal distribution used in this program.
-#define NORMAL_DIST_MUE     (0.0)
-#define NORMAL_DIST_SIGMA   (1.0)
-#define NORMAL_DIST_RANGE   (2.80)
+  // The spans are generated through the buffer of this number of pixels.
+#define CANVAS_CHUNK_PIXELS (1024)
 
-Canvas::Canvas() = default;
+  // The pixels are counted into this number of the histograms in turn, the
+  // same bucket of the next pixels does not wait for the last count.
+#define CANVAS_COUNT_LANES  (4)
 
-void Canvas::Create(
-      HWND hwnd,
-      const Vector2n& pixel,
-      const Palette& palette,
-      const Range& range) {
-  // The palette size and color vector is set.
+Canvas::Canvas()
+  : pool_(nullptr),
+    control_(nullptr),
+    storage_(CANVAS_STORAGE_COLOR_ID),
+    index_bits_(8),
+    preview_level_(-1) { }
+
+void Canvas::Init(const Vector2n& pixel) {
+  Init(pixel, CANVAS_STORAGE_COLOR_ID);
+}
+void Canvas::Init(const Vector2n& pixel, CANVAS_STORAGE storage) {
+  // The canvas size and pixel storage is set.
   pixel_ = pixel;
   pixel_num_ = pixel_.x * pixel_.y;
-  color_id_.resize(pixel_num_);
-
-  // Window handle and size is acquired.
-  HWND hwnd_canvas = GetDlgItem(hwnd, IDC_PIC_CANVAS);
-  RECT rc;
-  GetClientRect(hwnd_canvas, &rc);
-  size_.x = (rc.right - rc.left);
-  size_.y = (rc.bottom - rc.top);
-
-  // The off-screen draw buffer is created.
-  hdc_offscreen_ = CreateCompatibleDC(nullptr);
-  HDC hdc = GetDC(hwnd_canvas);
-  hdc_bitmap_ = CreateCompatibleBitmap(hdc, size_.x, size_.y);
-  ReleaseDC(hwnd_canvas, hdc);
-  SelectObject(hdc_offscreen_, hdc_bitmap_);
-
-  // The initial setup.
-  Update(palette, range);
-}
-void Canvas::Paint(HWND hwnd, const Palette& palette) {
-  // Window handle and size is acquired.
-  HWND hwnd_canvas = GetDlgItem(hwnd, IDC_PIC_CANVAS);
-
-  // The color cells are drawn to the off-screen buffer.
-  int x = 0;
-  int y = 0;
-  int x2 = 0;
-  int y2 = 0;
-  int pixel_id = 0;
-  for (int i = 0; i < pixel_.y; ++i) {
-    for (int j = 0; j < pixel_.x; ++j) {
-      // Draw target cell with tools.
-      x = static_cast<int>(size_.x * j / static_cast<double>(pixel_.x));
-      y = static_cast<int>(size_.y * i / static_cast<double>(pixel_.y));
-      x2 = static_cast<int>(size_.x * (j + 1) / static_cast<double>(pixel_.x));
-      y2 = static_cast<int>(size_.y * (i + 1) / static_cast<double>(pixel_.y));
-      SelectObject(hdc_offscreen_, palette.GetPen(color_id_[pixel_id]));
-      SelectObject(hdc_offscreen_, palette.GetBrush(color_id_[pixel_id]));
-      Rectangle(hdc_offscreen_, x, y, x2, y2);
-      // Target cell is changed.
-      ++pixel_id;
-    }
-  }
+  storage_ = storage;
+  index_bits_ = 8;
+  store_.Init(pixel_, (storage_ == CANVAS_STORAGE_COLOR_ID) ? 8 : 1);
+  grid_color_id_.assign(1, 0);
+  grid_wide_color_id_.assign(1, 0);
+  preview_.Init(pixel_);
+  preview_level_ = -1;
+}
+void Canvas::SetThreadPool(ThreadPool* pool) {
+  pool_ = pool;
+}
+void Canvas::SetJobControl(JobControl* control) {
+  control_ = control;
+}
+void Canvas::SetNoise(const Noise& noise) {
+  noise_ = noise;
+}
+void Canvas::SetSize(const Vector2n& size) {
+  // The frame buffer has one cell per canvas pixel, or per pixel of the
+  // preview level which fits in it when the canvas is larger.
+  SetPreviewSize(size);
+  raster_.Init(size_);
+  raster_.SetGrid((preview_level_ < 0) ?
+      pixel_ : preview_.GetLevelSize(preview_level_));
+}
+void Canvas::SetPreviewSize(const Vector2n& size) {
+  // The canvas without the preview or fitting in it has no level.
+  size_ = size;
+  const bool fit = (pixel_.x <= size_.x) && (pixel_.y <= size_.y);
+  const bool empty = (size_.x <= 0) || (size_.y <= 0);
+  preview_level_ = (fit || empty) ? -1 : preview_.FindLevel(size_);
+}
+Vector2n Canvas::GetSize() const {
+  return size_;
+}
 
-  // Flip screen.
-  HDC hdc = GetDC(hwnd_canvas);
-  BitBlt(hdc, 0, 0, size_.x, size_.y, hdc_offscreen_, 0, 0, SRCCOPY);
-  ReleaseDC(hwnd_canvas, hdc);
+void Canvas::Update(const Palette& palette, const Range& range) {
+  // The seed is taken from the non-deterministic source.
+  std::random_device seed_gen;
+  Update(palette, range, seed_gen());
+}
+void Canvas::Update(
+    const Palette& palette,
+    const Range& range,
+    uint32_t seed) {
+  UpdateRegion(palette, range, seed, Rect2n(0, 0, pixel_.x, pixel_.y));
 }
-void Canvas::Destroy(HWND hwnd) {
-  // The off-screen draw buffer is released.
-  if (hdc_offscreen_) {
-    DeleteDC(hdc_offscreen_);
-    hdc_offscreen_ = nullptr;
+void Canvas::UpdateRegion(
+    const Palette& palette,
+    const Range& range,
+    uint32_t seed,
+    const Rect2n& region) {
+  UpdateRegions(palette, range, seed, std::vector<Rect2n>(1, region));
+}
+void Canvas::UpdateRegions(
+    const Palette& palette,
+    const Range& range,
+    uint32_t seed,
+    const std::vector<Rect2n>& regions) {
+  TRACE_SCOPE("Canvas::Update");
+
+  // The generator is shared by all the regions.
+  Generator generator;
+  generator.Init(range, seed, pixel_, noise_);
+
+  // The color ids of more than 256 colors are 16 bits. The color storage
+  // is cleared when the width changes.
+  const bool bucket = (storage_ == CANVAS_STORAGE_BUCKET_ID);
+  const int index_bits = (palette.GetColorNum() > 256) ? 16 : 8;
+  if (index_bits != index_bits_) {
+    index_bits_ = index_bits;
+    if (!bucket) store_.Init(pixel_, index_bits_);
+    raster_.Invalidate();
+    preview_.Invalidate();
   }
-  if (hdc_bitmap_) {
-    DeleteObject(hdc_bitmap_);
-    hdc_bitmap_ = nullptr;
+
+  // The bucket storage is resized to the grid and remembers the colors.
+  if (bucket) {
+    const int bits = PixelStore::GetBitsFor(range.GetGrid());
+    if (bits != store_.GetBits()) store_.Init(pixel_, bits);
+    grid_color_id_.resize(range.GetGrid());
+    grid_wide_color_id_.resize(range.GetGrid());
+    for (int grid_id = 0; grid_id < range.GetGrid(); ++grid_id) {
+      const int color_id = range.GetColorId(grid_id);
+      grid_color_id_[grid_id] = static_cast<uint8_t>(color_id);
+      grid_wide_color_id_[grid_id] = static_cast<uint16_t>(color_id);
+    }
   }
 
-  // Warnings are prevented for non-used parameters.
-  UNREFERENCED_PARAMETER(hwnd);
-}
+  // The pixels of every bucket are counted by the blocks and merged, the
+  // colors are counted by the buckets at the end.
+  const int grid = range.GetGrid();
+  std::vector<int> bucket_color_ids(grid);
+  for (int grid_id = 0; grid_id < grid; ++grid_id) {
+    bucket_color_ids[grid_id] = range.GetColorId(grid_id);
+  }
+  bucket_counts_.assign(grid, 0);
+  std::mutex counts_mutex;
 
-void Canvas::Update(const Palette& palette, const Range& range) {
-  // Grid of palette and range is acquired.
-  int range_grid = range.GetGrid();
-  Vector2n pallet_grids = palette.GetGrid();
-  const int color_num = pallet_grids.x * pallet_grids.y;
-
-  // Colors are distributed according to the normal distribution.
-  const double delta = NORMAL_DIST_RANGE /
-    static_cast<double>(range_grid);
-  std::random_device seed_gen;
-  std::default_random_engine engine(seed_gen());
-  std::normal_distribution<> dist(NORMAL_DIST_MUE, NORMAL_DIST_SIGMA);
-
-  double result = 0.0;
-  bool exit = false;
-  for (int pixel_id = 0; pixel_id < pixel_num_; ++pixel_id) {
-    exit = false;
-    color_id_[pixel_id] = 0;
-    result = dist(engine);
-    color_id_[pixel_id] = range.GetColorId(range_grid - 1);
-    for (int grid_id = 0; (grid_id < range_grid) && !exit; ++grid_id) {
-      if (std::fabs(result) < (delta * (grid_id + 1))) {
-        color_id_[pixel_id] = range.GetColorId(grid_id);
-        exit = true;
+  // The regions are clipped and split into the blocks of rows.
+  std::vector<Rect2n> blocks;
+  std::vector<int> region_block_num;
+  for (size_t i = 0; i < regions.size(); ++i) {
+    const int left = (regions[i].left > 0) ? regions[i].left : 0;
+    const int top = (regions[i].top > 0) ? regions[i].top : 0;
+    const int right =
+      (regions[i].right < pixel_.x) ? regions[i].right : pixel_.x;
+    const int bottom =
+      (regions[i].bottom < pixel_.y) ? regions[i].bottom : pixel_.y;
+    if ((left >= right) || (top >= bottom)) continue;
+    InvalidatePixels(Rect2n(left, top, right, bottom));
+    int block_rows = CANVAS_BLOCK_PIXELS / (right - left);
+    if (block_rows < 1) block_rows = 1;
+    const size_t block_begin = blocks.size();
+    for (int y = top; y < bottom; y += block_rows) {
+      const int y_end = (y + block_rows < bottom) ? (y + block_rows) : bottom;
+      blocks.push_back(Rect2n(left, y, right, y_end));
+    }
+    region_block_num.push_back(static_cast<int>(blocks.size() - block_begin));
+  }
+
+  // The colors depend only on the pixel positions, so the blocks of rows
+  // give the same canvas on any number of threads.
+  // The canceled update leaves the blocks not started.
+  if (control_ != nullptr) {
+    control_->SetStepNum(static_cast<int>(blocks.size()));
+  }
+  int block_offset = 0;
+  auto task = [&](int block_id) {
+    if ((control_ != nullptr) && control_->IsCanceled()) return;
+    TRACE_SCOPE("Canvas::Block");
+    const Rect2n& block = blocks[block_offset + block_id];
+    int values[CANVAS_CHUNK_PIXELS];
+    std::vector<uint32_t> counts(CANVAS_COUNT_LANES * grid, 0);
+    for (int y = block.top; y < block.bottom; ++y) {
+      for (int x = block.left; x < block.right; x += CANVAS_CHUNK_PIXELS) {
+        const int num = (block.right - x < CANVAS_CHUNK_PIXELS) ?
+          (block.right - x) : CANVAS_CHUNK_PIXELS;
+        generator.GenerateBucketSpan(x, y, num, values);
+        int i = 0;
+        for (; i + CANVAS_COUNT_LANES <= num; i += CANVAS_COUNT_LANES) {
+          for (int lane = 0; lane < CANVAS_COUNT_LANES; ++lane) {
+            ++counts[lane * grid + values[i + lane]];
+          }
+        }
+        for (; i < num; ++i) ++counts[values[i]];
+        if (!bucket) {
+          for (i = 0; i < num; ++i) values[i] = bucket_color_ids[values[i]];
+        }
+        store_.StoreSpan(x, y, num, values);
       }
     }
+    {
+      std::lock_guard<std::mutex> lock(counts_mutex);
+      for (int i = 0; i < CANVAS_COUNT_LANES * grid; ++i) {
+        bucket_counts_[i % grid] += counts[i];
+      }
+    }
+    if (control_ != nullptr) control_->Advance();
+  };
+  auto run = [&](int block_num) {
+    if (pool_ != nullptr) {
+      pool_->Run(block_num, task);
+    } else {
+      for (int block_id = 0; block_id < block_num; ++block_id) task(block_id);
+    }
+  };
+
+  // The packed regions sharing rows may share words, so the regions of
+  // the bucket storage are run one by one.
+  if (bucket) {
+    for (size_t i = 0; i < region_block_num.size(); ++i) {
+      run(region_block_num[i]);
+      block_offset += region_block_num[i];
+    }
+  } else {
+    run(static_cast<int>(blocks.size()));
   }
+  color_counts_.assign(palette.GetColorNum(), 0);
+  for (int grid_id = 0; grid_id < grid; ++grid_id) {
+    color_counts_[bucket_color_ids[grid_id]] += bucket_counts_[grid_id];
+  }
+}
+void Canvas::SwapPixels(Canvas* canvas) {
+  assert(canvas);
+  assert((canvas->pixel_.x == pixel_.x) && (canvas->pixel_.y == pixel_.y));
+  assert(canvas->storage_ == storage_);
+  std::swap(index_bits_, canvas->index_bits_);
+  std::swap(store_, canvas->store_);
+  std::swap(preview_, canvas->preview_);
+  bucket_counts_.swap(canvas->bucket_counts_);
+  color_counts_.swap(canvas->color_counts_);
+  grid_color_id_.swap(canvas->grid_color_id_);
+  grid_wide_color_id_.swap(canvas->grid_wide_color_id_);
+  raster_.Invalidate();
+  canvas->raster_.Invalidate();
 }
 Vector2n Canvas::GetPixels() const {
   return pixel_;
 }
+CANVAS_STORAGE Canvas::GetStorage() const {
+  return storage_;
+}
+const Noise& Canvas::GetNoise() const {
+  return noise_;
+}
 int Canvas::GetColorId(int pixel_id) const {
-  return color_id_[pixel_id];
+  const int value = store_.Load(pixel_id % pixel_.x, pixel_id / pixel_.x);
+  return (storage_ == CANVAS_STORAGE_BUCKET_ID) ?
+    grid_color_id_[value] : value;
+}
+int Canvas::GetIndexBits() const {
+  return index_bits_;
+}
+void Canvas::GetColorRow(int y, uint8_t* color_ids) const {
+  assert(index_bits_ == 8);
+  const bool bucket = (storage_ == CANVAS_STORAGE_BUCKET_ID);
+  store_.LoadRow(y, bucket ? grid_color_id_.data() : nullptr, color_ids);
+}
+void Canvas::GetColorRow(int y, uint16_t* color_ids) const {
+  const bool bucket = (storage_ == CANVAS_STORAGE_BUCKET_ID);
+  store_.LoadRow(y, bucket ? grid_wide_color_id_.data() : nullptr, color_ids);
+}
+const std::vector<int64_t>& Canvas::GetBucketCounts() const {
+  return bucket_counts_;
+}
+const std::vector<int64_t>& Canvas::GetColorCounts() const {
+  return color_counts_;
+}
+size_t Canvas::GetStorageBytes() const {
+  return store_.GetBytes();
+}
+
+void Canvas::Invalidate() {
+  raster_.Invalidate();
+}
+void Canvas::BuildPreview(const Palette& palette) {
+  if (preview_level_ < 0) return;
+  preview_.Update(palette, [this](int y, uint16_t* color_ids) {
+    GetColorRow(y, color_ids);
+  }, pool_);
+}
+void Canvas::Render(const Palette& palette) {
+  if (preview_level_ >= 0) {
+    RenderPreview(palette);
+  } else if (index_bits_ == 8) {
+    RenderRows<uint8_t>(palette);
+  } else {
+    RenderRows<uint16_t>(palette);
+  }
+}
+const Raster& Canvas::GetRaster() const {
+  return raster_;
+}
+
+void Canvas::InvalidatePixels(const Rect2n& rect) {
+  // The cells of the preview level covering the pixels are drawn again.
+  preview_.InvalidateRect(rect);
+  if (preview_level_ < 0) {
+    raster_.InvalidateCells(rect);
+    return;
+  }
+  const int shift = preview_.GetLevelShift(preview_level_);
+  raster_.InvalidateCells(Rect2n(rect.left >> shift, rect.top >> shift,
+      ((rect.right - 1) >> shift) + 1, ((rect.bottom - 1) >> shift) + 1));
+}
+void Canvas::RenderPreview(const Palette& palette) {
+  // The cost depends on the size of the preview, not of the canvas.
+  BuildPreview(palette);
+  const Vector2n grid = raster_.GetGrid();
+  std::vector<uint32_t> cell_colors(grid.x);
+  int begin = 0;
+  int end = 0;
+  for (int i = 0; i < grid.y; ++i) {
+    if (!raster_.GetDirtyColumns(i, &begin, &end)) continue;
+    preview_.GetRow(preview_level_, i, begin, end, cell_colors.data());
+    raster_.FillCells(i, begin, end, cell_colors.data());
+  }
+  raster_.EndFrame();
+}
+template<class INDEX>
+void Canvas::RenderRows(const Palette& palette) {
+  // Only the dirty cells are drawn to the frame buffer, the colors of the
+  // palette are already packed as the pixels.
+  const uint32_t* colors = palette.GetPackedColors();
+  std::vector<INDEX> color_ids(pixel_.x);
+  std::vector<uint32_t> cell_colors(pixel_.x);
+  const Vector2n grid = raster_.GetGrid();
+  int begin = 0;
+  int end = 0;
+  for (int i = 0; i < grid.y; ++i) {
+    if (!raster_.GetDirtyColumns(i, &begin, &end)) continue;
+    GetColorRow(i, color_ids.data());
+    for (int j = begin; j < end; ++j) cell_colors[j] = colors[color_ids[j]];
+    raster_.FillCells(i, begin, end, cell_colors.data());
+  }
+  raster_.EndFrame();
 }
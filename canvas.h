@@ -8,38 +8,137 @@
 #define CANVAS_H_
 
 #include <wchar.h>
+#include <stdint.h>
+#ifdef _WIN32
 #include <windows.h>
+#endif
 #include <vector>
 
+#include "./noise.h"
 #include "./palette.h"
+#include "./pixel_store.h"
+#include "./preview_pyramid.h"
 #include "./range.h"
+#include "./raster.h"
+#include "./thread_pool.h"
 
-#include "./utility.h"
+#include "./common.h"
+
+  // The canvas stores one byte of color id per pixel by default, two bytes
+  // for the palette of more than 256 colors.
+  // The bucket storage packs the range bucket ids in the fewest bits and
+  // resolves the colors by the range of the last update.
+enum CANVAS_STORAGE {
+  CANVAS_STORAGE_COLOR_ID,
+  CANVAS_STORAGE_BUCKET_ID,
+};
 
 class Canvas {
  public:
   Canvas();
 
+  void Init(const Vector2n& pixel);
+  void Init(const Vector2n& pixel, CANVAS_STORAGE storage);
+  void SetThreadPool(ThreadPool* pool);
+
+  // The update is canceled between the blocks of rows by the control, its
+  // progress is the blocks done. The control may be nullptr.
+  void SetJobControl(JobControl* control);
+
+  // The pixels are independent by default. The noise makes the tileable
+  // field of the canvas size, mapped to the same buckets of the range.
+  void SetNoise(const Noise& noise);
+
+  // The preview of the size has one cell per canvas pixel.
+  void SetSize(const Vector2n& size);
+
+  // Only the level of the preview pyramid is chosen for the size, for the
+  // canvas which builds the levels but does not render.
+  void SetPreviewSize(const Vector2n& size);
+  Vector2n GetSize() const;
+
+#ifdef _WIN32
   void Create(
       HWND hwnd,
       const Vector2n& pixel,
       const Palette& palette,
       const Range& range);
   void Paint(HWND hwnd, const Palette& palette);
+  void Expose();
   void Destroy(HWND hwnd);
+#endif
 
   void Update(const Palette& palette, const Range& range);
+  void Update(const Palette& palette, const Range& range, uint32_t seed);
+
+  // Only the pixels in the regions are drawn again, with the same values
+  // as the whole canvas drawn by the seed. The regions must not overlap.
+  void UpdateRegion(
+      const Palette& palette,
+      const Range& range,
+      uint32_t seed,
+      const Rect2n& region);
+  void UpdateRegions(
+      const Palette& palette,
+      const Range& range,
+      uint32_t seed,
+      const std::vector<Rect2n>& regions);
+
+  // The pixels are exchanged with the canvas of the same size and storage,
+  // the preview is drawn again.
+  void SwapPixels(Canvas* canvas);
   Vector2n GetPixels() const;
+  CANVAS_STORAGE GetStorage() const;
+  const Noise& GetNoise() const;
   int GetColorId(int pixel_id) const;
 
+  // The color ids are 8 or 16 bits, given by the palette of the last
+  // update. The 8 bits row can be read only from the 8 bits canvas.
+  int GetIndexBits() const;
+  void GetColorRow(int y, uint8_t* color_ids) const;
+  void GetColorRow(int y, uint16_t* color_ids) const;
+
+  // The pixels drawn by the last update are counted while drawn, for every
+  // bucket of its range and every color of its palette. The counts are of
+  // the whole canvas when the last update is of the whole canvas.
+  const std::vector<int64_t>& GetBucketCounts() const;
+  const std::vector<int64_t>& GetColorCounts() const;
+  size_t GetStorageBytes() const;
+
+  // The updated pixels are marked dirty, the render draws only the dirty
+  // cells of the preview.
+  void Invalidate();
+
+  // The canvas larger than the preview is drawn from the level of the
+  // pyramid which fits in it. The dirty tiles of the pyramid are built by
+  // the render, or before it by the build.
+  void BuildPreview(const Palette& palette);
+  void Render(const Palette& palette);
+  const Raster& GetRaster() const;
+
  private:
-  HDC hdc_offscreen_;
-  HBITMAP hdc_bitmap_;
+  void InvalidatePixels(const Rect2n& rect);
+  void RenderPreview(const Palette& palette);
+  template<class INDEX>
+  void RenderRows(const Palette& palette);
 
+ private:
+  ThreadPool* pool_;
+  JobControl* control_;
   int pixel_num_;
   Vector2n pixel_;
   Vector2n size_;
-  std::vector<int> color_id_;
+  CANVAS_STORAGE storage_;
+  Noise noise_;
+  int index_bits_;
+  PixelStore store_;
+  std::vector<uint8_t> grid_color_id_;
+  std::vector<uint16_t> grid_wide_color_id_;
+  std::vector<int64_t> bucket_counts_;
+  std::vector<int64_t> color_counts_;
+  PreviewPyramid preview_;
+  int preview_level_;
+  Raster raster_;
 };
 
 #endif  // CANVAS_H_
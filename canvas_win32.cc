@@ -0,0 +1,62 @@
+  // @file canvas_win32.cc
+  // @brief Canvas class, the Win32 drawing part.
+  // @author Mamoru Kaminaga
+  // @date 2017-11-17
+  // Copyright 2017 Mamoru Kaminaga
+  // This program is provided with MIT license. See "LICENSE.md".
+#include <wchar.h>
+#include <windows.h>
+#include <stdint.h>
+#include <vector>
+
+#include "./canvas.h"
+#include "./palette.h"
+#include "./range.h"
+#include "./raster.h"
+#include "./utility.h"
+
+#include "./resource.h"
+
+void Canvas::Create(
+      HWND hwnd,
+      const Vector2n& pixel,
+      const Palette& palette,
+      const Range& range) {
+  // The palette size and color vector is set.
+  Init(pixel);
+
+  // Window handle and size is acquired.
+  HWND hwnd_canvas = GetDlgItem(hwnd, IDC_PIC_CANVAS);
+  RECT rc;
+  GetClientRect(hwnd_canvas, &rc);
+  size_.x = (rc.right - rc.left);
+  size_.y = (rc.bottom - rc.top);
+
+  // The preview is sized to the window.
+  SetSize(size_);
+
+  // The initial setup.
+  Update(palette, range);
+}
+void Canvas::Paint(HWND hwnd, const Palette& palette) {
+  // Window handle and size is acquired.
+  HWND hwnd_canvas = GetDlgItem(hwnd, IDC_PIC_CANVAS);
+
+  // Only the dirty cells are drawn, only the damage is copied.
+  Render(palette);
+  Rect2n damage;
+  if (!raster_.TakeDamage(&damage)) return;
+  HDC hdc = GetDC(hwnd_canvas);
+  BlitRaster(hdc, raster_, damage);
+  ReleaseDC(hwnd_canvas, hdc);
+}
+void Canvas::Expose() {
+  raster_.Expose();
+}
+void Canvas::Destroy(HWND hwnd) {
+  // The frame buffer is released.
+  raster_.Init(Vector2n(0, 0));
+
+  // Warnings are prevented for non-used parameters.
+  UNREFERENCED_PARAMETER(hwnd);
+}
@@ -0,0 +1,55 @@
+  // @file common.cc
+  // @brief Platform independent types and functions.
+  // @author Mamoru Kaminaga
+  // @date 2026-10-17
+  // Copyright 2026 Mamoru Kaminaga
+  // This program is provided with MIT license. See "LICENSE.md".
+#include <assert.h>
+#include <wchar.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "./common.h"
+
+FILE* OpenFile(const wchar_t* file_name, const wchar_t* mode) {
+  assert(file_name);
+  assert(mode);
+
+  FILE* fp = nullptr;
+#ifdef _WIN32
+  _wfopen_s(&fp, file_name, mode);
+#else
+  // The wide names are converted to the multi byte names of the locale.
+  const size_t name_size = wcstombs(nullptr, file_name, 0);
+  if (name_size == static_cast<size_t>(-1)) return nullptr;
+  std::vector<char> name(name_size + 1);
+  wcstombs(name.data(), file_name, name.size());
+  char mode_name[8] = {0};
+  if (wcstombs(mode_name, mode, sizeof(mode_name) - 1) ==
+      static_cast<size_t>(-1)) {
+    return nullptr;
+  }
+  fp = fopen(name.data(), mode_name);
+#endif
+  return fp;
+}
+bool LoadFile(const wchar_t* file_name, std::vector<uint8_t>* data) {
+  assert(file_name);
+  assert(data);
+  FILE* fp = OpenFile(file_name, L"rb");
+  if (fp == nullptr) return false;
+
+  // The size is taken from the end of the file.
+  bool result = false;
+  if (fseek(fp, 0, SEEK_END) == 0) {
+    const long size = ftell(fp);
+    if ((size >= 0) && (fseek(fp, 0, SEEK_SET) == 0)) {
+      data->resize(static_cast<size_t>(size));
+      result = (size == 0) ||
+        (fread(data->data(), static_cast<size_t>(size), 1, fp) == 1);
+    }
+  }
+  fclose(fp);
+  return result;
+}
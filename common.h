@@ -0,0 +1,69 @@
+  // @file common.h
+  // @brief Platform independent types and functions.
+  // @author Mamoru Kaminaga
+  // @date 2026-10-17
+  // Copyright 2026 Mamoru Kaminaga
+  // This program is provided with MIT license. See "LICENSE.md".
+#ifndef COMMON_H_
+#define COMMON_H_
+
+#include <wchar.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+
+  // Warnings are prevented for non-used parameters on every platform.
+#ifndef UNREFERENCED_PARAMETER
+#define UNREFERENCED_PARAMETER(P) ((void)(P))
+#endif
+
+struct RGBVecotr {
+  int r;
+  int g;
+  int b;
+  RGBVecotr() : r(0), g(0), b(0) { }
+  RGBVecotr(int r0, int g0, int b0) : r(r0), g(g0), b(b0) { }
+};
+
+  // The color packed as 0x00RRGGBB, the bytes are B, G, R, 0 in the
+  // memory of the little endian machine, same as the bitmap color table.
+inline uint32_t PackColor(const RGBVecotr& color) {
+  return (static_cast<uint32_t>(color.r & 0xff) << 16) |
+    (static_cast<uint32_t>(color.g & 0xff) << 8) |
+    static_cast<uint32_t>(color.b & 0xff);
+}
+inline RGBVecotr UnpackColor(uint32_t color) {
+  return RGBVecotr((color >> 16) & 0xff, (color >> 8) & 0xff, color & 0xff);
+}
+
+template<class TYPE>
+struct Vector2 {
+  TYPE x;
+  TYPE y;
+  Vector2() : x(0), y(0) { }
+  Vector2(TYPE x0, TYPE y0) : x(x0), y(y0) { }
+};
+typedef Vector2<int> Vector2n;
+typedef Vector2<double> Vector2d;
+
+  // The rectangle includes left and top, excludes right and bottom.
+template<class TYPE>
+struct Rect2 {
+  TYPE left;
+  TYPE top;
+  TYPE right;
+  TYPE bottom;
+  Rect2() : left(0), top(0), right(0), bottom(0) { }
+  Rect2(TYPE left0, TYPE top0, TYPE right0, TYPE bottom0)
+    : left(left0), top(top0), right(right0), bottom(bottom0) { }
+};
+typedef Rect2<int> Rect2n;
+
+  // The file is opened with a wide character name on every platform.
+FILE* OpenFile(const wchar_t* file_name, const wchar_t* mode);
+
+  // The whole file is read by one call into the data, the capacity of the
+  // data is reused by the next call.
+bool LoadFile(const wchar_t* file_name, std::vector<uint8_t>* data);
+
+#endif  // COMMON_H_
@@ -0,0 +1,40 @@
+  // @file cpu.cc
+  // @brief CPU feature detection for the SIMD kernels.
+  // @author Mamoru Kaminaga
+  // @date 2026-10-17
+  // Copyright 2026 Mamoru Kaminaga
+  // This program is provided with MIT license. See "LICENSE.md".
+#include "./cpu.h"
+
+#if defined(CPU_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+namespace {
+bool DetectAvx2() {
+#if defined(CPU_X86) && (defined(__GNUC__) || defined(__clang__))
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2") != 0;
+#elif defined(CPU_X86) && defined(_MSC_VER)
+  // The OS must save the YMM registers, and the CPU must support AVX2.
+  int info[4] = {0};
+  __cpuid(info, 0);
+  if (info[0] < 7) return false;
+  __cpuid(info, 1);
+  const bool osxsave = (info[2] & (1 << 27)) != 0;
+  const bool avx = (info[2] & (1 << 28)) != 0;
+  if (!osxsave || !avx) return false;
+  if ((_xgetbv(0) & 0x6) != 0x6) return false;
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+#else
+  return false;
+#endif
+}
+}  // namespace
+
+bool CpuHasAvx2() {
+  static const bool has_avx2 = DetectAvx2();
+  return has_avx2;
+}
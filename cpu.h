@@ -0,0 +1,27 @@
+  // @file cpu.h
+  // @brief CPU feature detection for the SIMD kernels.
+  // @author Mamoru Kaminaga
+  // @date 2026-10-17
+  // Copyright 2026 Mamoru Kaminaga
+  // This program is provided with MIT license. See "LICENSE.md".
+#ifndef CPU_H_
+#define CPU_H_
+
+  // The x86 kernels are compiled on x86 and x64 targets only,
+  // NO_SIMD leaves the scalar kernels only.
+#if !defined(NO_SIMD) && (defined(__x86_64__) || defined(__i386__) || \
+    defined(_M_X64) || defined(_M_IX86))
+#define CPU_X86 (1)
+#endif
+
+  // AVX2 functions are compiled with the target attribute on GCC and clang,
+  // MSVC compiles AVX2 intrinsics without any option.
+#if defined(CPU_X86) && (defined(__GNUC__) || defined(__clang__))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_AVX2
+#endif
+
+bool CpuHasAvx2();
+
+#endif  // CPU_H_
@@ -0,0 +1,598 @@
+  // @file deflate.cc
+  // @brief Deflate encoder and checksums.
+  // @author Mamoru Kaminaga
+  // @date 2026-10-17
+  // Copyright 2026 Mamoru Kaminaga
+  // This program is provided with MIT license. See "LICENSE.md".
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+#include "./deflate.h"
+#include "./common.h"
+
+#define DEFLATE_MIN_MATCH     (3)
+#define DEFLATE_MAX_MATCH     (258)
+#define DEFLATE_HASH_BITS     (15)
+#define DEFLATE_MAX_STORED    (65535)
+#define DEFLATE_MAX_BITS      (15)
+#define DEFLATE_MAX_CODE_BITS (7)
+
+  // The number of the symbols coded by one Huffman table.
+#define DEFLATE_BLOCK_SYMBOLS (1 << 16)
+
+#define DEFLATE_LITERAL_NUM   (286)
+#define DEFLATE_DISTANCE_NUM  (30)
+#define DEFLATE_CODE_NUM      (19)
+#define DEFLATE_END_OF_BLOCK  (256)
+
+#define ADLER_BASE            (65521)
+#define ADLER_BLOCK           (5552)
+
+namespace {
+const int kLengthBase[29] = {
+  3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+  35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258,
+};
+const int kLengthExtra[29] = {
+  0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+  3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0,
+};
+const int kDistanceBase[30] = {
+  1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+  257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289,
+  16385, 24577,
+};
+const int kDistanceExtra[30] = {
+  0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+  7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13,
+};
+const int kCodeOrder[DEFLATE_CODE_NUM] = {
+  16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15,
+};
+
+  // The match search of each level, the chain is the number of the
+  // candidates tried and the lazy match looks one byte ahead.
+struct Level {
+  int chain;
+  int nice;
+  bool lazy;
+};
+const Level kLevels[DEFLATE_MAX_LEVEL + 1] = {
+  {0, 0, false},
+  {4, 8, false},
+  {8, 16, false},
+  {16, 32, false},
+  {16, 32, true},
+  {32, 64, true},
+  {64, 128, true},
+  {128, 128, true},
+  {512, DEFLATE_MAX_MATCH, true},
+  {2048, DEFLATE_MAX_MATCH, true},
+};
+
+  // The code of every length and the distance codes of the distances
+  // minus 1, the distances over 256 are looked up by the upper bits.
+struct CodeTable {
+  uint8_t length_code[DEFLATE_MAX_MATCH + 1];
+  uint8_t distance_code[512];
+  CodeTable() {
+    for (int code = 0; code < 29; ++code) {
+      const int end = (code < 28) ? kLengthBase[code + 1] : 259;
+      for (int length = kLengthBase[code]; length < end; ++length) {
+        length_code[length] = static_cast<uint8_t>(code);
+      }
+    }
+    length_code[0] = length_code[1] = length_code[2] = 0;
+    for (int code = 0; code < 30; ++code) {
+      const int end = (code < 29) ? kDistanceBase[code + 1] : 32769;
+      for (int distance = kDistanceBase[code]; distance < end; ++distance) {
+        const int d = distance - 1;
+        if (d < 256) {
+          distance_code[d] = static_cast<uint8_t>(code);
+        } else {
+          distance_code[256 + (d >> 7)] = static_cast<uint8_t>(code);
+        }
+      }
+    }
+  }
+  int GetDistanceCode(int distance) const {
+    const int d = distance - 1;
+    return (d < 256) ? distance_code[d] : distance_code[256 + (d >> 7)];
+  }
+};
+const CodeTable kCodeTable;
+
+struct CrcTable {
+  uint32_t values[256];
+  CrcTable() {
+    for (uint32_t n = 0; n < 256; ++n) {
+      uint32_t c = n;
+      for (int k = 0; k < 8; ++k) {
+        c = (c & 1) ? (0xedb88320 ^ (c >> 1)) : (c >> 1);
+      }
+      values[n] = c;
+    }
+  }
+};
+const CrcTable kCrcTable;
+
+  // The bits are written from the least significant bit.
+class BitWriter {
+ public:
+  explicit BitWriter(std::vector<uint8_t>* output)
+    : output_(output), bits_(0), bit_num_(0) { }
+  void Put(uint32_t bits, int num) {
+    bits_ |= static_cast<uint64_t>(bits) << bit_num_;
+    bit_num_ += num;
+    while (bit_num_ >= 8) {
+      output_->push_back(static_cast<uint8_t>(bits_));
+      bits_ >>= 8;
+      bit_num_ -= 8;
+    }
+  }
+  void Align() {
+    if (bit_num_ > 0) Put(0, 8 - bit_num_);
+  }
+  void PutBytes(const uint8_t* data, size_t size) {
+    assert(bit_num_ == 0);
+    output_->insert(output_->end(), data, data + size);
+  }
+
+ private:
+  std::vector<uint8_t>* output_;
+  uint64_t bits_;
+  int bit_num_;
+};
+
+  // The lengths of the Huffman codes limited to max_bits. One used symbol
+  // gets a pair of codes, so every code is complete.
+void BuildLengths(
+    const uint32_t* freqs,
+    int num,
+    int max_bits,
+    uint8_t* lengths) {
+  memset(lengths, 0, num);
+  std::vector<int> symbols;
+  for (int s = 0; s < num; ++s) {
+    if (freqs[s] > 0) symbols.push_back(s);
+  }
+  const int n = static_cast<int>(symbols.size());
+  if (n == 0) return;
+  if (n == 1) {
+    lengths[symbols[0]] = 1;
+    lengths[(symbols[0] == 0) ? 1 : 0] = 1;
+    return;
+  }
+
+  // The tree is built from the two queues of the sorted leaves and the
+  // internal nodes, the internal nodes are made in the increasing order.
+  std::stable_sort(symbols.begin(), symbols.end(), [freqs](int a, int b) {
+    return freqs[a] < freqs[b];
+  });
+  std::vector<uint64_t> weights(2 * n - 1);
+  std::vector<int> parents(2 * n - 1, 0);
+  for (int i = 0; i < n; ++i) weights[i] = freqs[symbols[i]];
+  int leaf = 0;
+  int node = n;
+  for (int next = n; next < 2 * n - 1; ++next) {
+    int pair[2];
+    for (int k = 0; k < 2; ++k) {
+      if ((leaf < n) && ((node >= next) || (weights[leaf] <= weights[node]))) {
+        pair[k] = leaf++;
+      } else {
+        pair[k] = node++;
+      }
+    }
+    weights[next] = weights[pair[0]] + weights[pair[1]];
+    parents[pair[0]] = next;
+    parents[pair[1]] = next;
+  }
+  std::vector<int> depths(2 * n - 1, 0);
+  std::vector<int> counts(max_bits + 1, 0);
+  for (int i = 2 * n - 3; i >= 0; --i) {
+    depths[i] = depths[parents[i]] + 1;
+    if (i < n) ++counts[(depths[i] < max_bits) ? depths[i] : max_bits];
+  }
+
+  // The too long codes are cut to max_bits, then the shorter codes are
+  // split until the code is complete again.
+  uint32_t total = 0;
+  for (int i = 1; i <= max_bits; ++i) {
+    total += static_cast<uint32_t>(counts[i]) << (max_bits - i);
+  }
+  while (total > (1u << max_bits)) {
+    --counts[max_bits];
+    for (int i = max_bits - 1; i > 0; --i) {
+      if (counts[i] > 0) {
+        --counts[i];
+        counts[i + 1] += 2;
+        break;
+      }
+    }
+    --total;
+  }
+
+  // The rare symbols get the long codes.
+  int index = 0;
+  for (int length = max_bits; length > 0; --length) {
+    for (int i = 0; i < counts[length]; ++i) {
+      lengths[symbols[index++]] = static_cast<uint8_t>(length);
+    }
+  }
+}
+  // The canonical codes, bit reversed for the writer.
+void BuildCodes(const uint8_t* lengths, int num, uint16_t* codes) {
+  int counts[DEFLATE_MAX_BITS + 1] = {0};
+  for (int s = 0; s < num; ++s) ++counts[lengths[s]];
+  counts[0] = 0;
+  int next[DEFLATE_MAX_BITS + 1] = {0};
+  int code = 0;
+  for (int bits = 1; bits <= DEFLATE_MAX_BITS; ++bits) {
+    code = (code + counts[bits - 1]) << 1;
+    next[bits] = code;
+  }
+  for (int s = 0; s < num; ++s) {
+    const int length = lengths[s];
+    if (length == 0) {
+      codes[s] = 0;
+      continue;
+    }
+    int value = next[length]++;
+    int reversed = 0;
+    for (int i = 0; i < length; ++i) {
+      reversed = (reversed << 1) | (value & 1);
+      value >>= 1;
+    }
+    codes[s] = static_cast<uint16_t>(reversed);
+  }
+}
+
+  // The symbol is the literal byte, or the length above 16 bits and the
+  // distance below.
+inline uint32_t MakeMatch(int length, int distance) {
+  return (static_cast<uint32_t>(length) << 16) |
+    static_cast<uint32_t>(distance);
+}
+
+  // The LZ77 matcher over the dictionary and the data in one buffer.
+class Matcher {
+ public:
+  Matcher(const uint8_t* buffer, size_t size, const Level& level)
+    : buffer_(buffer),
+      size_(size),
+      level_(level),
+      head_(1 << DEFLATE_HASH_BITS, -1),
+      prev_(size, -1) { }
+  void Insert(size_t pos) {
+    if (pos + DEFLATE_MIN_MATCH > size_) return;
+    const uint32_t hash = Hash(pos);
+    prev_[pos] = head_[hash];
+    head_[hash] = static_cast<int32_t>(pos);
+  }
+  int Find(size_t pos, int* distance) const {
+    int best = 0;
+    if (pos + DEFLATE_MIN_MATCH > size_) return 0;
+    const size_t remain = size_ - pos;
+    const int max_length = (remain < DEFLATE_MAX_MATCH) ?
+      static_cast<int>(remain) : DEFLATE_MAX_MATCH;
+    const uint8_t* p = &buffer_[pos];
+    int32_t candidate = head_[Hash(pos)];
+    for (int chain = level_.chain; (candidate >= 0) && (chain > 0); --chain) {
+      const size_t d = pos - static_cast<size_t>(candidate);
+      if (d > DEFLATE_WINDOW_SIZE) break;
+      const uint8_t* q = &buffer_[candidate];
+      if ((q[best] == p[best]) && (q[0] == p[0]) && (q[1] == p[1])) {
+        int length = 2;
+        while ((length < max_length) && (q[length] == p[length])) ++length;
+        if (length > best) {
+          best = length;
+          *distance = static_cast<int>(d);
+          if (best >= level_.nice || best == max_length) break;
+        }
+      }
+      candidate = prev_[candidate];
+    }
+    return (best >= DEFLATE_MIN_MATCH) ? best : 0;
+  }
+
+ private:
+  uint32_t Hash(size_t pos) const {
+    const uint32_t v = buffer_[pos] | (buffer_[pos + 1] << 8) |
+      (buffer_[pos + 2] << 16);
+    return (v * 2654435761u) >> (32 - DEFLATE_HASH_BITS);
+  }
+
+ private:
+  const uint8_t* buffer_;
+  size_t size_;
+  const Level& level_;
+  std::vector<int32_t> head_;
+  std::vector<int32_t> prev_;
+};
+
+void WriteStored(
+    const uint8_t* data,
+    size_t size,
+    bool last,
+    BitWriter* writer) {
+  // The data longer than the stored block is split.
+  size_t offset = 0;
+  do {
+    const size_t num = (size - offset < DEFLATE_MAX_STORED) ?
+      (size - offset) : DEFLATE_MAX_STORED;
+    const bool final = last && (offset + num == size);
+    writer->Put(final ? 1 : 0, 1);
+    writer->Put(0, 2);
+    writer->Align();
+    writer->Put(static_cast<uint32_t>(num), 16);
+    writer->Put(static_cast<uint32_t>(~num) & 0xffff, 16);
+    writer->PutBytes(&data[offset], num);
+    offset += num;
+  } while (offset < size);
+}
+  // The block is written with its own Huffman codes, or stored when it is
+  // smaller.
+void WriteBlock(
+    const std::vector<uint32_t>& symbols,
+    const uint8_t* data,
+    size_t size,
+    bool last,
+    BitWriter* writer) {
+  uint32_t literal_freqs[DEFLATE_LITERAL_NUM] = {0};
+  uint32_t distance_freqs[DEFLATE_DISTANCE_NUM] = {0};
+  for (size_t i = 0; i < symbols.size(); ++i) {
+    const uint32_t s = symbols[i];
+    if (s < 256) {
+      ++literal_freqs[s];
+    } else {
+      ++literal_freqs[257 + kCodeTable.length_code[s >> 16]];
+      ++distance_freqs[kCodeTable.GetDistanceCode(s & 0xffff)];
+    }
+  }
+  literal_freqs[DEFLATE_END_OF_BLOCK] = 1;
+  uint8_t literal_lengths[DEFLATE_LITERAL_NUM];
+  uint8_t distance_lengths[DEFLATE_DISTANCE_NUM];
+  BuildLengths(
+      literal_freqs, DEFLATE_LITERAL_NUM, DEFLATE_MAX_BITS, literal_lengths);
+  BuildLengths(distance_freqs, DEFLATE_DISTANCE_NUM, DEFLATE_MAX_BITS,
+      distance_lengths);
+  if (std::count(distance_lengths, distance_lengths + DEFLATE_DISTANCE_NUM,
+      0) == DEFLATE_DISTANCE_NUM) {
+    // No match, one distance code is still written.
+    distance_lengths[0] = 1;
+  }
+  int literal_num = DEFLATE_LITERAL_NUM;
+  while (literal_lengths[literal_num - 1] == 0) --literal_num;
+  int distance_num = DEFLATE_DISTANCE_NUM;
+  while (distance_lengths[distance_num - 1] == 0) --distance_num;
+  uint8_t lengths[DEFLATE_LITERAL_NUM + DEFLATE_DISTANCE_NUM];
+  memcpy(lengths, literal_lengths, literal_num);
+  memcpy(&lengths[literal_num], distance_lengths, distance_num);
+  const int length_num = literal_num + distance_num;
+
+  // The code lengths are run length coded by the symbols 16 to 18.
+  std::vector<uint16_t> runs;
+  uint32_t code_freqs[DEFLATE_CODE_NUM] = {0};
+  for (int i = 0; i < length_num;) {
+    const int value = lengths[i];
+    int run = 1;
+    while ((i + run < length_num) && (lengths[i + run] == value)) ++run;
+    int left = run;
+    if (value == 0) {
+      while (left >= 11) {
+        const int num = (left < 138) ? left : 138;
+        runs.push_back(static_cast<uint16_t>(18 | ((num - 11) << 8)));
+        left -= num;
+      }
+      if (left >= 3) {
+        runs.push_back(static_cast<uint16_t>(17 | ((left - 3) << 8)));
+        left = 0;
+      }
+    } else if (left >= 4) {
+      runs.push_back(static_cast<uint16_t>(value));
+      --left;
+      while (left >= 3) {
+        const int num = (left < 6) ? left : 6;
+        runs.push_back(static_cast<uint16_t>(16 | ((num - 3) << 8)));
+        left -= num;
+      }
+    }
+    for (; left > 0; --left) runs.push_back(static_cast<uint16_t>(value));
+    i += run;
+  }
+  for (size_t i = 0; i < runs.size(); ++i) ++code_freqs[runs[i] & 0xff];
+  uint8_t code_lengths[DEFLATE_CODE_NUM];
+  BuildLengths(
+      code_freqs, DEFLATE_CODE_NUM, DEFLATE_MAX_CODE_BITS, code_lengths);
+  int code_num = DEFLATE_CODE_NUM;
+  while ((code_num > 4) && (code_lengths[kCodeOrder[code_num - 1]] == 0)) {
+    --code_num;
+  }
+
+  // The size of the coded block is compared with the stored block.
+  uint64_t bits = 3 + 5 + 5 + 4 + 3 * code_num;
+  const int kRunExtra[3] = {2, 3, 7};
+  for (int s = 0; s < DEFLATE_CODE_NUM; ++s) {
+    bits += static_cast<uint64_t>(code_freqs[s]) *
+      (code_lengths[s] + ((s >= 16) ? kRunExtra[s - 16] : 0));
+  }
+  for (int s = 0; s < DEFLATE_LITERAL_NUM; ++s) {
+    bits += static_cast<uint64_t>(literal_freqs[s]) *
+      (literal_lengths[s] + ((s > 256) ? kLengthExtra[s - 257] : 0));
+  }
+  for (int s = 0; s < DEFLATE_DISTANCE_NUM; ++s) {
+    bits += static_cast<uint64_t>(distance_freqs[s]) *
+      (distance_lengths[s] + kDistanceExtra[s]);
+  }
+  const uint64_t stored_bits =
+    (size + 5 * ((size + DEFLATE_MAX_STORED - 1) / DEFLATE_MAX_STORED)) * 8;
+  if (stored_bits <= bits) {
+    WriteStored(data, size, last, writer);
+    return;
+  }
+
+  // The header and the code lengths.
+  uint16_t literal_codes[DEFLATE_LITERAL_NUM];
+  uint16_t distance_codes[DEFLATE_DISTANCE_NUM];
+  uint16_t code_codes[DEFLATE_CODE_NUM];
+  BuildCodes(literal_lengths, DEFLATE_LITERAL_NUM, literal_codes);
+  BuildCodes(distance_lengths, DEFLATE_DISTANCE_NUM, distance_codes);
+  BuildCodes(code_lengths, DEFLATE_CODE_NUM, code_codes);
+  writer->Put(last ? 1 : 0, 1);
+  writer->Put(2, 2);
+  writer->Put(literal_num - 257, 5);
+  writer->Put(distance_num - 1, 5);
+  writer->Put(code_num - 4, 4);
+  for (int i = 0; i < code_num; ++i) {
+    writer->Put(code_lengths[kCodeOrder[i]], 3);
+  }
+  for (size_t i = 0; i < runs.size(); ++i) {
+    const int s = runs[i] & 0xff;
+    writer->Put(code_codes[s], code_lengths[s]);
+    if (s >= 16) writer->Put(runs[i] >> 8, kRunExtra[s - 16]);
+  }
+
+  // The symbols and the end of the block.
+  for (size_t i = 0; i < symbols.size(); ++i) {
+    const uint32_t s = symbols[i];
+    if (s < 256) {
+      writer->Put(literal_codes[s], literal_lengths[s]);
+      continue;
+    }
+    const int length = static_cast<int>(s >> 16);
+    const int distance = static_cast<int>(s & 0xffff);
+    const int length_code = kCodeTable.length_code[length];
+    writer->Put(literal_codes[257 + length_code],
+        literal_lengths[257 + length_code]);
+    writer->Put(length - kLengthBase[length_code], kLengthExtra[length_code]);
+    const int distance_code = kCodeTable.GetDistanceCode(distance);
+    writer->Put(distance_codes[distance_code], distance_lengths[distance_code]);
+    writer->Put(distance - kDistanceBase[distance_code],
+        kDistanceExtra[distance_code]);
+  }
+  writer->Put(literal_codes[DEFLATE_END_OF_BLOCK],
+      literal_lengths[DEFLATE_END_OF_BLOCK]);
+}
+}  // namespace
+
+void Deflate(
+    const uint8_t* dictionary,
+    size_t dictionary_size,
+    const uint8_t* data,
+    size_t size,
+    int level,
+    bool last,
+    std::vector<uint8_t>* output) {
+  assert(dictionary || (dictionary_size == 0));
+  assert(data || (size == 0));
+  assert((level >= 0) && (level <= DEFLATE_MAX_LEVEL));
+  assert(output);
+  BitWriter writer(output);
+
+  if ((level == 0) || (size == 0)) {
+    if ((size > 0) || last) WriteStored(data, size, last, &writer);
+  } else {
+    // The matches may refer the dictionary, so both are in one buffer.
+    if (dictionary_size > DEFLATE_WINDOW_SIZE) {
+      dictionary += dictionary_size - DEFLATE_WINDOW_SIZE;
+      dictionary_size = DEFLATE_WINDOW_SIZE;
+    }
+    std::vector<uint8_t> buffer(dictionary_size + size);
+    if (dictionary_size > 0) memcpy(buffer.data(), dictionary, dictionary_size);
+    memcpy(&buffer[dictionary_size], data, size);
+    Matcher matcher(buffer.data(), buffer.size(), kLevels[level]);
+    for (size_t pos = 0; pos < dictionary_size; ++pos) matcher.Insert(pos);
+
+    // The symbols are collected and written block by block.
+    std::vector<uint32_t> symbols;
+    symbols.reserve(DEFLATE_BLOCK_SYMBOLS);
+    const bool lazy = kLevels[level].lazy;
+    const int nice = kLevels[level].nice;
+    size_t block_begin = dictionary_size;
+    size_t pos = dictionary_size;
+    while (pos < buffer.size()) {
+      int distance = 0;
+      int length = matcher.Find(pos, &distance);
+      matcher.Insert(pos);
+      while (lazy && (length > 0) && (length < nice) &&
+          (pos + 1 < buffer.size())) {
+        int next_distance = 0;
+        const int next_length = matcher.Find(pos + 1, &next_distance);
+        if (next_length <= length) break;
+        symbols.push_back(buffer[pos]);
+        ++pos;
+        matcher.Insert(pos);
+        length = next_length;
+        distance = next_distance;
+      }
+      if (length > 0) {
+        symbols.push_back(MakeMatch(length, distance));
+        for (int i = 1; i < length; ++i) matcher.Insert(pos + i);
+        pos += length;
+      } else {
+        symbols.push_back(buffer[pos]);
+        ++pos;
+      }
+      if ((symbols.size() + 1 >= DEFLATE_BLOCK_SYMBOLS) ||
+          (pos == buffer.size())) {
+        WriteBlock(symbols, &buffer[block_begin], pos - block_begin,
+            last && (pos == buffer.size()), &writer);
+        symbols.clear();
+        block_begin = pos;
+      }
+    }
+  }
+
+  // The empty stored block aligns the output which is not the last.
+  if (!last) {
+    writer.Put(0, 3);
+    writer.Align();
+    writer.Put(0, 16);
+    writer.Put(0xffff, 16);
+  }
+  writer.Align();
+}
+
+uint32_t UpdateAdler32(uint32_t adler, const uint8_t* data, size_t size) {
+  assert(data || (size == 0));
+  uint32_t a = adler & 0xffff;
+  uint32_t b = adler >> 16;
+
+  // The sums are reduced once per block, before they overflow.
+  while (size > 0) {
+    const size_t num = (size < ADLER_BLOCK) ? size : ADLER_BLOCK;
+    for (size_t i = 0; i < num; ++i) {
+      a += data[i];
+      b += a;
+    }
+    a %= ADLER_BASE;
+    b %= ADLER_BASE;
+    data += num;
+    size -= num;
+  }
+  return (b << 16) | a;
+}
+uint32_t CombineAdler32(uint32_t adler1, uint32_t adler2, uint64_t size2) {
+  const uint32_t rem = static_cast<uint32_t>(size2 % ADLER_BASE);
+  uint32_t a = adler1 & 0xffff;
+  uint32_t b = (rem * a) % ADLER_BASE;
+  a += (adler2 & 0xffff) + ADLER_BASE - 1;
+  b += (adler1 >> 16) + (adler2 >> 16) + ADLER_BASE - rem;
+  if (a >= ADLER_BASE) a -= ADLER_BASE;
+  if (a >= ADLER_BASE) a -= ADLER_BASE;
+  if (b >= (ADLER_BASE << 1)) b -= (ADLER_BASE << 1);
+  if (b >= ADLER_BASE) b -= ADLER_BASE;
+  return (b << 16) | a;
+}
+uint32_t UpdateCrc32(uint32_t crc, const uint8_t* data, size_t size) {
+  assert(data || (size == 0));
+  uint32_t c = ~crc;
+  for (size_t i = 0; i < size; ++i) {
+    c = kCrcTable.values[(c ^ data[i]) & 0xff] ^ (c >> 8);
+  }
+  return ~c;
+}
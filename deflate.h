@@ -0,0 +1,43 @@
+  // @file deflate.h
+  // @brief Deflate encoder and checksums.
+  // @author Mamoru Kaminaga
+  // @date 2026-10-17
+  // Copyright 2026 Mamoru Kaminaga
+  // This program is provided with MIT license. See "LICENSE.md".
+#ifndef DEFLATE_H_
+#define DEFLATE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "./common.h"
+
+  // The distance of the matches is limited by the window.
+#define DEFLATE_WINDOW_SIZE (32768)
+
+  // The level 0 stores the data, 1 is the fastest and 9 is the smallest.
+#define DEFLATE_MAX_LEVEL   (9)
+
+  // The data is compressed as the deflate blocks following the dictionary,
+  // the last bytes just before the data in the stream. The output ends on
+  // the byte boundary, the output which is not the last ends with the
+  // empty stored block, so the outputs of the continuous data compressed
+  // on the different threads can be joined into one stream.
+void Deflate(
+    const uint8_t* dictionary,
+    size_t dictionary_size,
+    const uint8_t* data,
+    size_t size,
+    int level,
+    bool last,
+    std::vector<uint8_t>* output);
+
+  // The checksums start from UpdateAdler32(1, ...) and UpdateCrc32(0, ...).
+  // The combined Adler-32 is same as the one of the joined data, size2 is
+  // the size of the second data.
+uint32_t UpdateAdler32(uint32_t adler, const uint8_t* data, size_t size);
+uint32_t CombineAdler32(uint32_t adler1, uint32_t adler2, uint64_t size2);
+uint32_t UpdateCrc32(uint32_t crc, const uint8_t* data, size_t size);
+
+#endif  // DEFLATE_H_
@@ -0,0 +1,152 @@
+  // @file distribution.cc
+  // @brief Distributions of the range buckets.
+  // @author Mamoru Kaminaga
+  // @date 2026-10-17
+  // Copyright 2026 Mamoru Kaminaga
+  // This program is provided with MIT license. See "LICENSE.md".
+#include <assert.h>
+#include <wchar.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <cmath>
+#include <vector>
+
+#include "./distribution.h"
+#include "./common.h"
+
+namespace {
+template<class POLICY>
+void MakeBucketProbabilities(
+    const POLICY& policy,
+    double range,
+    int grid,
+    double* probabilities) {
+  // The last bucket takes the tail.
+  const double delta = range / static_cast<double>(grid);
+  double lower = 0.0;
+  for (int grid_id = 0; grid_id < grid - 1; ++grid_id) {
+    const double upper = policy.Cdf(delta * (grid_id + 1));
+    probabilities[grid_id] = upper - lower;
+    lower = upper;
+  }
+  probabilities[grid - 1] = 1.0 - lower;
+}
+template<class POLICY>
+void MakeDensities(
+    const POLICY& policy,
+    double range,
+    int num,
+    double* densities) {
+  const double delta = range / static_cast<double>(num);
+  for (int i = 0; i < num; ++i) {
+    densities[i] = policy.Density(delta * (i + 0.5));
+  }
+}
+}  // namespace
+
+bool IsValidDistribution(const Distribution& distribution) {
+  // The infinity and NaN make the probabilities degenerate.
+  if (!std::isfinite(distribution.range) || !(distribution.range > 0.0) ||
+      !std::isfinite(distribution.sigma) || !(distribution.sigma > 0.0)) {
+    return false;
+  }
+  if (distribution.type != DISTRIBUTION_TABLE) return true;
+  const std::vector<double>& table = distribution.table;
+  if (table.size() < 2) return false;
+  for (size_t i = 0; i < table.size(); ++i) {
+    if (!std::isfinite(table[i])) return false;
+  }
+  if ((table.front() < 0.0) || (table.back() > 1.0)) return false;
+  for (size_t i = 1; i < table.size(); ++i) {
+    if (table[i] < table[i - 1]) return false;
+  }
+  return true;
+}
+void GetBucketProbabilities(
+    const Distribution& distribution,
+    int grid,
+    std::vector<double>* probabilities) {
+  assert(grid > 0);
+  assert(probabilities);
+  assert(IsValidDistribution(distribution));
+  probabilities->resize(grid);
+  double* p = probabilities->data();
+  const double range = distribution.range;
+  switch (distribution.type) {
+    case DISTRIBUTION_UNIFORM:
+      MakeBucketProbabilities(UniformPolicy(distribution), range, grid, p);
+      break;
+    case DISTRIBUTION_EXPONENTIAL:
+      MakeBucketProbabilities(ExponentialPolicy(distribution), range, grid, p);
+      break;
+    case DISTRIBUTION_LOG_NORMAL:
+      MakeBucketProbabilities(LogNormalPolicy(distribution), range, grid, p);
+      break;
+    case DISTRIBUTION_TRIANGULAR:
+      MakeBucketProbabilities(TriangularPolicy(distribution), range, grid, p);
+      break;
+    case DISTRIBUTION_TABLE:
+      MakeBucketProbabilities(TablePolicy(distribution), range, grid, p);
+      break;
+    default:
+      MakeBucketProbabilities(NormalPolicy(distribution), range, grid, p);
+      break;
+  }
+}
+void GetDensities(
+    const Distribution& distribution,
+    int num,
+    std::vector<double>* densities) {
+  assert(num > 0);
+  assert(densities);
+  assert(IsValidDistribution(distribution));
+  densities->resize(num);
+  double* d = densities->data();
+  const double range = distribution.range;
+  switch (distribution.type) {
+    case DISTRIBUTION_UNIFORM:
+      MakeDensities(UniformPolicy(distribution), range, num, d);
+      break;
+    case DISTRIBUTION_EXPONENTIAL:
+      MakeDensities(ExponentialPolicy(distribution), range, num, d);
+      break;
+    case DISTRIBUTION_LOG_NORMAL:
+      MakeDensities(LogNormalPolicy(distribution), range, num, d);
+      break;
+    case DISTRIBUTION_TRIANGULAR:
+      MakeDensities(TriangularPolicy(distribution), range, num, d);
+      break;
+    case DISTRIBUTION_TABLE:
+      MakeDensities(TablePolicy(distribution), range, num, d);
+      break;
+    default:
+      MakeDensities(NormalPolicy(distribution), range, num, d);
+      break;
+  }
+}
+bool LoadDistributionTable(
+    const wchar_t* file_name,
+    std::vector<double>* table) {
+  assert(file_name);
+  assert(table);
+  std::vector<uint8_t> data;
+  if (!LoadFile(file_name, &data)) return false;
+  data.push_back('\0');
+
+  // The values are read until the end, any other text is an error.
+  table->clear();
+  const char* p = reinterpret_cast<const char*>(data.data());
+  for (;;) {
+    while ((*p == ' ') || (*p == ',') || (*p == '\t') ||
+        (*p == '\r') || (*p == '\n')) {
+      ++p;
+    }
+    if (*p == '\0') break;
+    char* end = nullptr;
+    const double value = strtod(p, &end);
+    if ((end == p) || !std::isfinite(value)) return false;
+    table->push_back(value);
+    p = end;
+  }
+  return true;
+}
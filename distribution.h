@@ -0,0 +1,151 @@
+  // @file distribution.h
+  // @brief Distributions of the range buckets.
+  // @author Mamoru Kaminaga
+  // @date 2026-10-17
+  // Copyright 2026 Mamoru Kaminaga
+  // This program is provided with MIT license. See "LICENSE.md".
+#ifndef DISTRIBUTION_H_
+#define DISTRIBUTION_H_
+
+#include <wchar.h>
+#include <cmath>
+#include <vector>
+
+#include "./common.h"
+
+  // The parameters of the normal distribution used by default.
+#define DISTRIBUTION_DEFAULT_RANGE  (2.80)
+#define DISTRIBUTION_DEFAULT_SIGMA  (1.0)
+
+enum DISTRIBUTION_TYPE {
+  DISTRIBUTION_NORMAL,
+  DISTRIBUTION_UNIFORM,
+  DISTRIBUTION_EXPONENTIAL,
+  DISTRIBUTION_LOG_NORMAL,
+  DISTRIBUTION_TRIANGULAR,
+  DISTRIBUTION_TABLE,
+};
+
+  // The distribution of the value t >= 0. The range from 0 to range is
+  // divided into the buckets of the same width, the last bucket takes the
+  // tail. Sigma is the scale of the normal, the exponential and the log
+  // normal distributions. The table holds the CDF at the points dividing
+  // the range equally, from t = 0 to t = range.
+struct Distribution {
+  DISTRIBUTION_TYPE type;
+  double range;
+  double sigma;
+  std::vector<double> table;
+  Distribution()
+    : type(DISTRIBUTION_NORMAL),
+      range(DISTRIBUTION_DEFAULT_RANGE),
+      sigma(DISTRIBUTION_DEFAULT_SIGMA) { }
+};
+
+  // The policies give the CDF and the density of t. The loops over the
+  // buckets are instantiated for every policy, so Cdf is inlined.
+  // The normal distribution is folded, t is |x|.
+struct NormalPolicy {
+  double scale;
+  explicit NormalPolicy(const Distribution& d)
+    : scale(1.0 / (d.sigma * std::sqrt(2.0))) { }
+  double Cdf(double t) const {
+    return std::erf(t * scale);
+  }
+  double Density(double t) const {
+    const double z = t * scale;
+    return 2.0 * scale / std::sqrt(3.14159265358979323846) * std::exp(-z * z);
+  }
+};
+struct UniformPolicy {
+  double range;
+  explicit UniformPolicy(const Distribution& d) : range(d.range) { }
+  double Cdf(double t) const {
+    return (t < range) ? (t / range) : 1.0;
+  }
+  double Density(double t) const {
+    return (t < range) ? (1.0 / range) : 0.0;
+  }
+};
+struct ExponentialPolicy {
+  double sigma;
+  explicit ExponentialPolicy(const Distribution& d) : sigma(d.sigma) { }
+  double Cdf(double t) const {
+    return 1.0 - std::exp(-t / sigma);
+  }
+  double Density(double t) const {
+    return std::exp(-t / sigma) / sigma;
+  }
+};
+struct LogNormalPolicy {
+  double sigma;
+  explicit LogNormalPolicy(const Distribution& d) : sigma(d.sigma) { }
+  double Cdf(double t) const {
+    if (t <= 0.0) return 0.0;
+    return 0.5 * std::erfc(-std::log(t) / (sigma * std::sqrt(2.0)));
+  }
+  double Density(double t) const {
+    if (t <= 0.0) return 0.0;
+    const double z = std::log(t) / sigma;
+    return std::exp(-0.5 * z * z) /
+      (t * sigma * std::sqrt(2.0 * 3.14159265358979323846));
+  }
+};
+  // The density falls linearly from t = 0 to t = range.
+struct TriangularPolicy {
+  double range;
+  explicit TriangularPolicy(const Distribution& d) : range(d.range) { }
+  double Cdf(double t) const {
+    if (t >= range) return 1.0;
+    const double rest = 1.0 - t / range;
+    return 1.0 - rest * rest;
+  }
+  double Density(double t) const {
+    return (t < range) ? (2.0 * (1.0 - t / range) / range) : 0.0;
+  }
+};
+  // The CDF is interpolated linearly between the points of the table.
+struct TablePolicy {
+  const double* table;
+  int last;
+  double step;
+  explicit TablePolicy(const Distribution& d)
+    : table(d.table.data()),
+      last(static_cast<int>(d.table.size()) - 1),
+      step(d.range / (d.table.size() - 1)) { }
+  double Cdf(double t) const {
+    const double u = t / step;
+    if (u >= last) return table[last];
+    const int i = static_cast<int>(u);
+    return table[i] + (table[i + 1] - table[i]) * (u - i);
+  }
+  double Density(double t) const {
+    const int i = static_cast<int>(t / step);
+    if (i >= last) return 0.0;
+    return (table[i + 1] - table[i]) / step;
+  }
+};
+
+  // The table must have 2 points at least, the CDF must not decrease and
+  // must be from 0 to 1.
+bool IsValidDistribution(const Distribution& distribution);
+
+  // The probability of every bucket, the sum is 1.
+void GetBucketProbabilities(
+    const Distribution& distribution,
+    int grid,
+    std::vector<double>* probabilities);
+
+  // The density at the centers of num columns dividing the range equally.
+void GetDensities(
+    const Distribution& distribution,
+    int num,
+    std::vector<double>* densities);
+
+  // The table is the text of the CDF values separated by the commas, the
+  // spaces or the lines.
+bool LoadDistributionTable(
+    const wchar_t* file_name,
+    std::vector<double>* table);
+
+#endif  // DISTRIBUTION_H_
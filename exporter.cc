@@ -0,0 +1,656 @@
+  // @file exporter.cc
+  // @brief Canvas export functions.
+  // @author Mamoru Kaminaga
+  // @date 2026-10-17
+  // Copyright 2026 Mamoru Kaminaga
+  // This program is provided with MIT license. See "LICENSE.md".
+#include <assert.h>
+#include <wchar.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+#include "./exporter.h"
+#include "./bitmap.h"
+#include "./canvas.h"
+#include "./cpu.h"
+#include "./mapped_file.h"
+#include "./palette.h"
+#include "./png.h"
+#include "./thread_pool.h"
+#include "./trace.h"
+#include "./common.h"
+
+#ifdef CPU_X86
+#include <immintrin.h>
+#endif
+
+  // The number of rows generated together by the streaming export.
+#define EXPORT_STREAM_ROWS  (16)
+
+  // The number of rows written by one task of the mapped export.
+#define EXPORT_MAP_ROWS     (64)
+
+  // The number of the compressed chunks of rows in one batch of the PNG.
+#define EXPORT_PNG_CHUNKS   (32)
+
+namespace {
+  // The palette is written to the 8 bit file and used for the RGB pixels.
+  // The 8 bit file holds up to 256 colors.
+bool CheckColors(const Palette& palette, int bit_number) {
+  const int kPaletteColorNum = 256;
+  return (bit_number != 8) || (palette.GetColorNum() <= kPaletteColorNum);
+}
+  // The packed color 0x00RRGGBB is BGRX in the memory, the RGB pixel of
+  // the PNG has the red and the blue swapped.
+template<bool RGB>
+inline uint32_t GetPixelColor(const uint32_t* colors, int color_id) {
+  const uint32_t c = colors[color_id];
+  return RGB ?
+    (((c & 0xFF) << 16) | (c & 0xFF00) | ((c >> 16) & 0xFF)) : c;
+}
+  // The row of the color ids is expanded to the 3 or 4 byte pixels. The
+  // id of a pixel is read before its bytes are written, the in-place
+  // expansion of the mapped rows depends on it.
+template<class INDEX, int PIXEL_BYTES, bool RGB>
+void ExpandPixels(
+    const INDEX* color_ids,
+    const uint32_t* colors,
+    int num,
+    uint8_t* row) {
+  for (int x = 0; x < num; ++x) {
+    const uint32_t c = GetPixelColor<RGB>(colors, color_ids[x]);
+    if (PIXEL_BYTES == 4) {
+      memcpy(&row[x * 4], &c, 4);
+    } else {
+      row[x * 3] = static_cast<uint8_t>(c);
+      row[x * 3 + 1] = static_cast<uint8_t>(c >> 8);
+      row[x * 3 + 2] = static_cast<uint8_t>(c >> 16);
+    }
+  }
+}
+#ifdef CPU_X86
+  // The eight color ids are widened to the gather indices.
+TARGET_AVX2 inline __m256i LoadIndices(const uint8_t* color_ids) {
+  return _mm256_cvtepu8_epi32(
+      _mm_loadl_epi64(reinterpret_cast<const __m128i*>(color_ids)));
+}
+TARGET_AVX2 inline __m256i LoadIndices(const uint16_t* color_ids) {
+  return _mm256_cvtepu16_epi32(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(color_ids)));
+}
+  // The AVX2 kernel gathers eight colors at once. The 3 byte pixels are
+  // shuffled out of every half and the halves are joined. Exactly 24 bytes
+  // are written after the eight ids are read, so the in-place expansion
+  // is kept safe.
+template<class INDEX, int PIXEL_BYTES, bool RGB>
+TARGET_AVX2 int ExpandPixelsAvx2(
+    const INDEX* color_ids,
+    const uint32_t* colors,
+    int num,
+    uint8_t* row) {
+  const int* table = reinterpret_cast<const int*>(colors);
+  const __m256i shuffle = RGB ?
+    _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1) :
+    _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+        0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+  const __m256i join = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7);
+  int x = 0;
+  for (; x + 8 <= num; x += 8) {
+    const __m256i pixels =
+      _mm256_i32gather_epi32(table, LoadIndices(&color_ids[x]), 4);
+    if (PIXEL_BYTES == 4) {
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(&row[x * 4]), pixels);
+      continue;
+    }
+    const __m256i packed = _mm256_permutevar8x32_epi32(
+        _mm256_shuffle_epi8(pixels, shuffle), join);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&row[x * 3]),
+        _mm256_castsi256_si128(packed));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(&row[x * 3 + 16]),
+        _mm256_extracti128_si256(packed, 1));
+  }
+  return x;
+}
+#endif
+template<class INDEX, int PIXEL_BYTES, bool RGB>
+void ExpandRow(
+    const INDEX* color_ids,
+    const uint32_t* colors,
+    int num,
+    uint8_t* row) {
+  int x = 0;
+#ifdef CPU_X86
+  if (CpuHasAvx2()) {
+    x = ExpandPixelsAvx2<INDEX, PIXEL_BYTES, RGB>(
+        color_ids, colors, num, row);
+  }
+#endif
+  ExpandPixels<INDEX, PIXEL_BYTES, RGB>(
+      &color_ids[x], colors, num - x, &row[x * PIXEL_BYTES]);
+}
+  // The BMP pixels are BGR or BGRX.
+template<class INDEX>
+void ExpandRow(
+    const INDEX* color_ids,
+    const uint32_t* colors,
+    int num,
+    int bit_number,
+    uint8_t* row) {
+  if (bit_number == 32) {
+    ExpandRow<INDEX, 4, false>(color_ids, colors, num, row);
+  } else {
+    ExpandRow<INDEX, 3, false>(color_ids, colors, num, row);
+  }
+}
+  // The PNG pixels are R, G, B.
+template<class INDEX>
+void ExpandRgbRow(
+    const INDEX* color_ids,
+    const uint32_t* colors,
+    int num,
+    uint8_t* row) {
+  ExpandRow<INDEX, 3, true>(color_ids, colors, num, row);
+}
+template<class INDEX>
+bool StreamBitmap(
+    const wchar_t* file_name,
+    const Vector2n& pixel,
+    const Palette& palette,
+    const IndexRowSource<INDEX>& source,
+    ThreadPool* pool,
+    int bit_number,
+    BITMAP_COMPRESSION compression) {
+  TRACE_SCOPE("StreamBitmap");
+
+  // The 8 bit file is written only from the 8 bit color ids, the rows are
+  // compressed by the writer.
+  const bool indexed = (bit_number == 8);
+  assert(!indexed || (sizeof(INDEX) == 1));
+  if (!CheckColors(palette, bit_number)) return false;
+  const uint32_t* colors = palette.GetPackedColors();
+
+  BitmapWriter writer;
+  bool result = writer.Open(
+      file_name,
+      pixel.x,
+      pixel.y,
+      bit_number,
+      colors,
+      indexed ? palette.GetColorNum() : 0,
+      compression);
+  if (!result) return false;
+
+  // The batch of rows is generated and encoded on the threads, the 8 bit
+  // rows are generated in place.
+  const int pixel_bytes = bit_number / 8;
+  std::vector<INDEX> color_ids(indexed ? 0 : (EXPORT_STREAM_ROWS * pixel.x));
+  std::vector<uint8_t> rows(EXPORT_STREAM_ROWS * pixel.x * pixel_bytes);
+  TRACE_ALLOC("StreamBitmap", static_cast<int64_t>(
+        color_ids.size() * sizeof(INDEX) + rows.size()));
+  int y_top = pixel.y;
+  auto task = [&](int row_id) {
+    const int y = y_top - 1 - row_id;
+    uint8_t* row = &rows[row_id * pixel.x * pixel_bytes];
+    if (indexed) {
+      source(y, reinterpret_cast<INDEX*>(row));
+    } else {
+      INDEX* ids = &color_ids[row_id * pixel.x];
+      source(y, ids);
+      ExpandRow(ids, colors, pixel.x, bit_number, row);
+    }
+  };
+
+  // The rows are written from the bottom row.
+  while (y_top > 0) {
+    const int row_num =
+      (y_top < EXPORT_STREAM_ROWS) ? y_top : EXPORT_STREAM_ROWS;
+    {
+      TRACE_SCOPE("MakeRows");
+      if (pool != nullptr) {
+        pool->Run(row_num, task);
+      } else {
+        for (int row_id = 0; row_id < row_num; ++row_id) task(row_id);
+      }
+    }
+    TRACE_SCOPE("WriteRows");
+    for (int row_id = 0; row_id < row_num && result; ++row_id) {
+      result = writer.WriteRow(&rows[row_id * pixel.x * pixel_bytes]);
+    }
+    if (!result) break;
+    y_top -= row_num;
+  }
+  return writer.Close() && result;
+}
+  // The headers, the color table and the rows of the uncompressed file are
+  // written into the memory of the whole file size.
+template<class INDEX>
+void FillBitmap(
+    const Vector2n& pixel,
+    const Palette& palette,
+    const IndexRowSource<INDEX>& source,
+    ThreadPool* pool,
+    int bit_number,
+    uint8_t* data) {
+  const bool indexed = (bit_number == 8);
+  assert(!indexed || (sizeof(INDEX) == 1));
+  const uint32_t* colors = palette.GetPackedColors();
+  const int color_num = indexed ? palette.GetColorNum() : 0;
+  MakeBitmapHeader(pixel.x, pixel.y, bit_number, color_num, data);
+  MakeBitmapColorTable(colors, color_num, &data[BITMAP_HEADER_SIZE]);
+
+  // Every task writes its own rows directly into the memory. The RGB row
+  // is generated into its tail and expanded forward in place, the color id
+  // is always read before its bytes are overwritten. The offset is rounded
+  // up to the index size, the row padding takes the extra byte and is
+  // cleared again.
+  const int row_bytes = GetBitmapRowBytes(pixel.x, bit_number);
+  const int pixel_bytes = bit_number / 8;
+  const int index_bytes = static_cast<int>(sizeof(INDEX));
+  const int ids_offset = indexed ? 0 :
+    (pixel.x * (pixel_bytes - index_bytes) + index_bytes - 1) /
+    index_bytes * index_bytes;
+  assert(ids_offset + pixel.x * index_bytes <= row_bytes);
+  uint8_t* image = &data[BITMAP_HEADER_SIZE + color_num * 4];
+  const int task_num = (pixel.y + EXPORT_MAP_ROWS - 1) / EXPORT_MAP_ROWS;
+  auto task = [&](int task_id) {
+    TRACE_SCOPE("MapRows");
+    const int y_begin = task_id * EXPORT_MAP_ROWS;
+    const int y_end = (y_begin + EXPORT_MAP_ROWS < pixel.y) ?
+      (y_begin + EXPORT_MAP_ROWS) : pixel.y;
+    for (int y = y_begin; y < y_end; ++y) {
+      uint8_t* row =
+        &image[static_cast<uint64_t>(row_bytes) * (pixel.y - 1 - y)];
+      INDEX* ids = reinterpret_cast<INDEX*>(&row[ids_offset]);
+      source(y, ids);
+      if (indexed) {
+        memset(&row[pixel.x], 0, row_bytes - pixel.x);
+        continue;
+      }
+      ExpandRow(ids, colors, pixel.x, bit_number, row);
+      memset(&row[pixel.x * pixel_bytes], 0, row_bytes - pixel.x * pixel_bytes);
+    }
+  };
+  if (pool != nullptr) {
+    pool->Run(task_num, task);
+  } else {
+    for (int task_id = 0; task_id < task_num; ++task_id) task(task_id);
+  }
+}
+  // The size of the uncompressed file.
+uint64_t GetBitmapFileBytes(
+    const Vector2n& pixel,
+    const Palette& palette,
+    int bit_number) {
+  const int color_num = (bit_number == 8) ? palette.GetColorNum() : 0;
+  const int row_bytes = GetBitmapRowBytes(pixel.x, bit_number);
+  return BITMAP_HEADER_SIZE + color_num * 4 +
+    static_cast<uint64_t>(row_bytes) * pixel.y;
+}
+template<class INDEX>
+bool MapBitmap(
+    const wchar_t* file_name,
+    const Vector2n& pixel,
+    const Palette& palette,
+    const IndexRowSource<INDEX>& source,
+    ThreadPool* pool,
+    int bit_number) {
+  TRACE_SCOPE("MapBitmap");
+  if (!CheckColors(palette, bit_number)) return false;
+
+  // The file is created in the full size and filled on the threads.
+  MappedFile file;
+  if (!file.Create(file_name, GetBitmapFileBytes(pixel, palette, bit_number))) {
+    return false;
+  }
+  FillBitmap(pixel, palette, source, pool, bit_number, file.GetData());
+  return file.Close();
+}
+template<class INDEX>
+bool StreamPng(
+    const wchar_t* file_name,
+    const Vector2n& pixel,
+    const Palette& palette,
+    const IndexRowSource<INDEX>& source,
+    const PngOption& option,
+    ThreadPool* pool,
+    int bit_number) {
+  TRACE_SCOPE("StreamPng");
+  const bool indexed = (bit_number == 8);
+  assert(!indexed || (sizeof(INDEX) == 1));
+  if (!CheckColors(palette, bit_number)) return false;
+  const uint32_t* colors = palette.GetPackedColors();
+
+  PngWriter writer;
+  bool result = writer.Open(
+      file_name,
+      pixel.x,
+      pixel.y,
+      bit_number,
+      colors,
+      indexed ? palette.GetColorNum() : 0,
+      option);
+  if (!result) return false;
+
+  // The batch of rows is generated on the threads from the top row, the
+  // writer compresses its chunks on the same threads.
+  const int pixel_bytes = bit_number / 8;
+  const int batch_rows = writer.GetChunkRows() * EXPORT_PNG_CHUNKS;
+  const int rows_num = (batch_rows < pixel.y) ? batch_rows : pixel.y;
+  std::vector<INDEX> color_ids(
+      indexed ? 0 : (static_cast<size_t>(rows_num) * pixel.x));
+  std::vector<uint8_t> rows(
+      static_cast<size_t>(rows_num) * pixel.x * pixel_bytes);
+  TRACE_ALLOC("StreamPng", static_cast<int64_t>(
+        color_ids.size() * sizeof(INDEX) + rows.size()));
+  int y_begin = 0;
+  auto task = [&](int row_id) {
+    const int y = y_begin + row_id;
+    uint8_t* row = &rows[static_cast<size_t>(row_id) * pixel.x * pixel_bytes];
+    if (indexed) {
+      source(y, reinterpret_cast<INDEX*>(row));
+    } else {
+      INDEX* ids = &color_ids[static_cast<size_t>(row_id) * pixel.x];
+      source(y, ids);
+      ExpandRgbRow(ids, colors, pixel.x, row);
+    }
+  };
+  while (y_begin < pixel.y) {
+    const int row_num = (pixel.y - y_begin < rows_num) ?
+      (pixel.y - y_begin) : rows_num;
+    {
+      TRACE_SCOPE("MakeRows");
+      if (pool != nullptr) {
+        pool->Run(row_num, task);
+      } else {
+        for (int row_id = 0; row_id < row_num; ++row_id) task(row_id);
+      }
+    }
+    result = writer.WriteRows(rows.data(), row_num, pool);
+    if (!result) break;
+    y_begin += row_num;
+  }
+  return writer.Close() && result;
+}
+template<class INDEX>
+bool ExportCanvas(
+    const wchar_t* file_name,
+    const Canvas& canvas,
+    const Palette& palette,
+    int bit_number,
+    BITMAP_COMPRESSION compression) {
+  // The rows of the canvas are unpacked into the file rows or expanded.
+  IndexRowSource<INDEX> source = [&canvas](int y, INDEX* color_ids) {
+    canvas.GetColorRow(y, color_ids);
+  };
+  return StreamBitmap(file_name, canvas.GetPixels(), palette, source,
+      nullptr, bit_number, compression);
+}
+bool ExportCanvas(
+    const wchar_t* file_name,
+    const Canvas& canvas,
+    const Palette& palette,
+    int bit_number,
+    BITMAP_COMPRESSION compression) {
+  if (canvas.GetIndexBits() == 8) {
+    return ExportCanvas<uint8_t>(
+        file_name, canvas, palette, bit_number, compression);
+  }
+  if (bit_number == 8) return false;
+  return ExportCanvas<uint16_t>(
+      file_name, canvas, palette, bit_number, compression);
+}
+template<class INDEX>
+void EncodeCanvas(
+    const Canvas& canvas,
+    const Palette& palette,
+    ThreadPool* pool,
+    int bit_number,
+    uint8_t* data) {
+  IndexRowSource<INDEX> source = [&canvas](int y, INDEX* color_ids) {
+    canvas.GetColorRow(y, color_ids);
+  };
+  FillBitmap(canvas.GetPixels(), palette, source, pool, bit_number, data);
+}
+template<class INDEX>
+bool ExportCanvasPng(
+    const wchar_t* file_name,
+    const Canvas& canvas,
+    const Palette& palette,
+    const PngOption& option,
+    ThreadPool* pool,
+    int bit_number) {
+  IndexRowSource<INDEX> source = [&canvas](int y, INDEX* color_ids) {
+    canvas.GetColorRow(y, color_ids);
+  };
+  return StreamPng(file_name, canvas.GetPixels(), palette, source, option,
+      pool, bit_number);
+}
+bool ExportCanvasPng(
+    const wchar_t* file_name,
+    const Canvas& canvas,
+    const Palette& palette,
+    const PngOption& option,
+    ThreadPool* pool,
+    int bit_number) {
+  if (canvas.GetIndexBits() == 8) {
+    return ExportCanvasPng<uint8_t>(
+        file_name, canvas, palette, option, pool, bit_number);
+  }
+  if (bit_number == 8) return false;
+  return ExportCanvasPng<uint16_t>(
+      file_name, canvas, palette, option, pool, bit_number);
+}
+}  // namespace
+
+bool ExportBitmapWin8(
+    const wchar_t* file_name,
+    const Canvas& canvas,
+    const Palette& palette) {
+  assert(file_name);
+  return ExportCanvas(
+      file_name, canvas, palette, 8, BITMAP_COMPRESSION_NONE);
+}
+bool ExportBitmapWin8Rle(
+    const wchar_t* file_name,
+    const Canvas& canvas,
+    const Palette& palette) {
+  assert(file_name);
+  return ExportCanvas(
+      file_name, canvas, palette, 8, BITMAP_COMPRESSION_RLE8);
+}
+bool ExportBitmapWin24(
+    const wchar_t* file_name,
+    const Canvas& canvas,
+    const Palette& palette) {
+  assert(file_name);
+  return ExportCanvas(
+      file_name, canvas, palette, 24, BITMAP_COMPRESSION_NONE);
+}
+bool ExportBitmapWin32(
+    const wchar_t* file_name,
+    const Canvas& canvas,
+    const Palette& palette) {
+  assert(file_name);
+  return ExportCanvas(
+      file_name, canvas, palette, 32, BITMAP_COMPRESSION_NONE);
+}
+bool StreamBitmapWin8(
+    const wchar_t* file_name,
+    const Vector2n& pixel,
+    const Palette& palette,
+    const RowSource& source,
+    ThreadPool* pool) {
+  assert(file_name);
+  return StreamBitmap(file_name, pixel, palette, source, pool, 8,
+      BITMAP_COMPRESSION_NONE);
+}
+bool StreamBitmapWin8Rle(
+    const wchar_t* file_name,
+    const Vector2n& pixel,
+    const Palette& palette,
+    const RowSource& source,
+    ThreadPool* pool) {
+  assert(file_name);
+  return StreamBitmap(file_name, pixel, palette, source, pool, 8,
+      BITMAP_COMPRESSION_RLE8);
+}
+bool StreamBitmapWin24(
+    const wchar_t* file_name,
+    const Vector2n& pixel,
+    const Palette& palette,
+    const RowSource& source,
+    ThreadPool* pool) {
+  assert(file_name);
+  return StreamBitmap(file_name, pixel, palette, source, pool, 24,
+      BITMAP_COMPRESSION_NONE);
+}
+bool StreamBitmapWin24(
+    const wchar_t* file_name,
+    const Vector2n& pixel,
+    const Palette& palette,
+    const WideRowSource& source,
+    ThreadPool* pool) {
+  assert(file_name);
+  return StreamBitmap(file_name, pixel, palette, source, pool, 24,
+      BITMAP_COMPRESSION_NONE);
+}
+bool StreamBitmapWin32(
+    const wchar_t* file_name,
+    const Vector2n& pixel,
+    const Palette& palette,
+    const RowSource& source,
+    ThreadPool* pool) {
+  assert(file_name);
+  return StreamBitmap(file_name, pixel, palette, source, pool, 32,
+      BITMAP_COMPRESSION_NONE);
+}
+bool StreamBitmapWin32(
+    const wchar_t* file_name,
+    const Vector2n& pixel,
+    const Palette& palette,
+    const WideRowSource& source,
+    ThreadPool* pool) {
+  assert(file_name);
+  return StreamBitmap(file_name, pixel, palette, source, pool, 32,
+      BITMAP_COMPRESSION_NONE);
+}
+bool MapBitmapWin8(
+    const wchar_t* file_name,
+    const Vector2n& pixel,
+    const Palette& palette,
+    const RowSource& source,
+    ThreadPool* pool) {
+  assert(file_name);
+  return MapBitmap(file_name, pixel, palette, source, pool, 8);
+}
+bool MapBitmapWin24(
+    const wchar_t* file_name,
+    const Vector2n& pixel,
+    const Palette& palette,
+    const RowSource& source,
+    ThreadPool* pool) {
+  assert(file_name);
+  return MapBitmap(file_name, pixel, palette, source, pool, 24);
+}
+bool MapBitmapWin24(
+    const wchar_t* file_name,
+    const Vector2n& pixel,
+    const Palette& palette,
+    const WideRowSource& source,
+    ThreadPool* pool) {
+  assert(file_name);
+  return MapBitmap(file_name, pixel, palette, source, pool, 24);
+}
+bool MapBitmapWin32(
+    const wchar_t* file_name,
+    const Vector2n& pixel,
+    const Palette& palette,
+    const RowSource& source,
+    ThreadPool* pool) {
+  assert(file_name);
+  return MapBitmap(file_name, pixel, palette, source, pool, 32);
+}
+bool MapBitmapWin32(
+    const wchar_t* file_name,
+    const Vector2n& pixel,
+    const Palette& palette,
+    const WideRowSource& source,
+    ThreadPool* pool) {
+  assert(file_name);
+  return MapBitmap(file_name, pixel, palette, source, pool, 32);
+}
+bool EncodeBitmapWin(
+    const Canvas& canvas,
+    const Palette& palette,
+    int bit_number,
+    ThreadPool* pool,
+    std::vector<uint8_t>* image) {
+  TRACE_SCOPE("EncodeBitmap");
+  assert((bit_number == 8) || (bit_number == 24) || (bit_number == 32));
+  assert(image);
+  if (!CheckColors(palette, bit_number)) return false;
+  const bool wide = (canvas.GetIndexBits() != 8);
+  if (wide && (bit_number == 8)) return false;
+  const uint64_t bytes =
+    GetBitmapFileBytes(canvas.GetPixels(), palette, bit_number);
+  if (bytes > SIZE_MAX) return false;
+
+  // The image keeps its capacity, the same size is not allocated again.
+  image->resize(static_cast<size_t>(bytes));
+  if (wide) {
+    EncodeCanvas<uint16_t>(canvas, palette, pool, bit_number, image->data());
+  } else {
+    EncodeCanvas<uint8_t>(canvas, palette, pool, bit_number, image->data());
+  }
+  return true;
+}
+bool ExportPng8(
+    const wchar_t* file_name,
+    const Canvas& canvas,
+    const Palette& palette,
+    const PngOption& option,
+    ThreadPool* pool) {
+  assert(file_name);
+  return ExportCanvasPng(file_name, canvas, palette, option, pool, 8);
+}
+bool ExportPng24(
+    const wchar_t* file_name,
+    const Canvas& canvas,
+    const Palette& palette,
+    const PngOption& option,
+    ThreadPool* pool) {
+  assert(file_name);
+  return ExportCanvasPng(file_name, canvas, palette, option, pool, 24);
+}
+bool StreamPng8(
+    const wchar_t* file_name,
+    const Vector2n& pixel,
+    const Palette& palette,
+    const RowSource& source,
+    const PngOption& option,
+    ThreadPool* pool) {
+  assert(file_name);
+  return StreamPng(file_name, pixel, palette, source, option, pool, 8);
+}
+bool StreamPng24(
+    const wchar_t* file_name,
+    const Vector2n& pixel,
+    const Palette& palette,
+    const RowSource& source,
+    const PngOption& option,
+    ThreadPool* pool) {
+  assert(file_name);
+  return StreamPng(file_name, pixel, palette, source, option, pool, 24);
+}
+bool StreamPng24(
+    const wchar_t* file_name,
+    const Vector2n& pixel,
+    const Palette& palette,
+    const WideRowSource& source,
+    const PngOption& option,
+    ThreadPool* pool) {
+  assert(file_name);
+  return StreamPng(file_name, pixel, palette, source, option, pool, 24);
+}
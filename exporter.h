@@ -0,0 +1,185 @@
+  // @file exporter.h
+  // @brief Canvas export functions.
+  // @author Mamoru Kaminaga
+  // @date 2026-10-17
+  // Copyright 2026 Mamoru Kaminaga
+  // This program is provided with MIT license. See "LICENSE.md".
+#ifndef EXPORTER_H_
+#define EXPORTER_H_
+
+#include <wchar.h>
+#include <stdint.h>
+#include <functional>
+#include <vector>
+
+#include "./canvas.h"
+#include "./palette.h"
+#include "./png.h"
+#include "./thread_pool.h"
+
+#include "./common.h"
+
+  // The source fills the color ids of the row y. It is called from the
+  // threads of the pool at the same time for the different rows.
+  // The wide source gives the 16 bit color ids of the large palette, they
+  // are written only to the 24 and 32 bit files.
+template<class INDEX>
+using IndexRowSource = std::function<void(int y, INDEX* color_ids)>;
+typedef IndexRowSource<uint8_t> RowSource;
+typedef IndexRowSource<uint16_t> WideRowSource;
+
+bool ExportBitmapWin8(
+    const wchar_t* file_name,
+    const Canvas& canvas,
+    const Palette& palette);
+
+  // The 8 bit rows are run length encoded by BI_RLE8, the file is small
+  // when the canvas has the wide areas of the same color.
+bool ExportBitmapWin8Rle(
+    const wchar_t* file_name,
+    const Canvas& canvas,
+    const Palette& palette);
+
+bool ExportBitmapWin24(
+    const wchar_t* file_name,
+    const Canvas& canvas,
+    const Palette& palette);
+
+  // The 32 bit pixels are BGRX, the same as the packed colors.
+bool ExportBitmapWin32(
+    const wchar_t* file_name,
+    const Canvas& canvas,
+    const Palette& palette);
+
+  // The rows are generated and written in small batches from the bottom
+  // row, so the memory does not depend on the image height.
+bool StreamBitmapWin8(
+    const wchar_t* file_name,
+    const Vector2n& pixel,
+    const Palette& palette,
+    const RowSource& source,
+    ThreadPool* pool);
+
+bool StreamBitmapWin8Rle(
+    const wchar_t* file_name,
+    const Vector2n& pixel,
+    const Palette& palette,
+    const RowSource& source,
+    ThreadPool* pool);
+
+bool StreamBitmapWin24(
+    const wchar_t* file_name,
+    const Vector2n& pixel,
+    const Palette& palette,
+    const RowSource& source,
+    ThreadPool* pool);
+
+bool StreamBitmapWin24(
+    const wchar_t* file_name,
+    const Vector2n& pixel,
+    const Palette& palette,
+    const WideRowSource& source,
+    ThreadPool* pool);
+
+bool StreamBitmapWin32(
+    const wchar_t* file_name,
+    const Vector2n& pixel,
+    const Palette& palette,
+    const RowSource& source,
+    ThreadPool* pool);
+
+bool StreamBitmapWin32(
+    const wchar_t* file_name,
+    const Vector2n& pixel,
+    const Palette& palette,
+    const WideRowSource& source,
+    ThreadPool* pool);
+
+  // The file is created in the full size and mapped into the memory, the
+  // threads of the pool write the disjoint rows directly into the file.
+bool MapBitmapWin8(
+    const wchar_t* file_name,
+    const Vector2n& pixel,
+    const Palette& palette,
+    const RowSource& source,
+    ThreadPool* pool);
+
+bool MapBitmapWin24(
+    const wchar_t* file_name,
+    const Vector2n& pixel,
+    const Palette& palette,
+    const RowSource& source,
+    ThreadPool* pool);
+
+bool MapBitmapWin24(
+    const wchar_t* file_name,
+    const Vector2n& pixel,
+    const Palette& palette,
+    const WideRowSource& source,
+    ThreadPool* pool);
+
+bool MapBitmapWin32(
+    const wchar_t* file_name,
+    const Vector2n& pixel,
+    const Palette& palette,
+    const RowSource& source,
+    ThreadPool* pool);
+
+bool MapBitmapWin32(
+    const wchar_t* file_name,
+    const Vector2n& pixel,
+    const Palette& palette,
+    const WideRowSource& source,
+    ThreadPool* pool);
+
+  // The whole uncompressed file of 8, 24 or 32 bits is made in the memory
+  // on the threads of the pool, the pool may be nullptr. The image of the
+  // same size is not allocated again.
+bool EncodeBitmapWin(
+    const Canvas& canvas,
+    const Palette& palette,
+    int bit_number,
+    ThreadPool* pool,
+    std::vector<uint8_t>* image);
+
+  // The PNG is compressed on the threads of the pool, the pool may be
+  // nullptr. The 8 bit PNG has the palette of up to 256 colors.
+bool ExportPng8(
+    const wchar_t* file_name,
+    const Canvas& canvas,
+    const Palette& palette,
+    const PngOption& option,
+    ThreadPool* pool);
+
+bool ExportPng24(
+    const wchar_t* file_name,
+    const Canvas& canvas,
+    const Palette& palette,
+    const PngOption& option,
+    ThreadPool* pool);
+
+bool StreamPng8(
+    const wchar_t* file_name,
+    const Vector2n& pixel,
+    const Palette& palette,
+    const RowSource& source,
+    const PngOption& option,
+    ThreadPool* pool);
+
+bool StreamPng24(
+    const wchar_t* file_name,
+    const Vector2n& pixel,
+    const Palette& palette,
+    const RowSource& source,
+    const PngOption& option,
+    ThreadPool* pool);
+
+bool StreamPng24(
+    const wchar_t* file_name,
+    const Vector2n& pixel,
+    const Palette& palette,
+    const WideRowSource& source,
+    const PngOption& option,
+    ThreadPool* pool);
+
+#endif  // EXPORTER_H_
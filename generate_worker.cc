@@ -0,0 +1,154 @@
+  // @file generate_worker.cc
+  // @brief Canvas generation on the worker thread.
+  // @author Mamoru Kaminaga
+  // @date 2026-10-17
+  // Copyright 2026 Mamoru Kaminaga
+  // This program is provided with MIT license. See "LICENSE.md".
+#include <assert.h>
+#include <stdint.h>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "./generate_worker.h"
+#include "./canvas.h"
+#include "./palette.h"
+#include "./range.h"
+#include "./thread_pool.h"
+#include "./trace.h"
+#include "./common.h"
+
+GenerateWorker::GenerateWorker()
+  : ready_seed_(0),
+    completed_num_(0),
+    canceled_num_(0),
+    running_(false),
+    ready_(false),
+    exit_(false) { }
+GenerateWorker::~GenerateWorker() {
+  Stop();
+}
+
+void GenerateWorker::Start(
+    const Canvas& canvas,
+    int thread_num,
+    const std::function<void()>& notify) {
+  assert(!thread_.joinable());
+  pool_.Create(thread_num);
+  back_.Init(canvas.GetPixels(), canvas.GetStorage());
+  back_.SetNoise(canvas.GetNoise());
+  back_.SetPreviewSize(canvas.GetSize());
+  back_.SetThreadPool(&pool_);
+  back_.SetJobControl(&control_);
+  notify_ = notify;
+  pending_.reset();
+  ready_ = false;
+  exit_ = false;
+  thread_ = std::thread(&GenerateWorker::Work, this);
+}
+void GenerateWorker::Stop() {
+  if (!thread_.joinable()) return;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    exit_ = true;
+    control_.Cancel();
+  }
+  wake_.notify_all();
+  thread_.join();
+  pool_.Destroy();
+}
+void GenerateWorker::Request(
+    const Palette& palette,
+    const Range& range,
+    uint32_t seed) {
+  // Only the colors and the mapping are copied, not the previews.
+  std::unique_ptr<Job> job(new Job());
+  job->palette.Init(palette.GetGrid());
+  job->palette.SetColors(palette.GetPackedColors(), palette.GetColorNum());
+  job->range.Init(range.GetGrid());
+  for (int grid_id = 0; grid_id < range.GetGrid(); ++grid_id) {
+    job->range.SetColorId(grid_id, range.GetColorId(grid_id));
+  }
+  job->range.SetDistribution(range.GetDistribution());
+  job->seed = seed;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_.swap(job);
+    if (running_) control_.Cancel();
+  }
+  wake_.notify_all();
+}
+void GenerateWorker::Cancel() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  pending_.reset();
+  if (running_) control_.Cancel();
+}
+bool GenerateWorker::Present(Canvas* canvas, uint32_t* seed) {
+  assert(canvas);
+  assert(seed);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!ready_) return false;
+    canvas->SwapPixels(&back_);
+    *seed = ready_seed_;
+    ready_ = false;
+  }
+  wake_.notify_all();
+  return true;
+}
+bool GenerateWorker::IsBusy() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return running_ || (pending_ != nullptr);
+}
+double GenerateWorker::GetProgress() const {
+  return control_.GetProgress();
+}
+int GenerateWorker::GetCompletedNum() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return completed_num_;
+}
+int GenerateWorker::GetCanceledNum() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return canceled_num_;
+}
+
+void GenerateWorker::Work() {
+  for (;;) {
+    // The request waits until the ready canvas is presented.
+    std::unique_ptr<Job> job;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      wake_.wait(lock, [this] {
+        return exit_ || ((pending_ != nullptr) && !ready_);
+      });
+      if (exit_) return;
+      job.swap(pending_);
+      running_ = true;
+      control_.Reset();
+    }
+    {
+      TRACE_SCOPE("GenerateWorker::Job");
+      back_.Update(job->palette, job->range, job->seed);
+
+      // The preview levels are also built here, not on the caller thread.
+      if (!control_.IsCanceled()) back_.BuildPreview(job->palette);
+    }
+
+    // The canvas canceled halfway is not presented.
+    bool ready = false;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      running_ = false;
+      if (control_.IsCanceled()) {
+        ++canceled_num_;
+      } else {
+        ++completed_num_;
+        ready_ = true;
+        ready_seed_ = job->seed;
+        ready = true;
+      }
+    }
+    if (ready && notify_) notify_();
+  }
+}
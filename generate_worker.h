@@ -0,0 +1,87 @@
+  // @file generate_worker.h
+  // @brief Canvas generation on the worker thread.
+  // @author Mamoru Kaminaga
+  // @date 2026-10-17
+  // Copyright 2026 Mamoru Kaminaga
+  // This program is provided with MIT license. See "LICENSE.md".
+#ifndef GENERATE_WORKER_H_
+#define GENERATE_WORKER_H_
+
+#include <stdint.h>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "./canvas.h"
+#include "./palette.h"
+#include "./range.h"
+#include "./thread_pool.h"
+
+#include "./common.h"
+
+  // The canvas is generated on the worker thread into the back canvas, the
+  // front canvas of the caller is not touched until it is presented.
+  // The request takes the copy of the palette and the range. The newer
+  // request cancels the running job and replaces the request not started,
+  // so the burst of the requests makes one canvas of the latest request.
+  // The back canvas is kept until presented, the next job waits for it.
+class GenerateWorker {
+ public:
+  GenerateWorker();
+  ~GenerateWorker();
+
+  // The back canvas has the settings of the canvas, its pixels are drawn
+  // by the own pool of the number of threads, so the jobs of the caller on
+  // the other pools do not wait for the worker. The notify is called on the
+  // worker thread when the back canvas is ready to be presented.
+  void Start(
+      const Canvas& canvas,
+      int thread_num,
+      const std::function<void()>& notify);
+  void Stop();
+
+  void Request(const Palette& palette, const Range& range, uint32_t seed);
+  // The running job and the request not started are canceled.
+  void Cancel();
+
+  // The ready pixels are swapped into the canvas, false is returned when
+  // no canvas is ready. The seed is of the presented canvas.
+  bool Present(Canvas* canvas, uint32_t* seed);
+
+  // The worker is busy while a job runs or a request waits. The progress
+  // is of the running job, from 0 to 1.
+  bool IsBusy() const;
+  double GetProgress() const;
+
+  // The number of the canvases completed and the jobs canceled.
+  int GetCompletedNum() const;
+  int GetCanceledNum() const;
+
+ private:
+  struct Job {
+    Palette palette;
+    Range range;
+    uint32_t seed;
+  };
+  void Work();
+
+ private:
+  std::thread thread_;
+  mutable std::mutex mutex_;
+  std::condition_variable wake_;
+  std::function<void()> notify_;
+  ThreadPool pool_;
+  Canvas back_;
+  JobControl control_;
+  std::unique_ptr<Job> pending_;
+  uint32_t ready_seed_;
+  int completed_num_;
+  int canceled_num_;
+  bool running_;
+  bool ready_;
+  bool exit_;
+};
+
+#endif  // GENERATE_WORKER_H_
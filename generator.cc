@@ -0,0 +1,194 @@
+  // @file generator.cc
+  // @brief Generator class.
+  // @author Mamoru Kaminaga
+  // @date 2026-10-17
+  // Copyright 2026 Mamoru Kaminaga
+  // This program is provided with MIT license. See "LICENSE.md".
+#include <assert.h>
+#include <stdint.h>
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "./generator.h"
+#include "./cpu.h"
+#include "./noise.h"
+#include "./random.h"
+#include "./range.h"
+#include "./sampler.h"
+
+#ifdef CPU_X86
+#include <emmintrin.h>
+#endif
+
+  // The narrow spans are generated through the buffer of this size.
+#define GENERATOR_CHUNK_PIXELS  (1024)
+
+  // The noise values of up to this number of columns and rows are sampled
+  // to equalize the noise field.
+#define GENERATOR_NOISE_SAMPLES (256)
+
+  // The thresholds of up to this number of grids are compared all at once
+  // by SSE2, the more grids are searched.
+#define GENERATOR_LINEAR_GRID   (64)
+
+Generator::Generator() : width_(0), noise_(false), threshold_step_(0) { }
+
+void Generator::Init(const Range& range, uint32_t seed, int width) {
+  // Grid of range is acquired.
+  const int range_grid = range.GetGrid();
+  grid_color_id_.resize(range_grid);
+  for (int grid_id = 0; grid_id < range_grid; ++grid_id) {
+    grid_color_id_[grid_id] = range.GetColorId(grid_id);
+  }
+
+  // Colors are distributed according to the distribution of the range.
+  // The bucket probabilities are fixed by the grid, so one uniform draw
+  // selects the bucket through the alias table.
+  sampler_.Init(range_grid, range.GetDistribution());
+  random_.Seed(seed);
+  width_ = width;
+  noise_ = false;
+}
+void Generator::Init(
+    const Range& range,
+    uint32_t seed,
+    const Vector2n& pixel,
+    const Noise& noise) {
+  Init(range, seed, pixel.x);
+  if (noise.type == NOISE_NONE) return;
+  noise_field_.Init(noise, seed, pixel);
+  MakeNoiseThresholds(pixel);
+  noise_ = true;
+}
+void Generator::GenerateSpan(int x, int y, int num, int* color_ids) const {
+  GenerateBucketSpan(x, y, num, color_ids);
+  for (int i = 0; i < num; ++i) {
+    color_ids[i] = grid_color_id_[color_ids[i]];
+  }
+}
+void Generator::GenerateSpan(int x, int y, int num, uint8_t* color_ids) const {
+  GenerateIndexSpan(x, y, num, color_ids);
+}
+void Generator::GenerateSpan(
+    int x,
+    int y,
+    int num,
+    uint16_t* color_ids) const {
+  GenerateIndexSpan(x, y, num, color_ids);
+}
+void Generator::GenerateBucketSpan(
+    int x,
+    int y,
+    int num,
+    int* bucket_ids) const {
+  assert(bucket_ids);
+  assert((x >= 0) && (x + num <= width_));
+
+  if (noise_) {
+    GenerateNoiseSpan(x, y, num, bucket_ids);
+    return;
+  }
+
+  // The random values are keyed by the pixel index.
+  const uint64_t first = static_cast<uint64_t>(y) * width_ + x;
+  random_.SampleBuckets(sampler_, first, bucket_ids, num);
+}
+
+template<class INDEX>
+void Generator::GenerateIndexSpan(
+    int x,
+    int y,
+    int num,
+    INDEX* color_ids) const {
+  assert(color_ids);
+
+  // The buckets are sampled through the small buffer.
+  int bucket_ids[GENERATOR_CHUNK_PIXELS];
+  for (int i = 0; i < num; i += GENERATOR_CHUNK_PIXELS) {
+    const int chunk = (num - i < GENERATOR_CHUNK_PIXELS) ?
+      (num - i) : GENERATOR_CHUNK_PIXELS;
+    GenerateBucketSpan(x + i, y, chunk, bucket_ids);
+    for (int j = 0; j < chunk; ++j) {
+      color_ids[i + j] = static_cast<INDEX>(grid_color_id_[bucket_ids[j]]);
+    }
+  }
+}
+void Generator::GenerateNoiseSpan(
+    int x,
+    int y,
+    int num,
+    int* bucket_ids) const {
+  // The bucket is the number of the thresholds not above the value. The
+  // few thresholds are compared with four values at once, the others are
+  // found by the branchless binary search of the padded thresholds.
+  const float* threshold = noise_threshold_.data();
+#ifdef CPU_X86
+  const int threshold_num = sampler_.GetGrid() - 1;
+#endif
+  float values[GENERATOR_CHUNK_PIXELS];
+  for (int i = 0; i < num; i += GENERATOR_CHUNK_PIXELS) {
+    const int chunk = (num - i < GENERATOR_CHUNK_PIXELS) ?
+      (num - i) : GENERATOR_CHUNK_PIXELS;
+    noise_field_.Evaluate(x + i, y, chunk, values);
+    int j = 0;
+#ifdef CPU_X86
+    if (threshold_num < GENERATOR_LINEAR_GRID) {
+      for (; j + 4 <= chunk; j += 4) {
+        const __m128 value = _mm_loadu_ps(&values[j]);
+        __m128i count = _mm_setzero_si128();
+        for (int k = 0; k < threshold_num; ++k) {
+          const __m128 below = _mm_cmple_ps(_mm_set1_ps(threshold[k]), value);
+          count = _mm_sub_epi32(count, _mm_castps_si128(below));
+        }
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(&bucket_ids[i + j]), count);
+      }
+    }
+#endif
+    for (; j < chunk; ++j) {
+      const float value = values[j];
+      int base = 0;
+      for (int step = threshold_step_; step > 0; step >>= 1) {
+        base += (threshold[base + step - 1] <= value) ? step : 0;
+      }
+      bucket_ids[i + j] = base;
+    }
+  }
+}
+void Generator::MakeNoiseThresholds(const Vector2n& pixel) {
+  // The noise values are not uniform, so the field is sampled on the even
+  // grid and the buckets take the quantiles of their probabilities. The
+  // thresholds depend only on the seed and the canvas size.
+  const int sample_x = (pixel.x < GENERATOR_NOISE_SAMPLES) ?
+    pixel.x : GENERATOR_NOISE_SAMPLES;
+  const int sample_y = (pixel.y < GENERATOR_NOISE_SAMPLES) ?
+    pixel.y : GENERATOR_NOISE_SAMPLES;
+  std::vector<float> samples(static_cast<size_t>(sample_x) * sample_y);
+  std::vector<float> row(pixel.x);
+  for (int i = 0; i < sample_y; ++i) {
+    const int y =
+      static_cast<int>(static_cast<int64_t>(i) * pixel.y / sample_y);
+    noise_field_.Evaluate(0, y, pixel.x, row.data());
+    for (int j = 0; j < sample_x; ++j) {
+      const int x =
+        static_cast<int>(static_cast<int64_t>(j) * pixel.x / sample_x);
+      samples[i * sample_x + j] = row[x];
+    }
+  }
+  std::sort(samples.begin(), samples.end());
+
+  // The thresholds are padded to the power of two by the infinity.
+  const int grid = sampler_.GetGrid();
+  int size = 1;
+  while (size < grid) size <<= 1;
+  threshold_step_ = size >> 1;
+  noise_threshold_.assign(size - 1, std::numeric_limits<float>::infinity());
+  const size_t sample_num = samples.size();
+  double cumulative = 0.0;
+  for (int grid_id = 0; grid_id < grid - 1; ++grid_id) {
+    cumulative += sampler_.GetProbability(grid_id);
+    const size_t k = static_cast<size_t>(cumulative * sample_num);
+    if (k < sample_num) noise_threshold_[grid_id] = samples[k];
+  }
+}
@@ -0,0 +1,57 @@
+  // @file generator.h
+  // @brief Generator class.
+  // @author Mamoru Kaminaga
+  // @date 2026-10-17
+  // Copyright 2026 Mamoru Kaminaga
+  // This program is provided with MIT license. See "LICENSE.md".
+#ifndef GENERATOR_H_
+#define GENERATOR_H_
+
+#include <stdint.h>
+#include <vector>
+
+#include "./noise.h"
+#include "./random.h"
+#include "./range.h"
+#include "./sampler.h"
+
+  // The color ids of any span of pixels are generated for the seed.
+  // The color of a pixel depends only on the seed, the range and the pixel
+  // position, so the spans may be generated in any order on any thread.
+  // With the noise the buckets follow the noise field of the canvas size,
+  // the neighbor pixels take the near buckets.
+class Generator {
+ public:
+  Generator();
+
+  void Init(const Range& range, uint32_t seed, int width);
+  void Init(
+      const Range& range,
+      uint32_t seed,
+      const Vector2n& pixel,
+      const Noise& noise);
+
+  // The span from (x, y) to (x + num - 1, y) is generated.
+  void GenerateSpan(int x, int y, int num, int* color_ids) const;
+  void GenerateSpan(int x, int y, int num, uint8_t* color_ids) const;
+  void GenerateSpan(int x, int y, int num, uint16_t* color_ids) const;
+  void GenerateBucketSpan(int x, int y, int num, int* bucket_ids) const;
+
+ private:
+  template<class INDEX>
+  void GenerateIndexSpan(int x, int y, int num, INDEX* color_ids) const;
+  void GenerateNoiseSpan(int x, int y, int num, int* bucket_ids) const;
+  void MakeNoiseThresholds(const Vector2n& pixel);
+
+ private:
+  int width_;
+  BucketSampler sampler_;
+  PixelRandom random_;
+  std::vector<int> grid_color_id_;
+  bool noise_;
+  NoiseField noise_field_;
+  int threshold_step_;
+  std::vector<float> noise_threshold_;
+};
+
+#endif  // GENERATOR_H_
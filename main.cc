@@ -8,12 +8,15 @@
 #include <wchar.h>
 #include <windows.h>
 #include <windowsx.h>
-#include <stdint.h>
 #include <memory>
+#include <random>
 
 #include "./canvas.h"
+#include "./exporter.h"
+#include "./generate_worker.h"
 #include "./palette.h"
 #include "./range.h"
+#include "./thread_pool.h"
 #include "./utility.h"
 
 #include "./resource.h"
@@ -21,12 +24,33 @@
 #define RANGE_IMAGE_FILE    L"./data/normal_distribution.png"
 #define DEFAULT_COLOR_FILE  L"./colors/default.txt"
 
+  // The worker posts this message when the canvas is ready, the timer shows
+  // the progress in the title while the worker is busy.
+#define WM_GENERATED        (WM_APP + 1)
+#define GENERATE_TIMER_ID   (1)
+#define GENERATE_TIMER_MS   (100)
+
 namespace {
   // File scope variables.
 std::unique_ptr<Palette> palette;
 std::unique_ptr<Range> range;
 std::unique_ptr<Canvas> canvas;
+std::unique_ptr<ThreadPool> pool;
+std::unique_ptr<GenerateWorker> worker;
+wchar_t title[MAX_PATH] = {0};
 
+  // Only the changed cells of the panels are drawn and copied.
+void Repaint(HWND hwnd) {
+  palette->Paint(hwnd);
+  range->Paint(hwnd, *palette.get());
+  canvas->Paint(hwnd, *palette.get());
+#ifdef DEBUG
+  wprintf(L"cells drawn : palette %d, range %d, canvas %d\n",
+      palette->GetRaster().GetFrameCellNum(),
+      range->GetRaster().GetFrameCellNum(),
+      canvas->GetRaster().GetFrameCellNum());
+#endif
+}
 BOOL OnCreate(HWND hwnd, HWND hwnd_forcus, LPARAM lp) {
   // The palette class is created.
   const Vector2n pallete_grids(16, 16);
@@ -38,11 +62,26 @@ BOOL OnCreate(HWND hwnd, HWND hwnd_forcus, LPARAM lp) {
   range.reset(new Range());
   range->Create(hwnd, range_grids, RANGE_IMAGE_FILE);
 
+  // The thread pool is created for the preview and the export on the dialog
+  // thread.
+  pool.reset(new ThreadPool());
+  pool->Create(ThreadPool::GetHardwareThreadNum());
+
   // The canvas class is created.
   const Vector2n pixel(64, 64);
   canvas.reset(new Canvas());
+  canvas->SetThreadPool(pool.get());
   canvas->Create(hwnd, pixel, *palette.get(), *range.get());
 
+  // The canvas is generated on the worker thread, the dialog is not blocked.
+  // The worker has its own pool, so the repaints and the exports on the
+  // pool of the dialog do not wait for the generation.
+  GetWindowText(hwnd, title, MAX_PATH);
+  worker.reset(new GenerateWorker());
+  worker->Start(*canvas.get(), ThreadPool::GetHardwareThreadNum(), [hwnd]() {
+    PostMessage(hwnd, WM_GENERATED, 0, 0);
+  });
+
   // The WM_PAINT message is sent to the client window.
   InvalidateRect(hwnd, nullptr, FALSE);
 
@@ -52,6 +91,11 @@ BOOL OnCreate(HWND hwnd, HWND hwnd_forcus, LPARAM lp) {
   return TRUE;
 }
 void OnDestroy(HWND hwnd) {
+  // The worker is stopped before the canvas and the pool.
+  KillTimer(hwnd, GENERATE_TIMER_ID);
+  worker->Stop();
+  worker.reset();
+
   // The palette class is destroyed.
   palette->Destroy(hwnd);
   palette.reset();
@@ -64,6 +108,10 @@ void OnDestroy(HWND hwnd) {
   canvas->Destroy(hwnd);
   canvas.reset();
 
+  // The thread pool is destroyed.
+  pool->Destroy();
+  pool.reset();
+
   // Warnings are prevented for non-used parameters.
   UNREFERENCED_PARAMETER(hwnd);
 }
@@ -80,16 +128,20 @@ void OnCommand(HWND hwnd, int id, HWND hwnd_ctrl, UINT code_notify) {
         palette->Destroy(hwnd);
         palette->Create(hwnd, pallete_grids, true, file_name);
 
-        // The WM_PAINT message is sent to the client window.
-        InvalidateRect(hwnd, nullptr, FALSE);
+        // The colors of the range and the canvas are changed too.
+        range->Invalidate();
+        canvas->Invalidate();
+        Repaint(hwnd);
       }
       break;
     case IDC_GENERATE:
-      // The canvas pixels are drawn in random following normal distribution.
-      canvas->Update(*palette.get(), *range.get());
-
-      // The WM_PAINT message is sent to the client window.
-      InvalidateRect(hwnd, nullptr, FALSE);
+      {
+        // The canvas pixels are drawn in random following normal
+        // distribution on the worker, the clicks while it runs are merged.
+        std::random_device seed_gen;
+        worker->Request(*palette.get(), *range.get(), seed_gen());
+        SetTimer(hwnd, GENERATE_TIMER_ID, GENERATE_TIMER_MS, nullptr);
+      }
       break;
     case IDC_EXPORT:
       {
@@ -100,67 +152,51 @@ void OnCommand(HWND hwnd, int id, HWND hwnd_ctrl, UINT code_notify) {
 
         switch (filter_index) {
           case FILTERINDEX_WIN_8BIT_BITMAP:
-            {
-              // Palette buffer is created.
-              Vector2n pallet_grids = palette->GetGrid();
-              const int color_num = pallet_grids.x * pallet_grids.y;
-              std::vector<RGBVecotr> colors(color_num);
-              for (int color_id = 0; color_id < color_num; ++color_id) {
-                colors[color_id] = palette->GetColor(color_id);
-              }
-
-              // Vector buffer is created.
-              Vector2n pixel = canvas->GetPixels();
-              int index_num = pixel.x * pixel.y;
-              std::vector<uint8_t> indeces(index_num);
-              for (int pixel_id = 0; pixel_id < index_num; ++pixel_id) {
-                indeces[pixel_id] =
-                  static_cast<uint8_t>(canvas->GetColorId(pixel_id));
-              }
-
-              // The file is created.
-              bool result = CreateBitmapWin8(
-                  file_name,
-                  pixel.x,
-                  pixel.y,
-                  colors.data(),
-                  color_num,
-                  indeces.data(),
-                  index_num);
-              if (!result) {
-                MessageBox(
-                    hwnd,
-                    L"Failed to create bitmap file",
-                    L"Error",
-                    MB_OK);
-              }
+            if (!ExportBitmapWin8(file_name, *canvas.get(), *palette.get())) {
+              MessageBox(
+                  hwnd,
+                  L"Failed to create bitmap file",
+                  L"Error",
+                  MB_OK);
+            }
+            break;
+          case FILTERINDEX_WIN_8BIT_RLE_BITMAP:
+            if (!ExportBitmapWin8Rle(
+                file_name, *canvas.get(), *palette.get())) {
+              MessageBox(
+                  hwnd,
+                  L"Failed to create bitmap file",
+                  L"Error",
+                  MB_OK);
             }
             break;
           case FILTERINDEX_WIN_24BIT_BITMAP:
-            {
-              // RGB buffer is created.
-              Vector2n pixel = canvas->GetPixels();
-              int array_size = pixel.x * pixel.y;
-              std::vector<RGBVecotr> array(array_size);
-              for (int pixel_id = 0; pixel_id < array_size; ++pixel_id) {
-                array[pixel_id] =
-                  palette->GetColor(canvas->GetColorId(pixel_id));
-              }
-
-              // The file is created.
-              bool result = CreateBitmapWin24(
-                  file_name,
-                  pixel.x,
-                  pixel.y,
-                  array.data(),
-                  array_size);
-              if (!result) {
-                MessageBox(
-                    hwnd,
-                    L"Failed to create bitmap file",
-                    L"Error",
-                    MB_OK);
-              }
+            if (!ExportBitmapWin24(file_name, *canvas.get(), *palette.get())) {
+              MessageBox(
+                  hwnd,
+                  L"Failed to create bitmap file",
+                  L"Error",
+                  MB_OK);
+            }
+            break;
+          case FILTERINDEX_PNG_8BIT:
+            if (!ExportPng8(file_name, *canvas.get(), *palette.get(),
+                PngOption(), pool.get())) {
+              MessageBox(
+                  hwnd,
+                  L"Failed to create PNG file",
+                  L"Error",
+                  MB_OK);
+            }
+            break;
+          case FILTERINDEX_PNG_24BIT:
+            if (!ExportPng24(file_name, *canvas.get(), *palette.get(),
+                PngOption(), pool.get())) {
+              MessageBox(
+                  hwnd,
+                  L"Failed to create PNG file",
+                  L"Error",
+                  MB_OK);
             }
             break;
           default:
@@ -188,8 +224,8 @@ void OnLButtonDown(HWND hwnd, BOOL double_click, int x, int y, UINT key_flags) {
     range->SelectGrid(hwnd, x, y);
   }
 
-  // The WM_PAINT message is sent to the client window.
-  InvalidateRect(hwnd, nullptr, FALSE);
+  // Only the changed cells are drawn.
+  Repaint(hwnd);
 
   // Warnings are prevented for non-used parameters.
   UNREFERENCED_PARAMETER(double_click);
@@ -202,30 +238,43 @@ void OnRButtonDown(HWND hwnd, BOOL double_click, int x, int y, UINT key_flags) {
     range->SetAllColor(hwnd, *palette.get());
   }
 
-  // The WM_PAINT message is sent to the client window.
-  InvalidateRect(hwnd, nullptr, FALSE);
+  // Only the changed cells are drawn.
+  Repaint(hwnd);
 
   // Warnings are prevented for non-used parameters.
   UNREFERENCED_PARAMETER(double_click);
   UNREFERENCED_PARAMETER(key_flags);
 }
+void OnTimer(HWND hwnd, UINT id) {
+  if (id != GENERATE_TIMER_ID) return;
+  wchar_t text[MAX_PATH] = {0};
+  swprintf(text, MAX_PATH, L"%s - generating %d%%", title,
+      static_cast<int>(worker->GetProgress() * 100.0));
+  SetWindowText(hwnd, text);
+}
+void OnGenerated(HWND hwnd) {
+  // The ready canvas is shown, the title is restored when no request is
+  // left.
+  uint32_t seed = 0;
+  if (worker->Present(canvas.get(), &seed)) Repaint(hwnd);
+  if (!worker->IsBusy()) {
+    KillTimer(hwnd, GENERATE_TIMER_ID);
+    SetWindowText(hwnd, title);
+  }
+}
 void OnClose(HWND hwnd) {
   // The main dialog is a modal dialog.
   EndDialog(hwnd, TRUE);
 }
 void OnPaint(HWND hwnd) {
-  // The palette is drawn.
-  palette->Paint(hwnd);
-
-  // The range is drawn.
-  range->Paint(hwnd, *palette.get());
-
-  // The canvas is drawn.
-  canvas->Paint(hwnd, *palette.get());
-
-  // BeginPaint and EndPaint is called to clear WM_PAINT message.
+  // The panels are copied to the screen again, the cells are not drawn
+  // again unless they are changed.
   PAINTSTRUCT ps;
   BeginPaint(hwnd, &ps);
+  palette->Expose();
+  range->Expose();
+  canvas->Expose();
+  Repaint(hwnd);
   EndPaint(hwnd, &ps);
 }
 INT_PTR CALLBACK DialogProc(HWND hwnd, UINT msg, WPARAM wp, LPARAM lp) {
@@ -237,6 +286,10 @@ INT_PTR CALLBACK DialogProc(HWND hwnd, UINT msg, WPARAM wp, LPARAM lp) {
     HANDLE_DLG_MSG(hwnd, WM_RBUTTONDOWN, OnRButtonDown);
     HANDLE_DLG_MSG(hwnd, WM_PAINT, OnPaint);
     HANDLE_DLG_MSG(hwnd, WM_CLOSE, OnClose);
+    HANDLE_DLG_MSG(hwnd, WM_TIMER, OnTimer);
+    case WM_GENERATED:
+      OnGenerated(hwnd);
+      return TRUE;
     default:
       return FALSE;
   }
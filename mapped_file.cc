@@ -0,0 +1,147 @@
+  // @file mapped_file.cc
+  // @brief MappedFile class.
+  // @author Mamoru Kaminaga
+  // @date 2026-10-17
+  // Copyright 2026 Mamoru Kaminaga
+  // This program is provided with MIT license. See "LICENSE.md".
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <assert.h>
+#include <stdlib.h>
+#include <wchar.h>
+#include <stdint.h>
+#include <vector>
+
+#include "./mapped_file.h"
+#include "./common.h"
+
+#ifdef _WIN32
+MappedFile::MappedFile()
+  : file_(INVALID_HANDLE_VALUE),
+    mapping_(nullptr),
+    data_(nullptr),
+    size_(0) { }
+#else
+MappedFile::MappedFile()
+  : fd_(-1),
+    data_(nullptr),
+    size_(0) { }
+#endif
+MappedFile::~MappedFile() {
+  Close();
+}
+
+bool MappedFile::Create(const wchar_t* file_name, uint64_t size) {
+  assert(file_name);
+  assert(size > 0);
+  assert(data_ == nullptr);
+  if (static_cast<uint64_t>(static_cast<size_t>(size)) != size) return false;
+
+#ifdef _WIN32
+  // The mapping of the given size extends the new file.
+  file_ = CreateFileW(
+      file_name,
+      GENERIC_READ | GENERIC_WRITE,
+      0,
+      nullptr,
+      CREATE_ALWAYS,
+      FILE_ATTRIBUTE_NORMAL,
+      nullptr);
+  if (file_ == INVALID_HANDLE_VALUE) return false;
+  mapping_ = CreateFileMappingW(
+      file_,
+      nullptr,
+      PAGE_READWRITE,
+      static_cast<DWORD>(size >> 32),
+      static_cast<DWORD>(size & 0xffffffff),
+      nullptr);
+  if (mapping_ == nullptr) {
+    Close();
+    return false;
+  }
+  data_ = static_cast<uint8_t*>(MapViewOfFile(
+      mapping_, FILE_MAP_WRITE, 0, 0, static_cast<SIZE_T>(size)));
+#else
+  // The wide names are converted to the multi byte names of the locale.
+  const size_t name_size = wcstombs(nullptr, file_name, 0);
+  if (name_size == static_cast<size_t>(-1)) return false;
+  std::vector<char> name(name_size + 1);
+  wcstombs(name.data(), file_name, name.size());
+  fd_ = open(name.data(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd_ < 0) return false;
+
+  // The blocks are reserved first, the full disk fails here instead of
+  // faulting the writes to the mapping.
+  if (ftruncate(fd_, static_cast<off_t>(size)) != 0) {
+    Close();
+    return false;
+  }
+#ifdef __linux__
+  if (posix_fallocate(fd_, 0, static_cast<off_t>(size)) != 0) {
+    Close();
+    return false;
+  }
+#endif
+  void* data = mmap(
+      nullptr,
+      static_cast<size_t>(size),
+      PROT_READ | PROT_WRITE,
+      MAP_SHARED,
+      fd_,
+      0);
+  data_ = (data != MAP_FAILED) ? static_cast<uint8_t*>(data) : nullptr;
+#endif
+  if (data_ == nullptr) {
+    Close();
+    return false;
+  }
+  size_ = size;
+  return true;
+}
+uint8_t* MappedFile::GetData() {
+  return data_;
+}
+uint64_t MappedFile::GetSize() const {
+  return size_;
+}
+bool MappedFile::Close() {
+  bool result = true;
+#ifdef _WIN32
+  if (data_ != nullptr) {
+    if (!FlushViewOfFile(data_, 0)) result = false;
+    if (!UnmapViewOfFile(data_)) result = false;
+  }
+  if (mapping_ != nullptr) CloseHandle(mapping_);
+  if (file_ != INVALID_HANDLE_VALUE) {
+    if ((data_ != nullptr) && !FlushFileBuffers(file_)) result = false;
+    CloseHandle(file_);
+  } else {
+    result = false;
+  }
+  mapping_ = nullptr;
+  file_ = INVALID_HANDLE_VALUE;
+#else
+  if (data_ != nullptr) {
+    if (msync(data_, static_cast<size_t>(size_), MS_SYNC) != 0) {
+      result = false;
+    }
+    if (munmap(data_, static_cast<size_t>(size_)) != 0) result = false;
+  }
+  if (fd_ >= 0) {
+    if ((data_ != nullptr) && (fsync(fd_) != 0)) result = false;
+    if (close(fd_) != 0) result = false;
+  } else {
+    result = false;
+  }
+  fd_ = -1;
+#endif
+  data_ = nullptr;
+  size_ = 0;
+  return result;
+}
@@ -0,0 +1,41 @@
+  // @file mapped_file.h
+  // @brief MappedFile class.
+  // @author Mamoru Kaminaga
+  // @date 2026-10-17
+  // Copyright 2026 Mamoru Kaminaga
+  // This program is provided with MIT license. See "LICENSE.md".
+#ifndef MAPPED_FILE_H_
+#define MAPPED_FILE_H_
+
+#include <wchar.h>
+#include <stdint.h>
+
+#include "./common.h"
+
+  // The output file of the fixed size mapped into the memory for writing.
+  // The different parts of the data may be written by the threads at the
+  // same time, the data is flushed to the disk once when it is closed.
+class MappedFile {
+ public:
+  MappedFile();
+  ~MappedFile();
+
+  bool Create(const wchar_t* file_name, uint64_t size);
+  uint8_t* GetData();
+  uint64_t GetSize() const;
+
+  // The data is flushed to the disk and the file is closed.
+  bool Close();
+
+ private:
+#ifdef _WIN32
+  void* file_;
+  void* mapping_;
+#else
+  int fd_;
+#endif
+  uint8_t* data_;
+  uint64_t size_;
+};
+
+#endif  // MAPPED_FILE_H_
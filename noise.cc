@@ -0,0 +1,208 @@
+  // @file noise.cc
+  // @brief Tileable noise fields.
+  // @author Mamoru Kaminaga
+  // @date 2026-10-17
+  // Copyright 2026 Mamoru Kaminaga
+  // This program is provided with MIT license. See "LICENSE.md".
+#include <assert.h>
+#include <stdint.h>
+#include <cmath>
+#include <vector>
+
+#include "./noise.h"
+#include "./cpu.h"
+#include "./common.h"
+
+#ifdef CPU_X86
+#include <emmintrin.h>
+#endif
+
+  // The spans are evaluated through the buffers of this number of pixels.
+#define NOISE_CHUNK_PIXELS  (256)
+
+namespace {
+  // The slopes of the gradient noise, one of eight directions.
+const float kGradientX[8] = {
+  1.0f, -1.0f, 0.0f, 0.0f, 0.70710678f, -0.70710678f, 0.70710678f,
+  -0.70710678f,
+};
+const float kGradientY[8] = {
+  0.0f, 0.0f, 1.0f, -1.0f, 0.70710678f, 0.70710678f, -0.70710678f,
+  -0.70710678f,
+};
+
+  // The random bits of the lattice point.
+inline uint32_t Hash(uint32_t key, int i, int j) {
+  uint32_t h = key ^ (static_cast<uint32_t>(i) * 0x9E3779B1U) ^
+    (static_cast<uint32_t>(j) * 0x85EBCA77U);
+  h ^= h >> 16;
+  h *= 0x7FEB352DU;
+  h ^= h >> 15;
+  h *= 0x846CA68BU;
+  h ^= h >> 16;
+  return h;
+}
+  // The upper 24 bits are the value from -1 to 1.
+inline float GetValue(uint32_t h) {
+  return static_cast<float>(h >> 8) * (2.0f / 16777216.0f) - 1.0f;
+}
+inline float Lerp(float a, float b, float t) {
+  return a + (b - a) * t;
+}
+  // The quintic curve, its first and second derivatives are 0 at the
+  // lattice points.
+inline float Fade(float t) {
+  return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f);
+}
+  // The lattice column k contributes slope * fx + offset at the distance fx
+  // from it. The value noise has no slope.
+inline float Interpolate(
+    float fx,
+    const float* slope,
+    const float* offset,
+    int i) {
+  const float left = fx * slope[i] + offset[i];
+  const float right = (fx - 1.0f) * slope[i + 1] + offset[i + 1];
+  return left + (right - left) * Fade(fx);
+}
+}  // namespace
+
+bool IsValidNoise(const Noise& noise) {
+  return (noise.cell > 0) &&
+    (noise.octaves > 0) && (noise.octaves <= NOISE_MAX_OCTAVES) &&
+    (noise.persistence > 0.0) && (noise.persistence <= 1.0);
+}
+
+NoiseField::NoiseField() : type_(NOISE_NONE) { }
+
+void NoiseField::Init(
+    const Noise& noise,
+    uint32_t seed,
+    const Vector2n& pixel) {
+  assert(IsValidNoise(noise));
+  assert((pixel.x > 0) && (pixel.y > 0));
+  type_ = noise.type;
+  octaves_.clear();
+  if (type_ == NOISE_NONE) return;
+
+  // The cells are stretched a little to fit the canvas, the octaves finer
+  // than a pixel are dropped.
+  const int base_x = static_cast<int>(
+      std::floor(static_cast<double>(pixel.x) / noise.cell + 0.5));
+  const int base_y = static_cast<int>(
+      std::floor(static_cast<double>(pixel.y) / noise.cell + 0.5));
+  double amplitude = 1.0;
+  for (int i = 0; i < noise.octaves; ++i) {
+    Octave octave;
+    octave.period_x = ((base_x > 1) ? base_x : 1) << i;
+    octave.period_y = ((base_y > 1) ? base_y : 1) << i;
+    if ((i > 0) &&
+        ((octave.period_x > pixel.x) || (octave.period_y > pixel.y))) {
+      break;
+    }
+    octave.scale_x = static_cast<float>(octave.period_x) / pixel.x;
+    octave.scale_y = static_cast<float>(octave.period_y) / pixel.y;
+    octave.amplitude = static_cast<float>(amplitude);
+    octave.key = Hash(seed, i, 0x6A09E667);
+    octaves_.push_back(octave);
+    amplitude *= noise.persistence;
+  }
+}
+void NoiseField::Evaluate(int x, int y, int num, float* values) const {
+  assert(values);
+  for (int i = 0; i < num; i += NOISE_CHUNK_PIXELS) {
+    const int chunk = (num - i < NOISE_CHUNK_PIXELS) ?
+      (num - i) : NOISE_CHUNK_PIXELS;
+    EvaluateChunk(x + i, y, chunk, &values[i]);
+  }
+}
+
+void NoiseField::EvaluateChunk(int x, int y, int num, float* values) const {
+  for (int i = 0; i < num; ++i) values[i] = 0.0f;
+
+  // The octave finer than a pixel is dropped, so the span covers no more
+  // lattice columns than the pixels and the two ends.
+  float slope[NOISE_CHUNK_PIXELS + 2];
+  float offset[NOISE_CHUNK_PIXELS + 2];
+  for (size_t o = 0; o < octaves_.size(); ++o) {
+    const Octave& octave = octaves_[o];
+
+    // The two lattice rows around the pixel row are blended first, the
+    // pixels interpolate only along the row.
+    const float v = (static_cast<float>(y) + 0.5f) * octave.scale_y;
+    const int j = static_cast<int>(v);
+    const float fy = v - static_cast<float>(j);
+    const float sy = Fade(fy);
+    const int j0 = j % octave.period_y;
+    const int j1 = (j0 + 1) % octave.period_y;
+    const int first = static_cast<int>(
+        (static_cast<float>(x) + 0.5f) * octave.scale_x);
+    const int last = static_cast<int>(
+        (static_cast<float>(x + num - 1) + 0.5f) * octave.scale_x) + 1;
+    for (int k = first; k <= last; ++k) {
+      const int i = k % octave.period_x;
+      const uint32_t h0 = Hash(octave.key, i, j0);
+      const uint32_t h1 = Hash(octave.key, i, j1);
+      if (type_ == NOISE_VALUE) {
+        slope[k - first] = 0.0f;
+        offset[k - first] = Lerp(GetValue(h0), GetValue(h1), sy);
+      } else {
+        slope[k - first] = Lerp(kGradientX[h0 & 7], kGradientX[h1 & 7], sy);
+        offset[k - first] = Lerp(
+            kGradientY[h0 & 7] * fy, kGradientY[h1 & 7] * (fy - 1.0f), sy);
+      }
+    }
+
+    // The SSE2 kernel computes four pixels with the same operations as the
+    // scalar code, so the values do not depend on the kernel.
+    const float scale = octave.scale_x;
+    const float amplitude = octave.amplitude;
+    int p = 0;
+#ifdef CPU_X86
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 six = _mm_set1_ps(6.0f);
+    const __m128 fifteen = _mm_set1_ps(15.0f);
+    const __m128 ten = _mm_set1_ps(10.0f);
+    const __m128 scale4 = _mm_set1_ps(scale);
+    const __m128 amplitude4 = _mm_set1_ps(amplitude);
+    const __m128i lanes = _mm_setr_epi32(0, 1, 2, 3);
+    const __m128i first4 = _mm_set1_epi32(first);
+    int cells[4];
+    for (; p + 4 <= num; p += 4) {
+      const __m128i xs = _mm_add_epi32(_mm_set1_epi32(x + p), lanes);
+      const __m128 u = _mm_mul_ps(_mm_add_ps(_mm_cvtepi32_ps(xs), half),
+          scale4);
+      const __m128i k = _mm_cvttps_epi32(u);
+      const __m128 fx = _mm_sub_ps(u, _mm_cvtepi32_ps(k));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(cells),
+          _mm_sub_epi32(k, first4));
+      const __m128 slope0 = _mm_setr_ps(slope[cells[0]], slope[cells[1]],
+          slope[cells[2]], slope[cells[3]]);
+      const __m128 slope1 = _mm_setr_ps(slope[cells[0] + 1],
+          slope[cells[1] + 1], slope[cells[2] + 1], slope[cells[3] + 1]);
+      const __m128 offset0 = _mm_setr_ps(offset[cells[0]], offset[cells[1]],
+          offset[cells[2]], offset[cells[3]]);
+      const __m128 offset1 = _mm_setr_ps(offset[cells[0] + 1],
+          offset[cells[1] + 1], offset[cells[2] + 1], offset[cells[3] + 1]);
+      const __m128 left = _mm_add_ps(_mm_mul_ps(fx, slope0), offset0);
+      const __m128 right = _mm_add_ps(
+          _mm_mul_ps(_mm_sub_ps(fx, one), slope1), offset1);
+      const __m128 fade = _mm_mul_ps(
+          _mm_mul_ps(_mm_mul_ps(fx, fx), fx),
+          _mm_add_ps(_mm_mul_ps(fx,
+              _mm_sub_ps(_mm_mul_ps(fx, six), fifteen)), ten));
+      const __m128 value = _mm_add_ps(left,
+          _mm_mul_ps(_mm_sub_ps(right, left), fade));
+      _mm_storeu_ps(&values[p], _mm_add_ps(_mm_loadu_ps(&values[p]),
+          _mm_mul_ps(amplitude4, value)));
+    }
+#endif
+    for (; p < num; ++p) {
+      const float u = (static_cast<float>(x + p) + 0.5f) * scale;
+      const int k = static_cast<int>(u);
+      const float fx = u - static_cast<float>(k);
+      values[p] += amplitude * Interpolate(fx, slope, offset, k - first);
+    }
+  }
+}
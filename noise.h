@@ -0,0 +1,76 @@
+  // @file noise.h
+  // @brief Tileable noise fields.
+  // @author Mamoru Kaminaga
+  // @date 2026-10-17
+  // Copyright 2026 Mamoru Kaminaga
+  // This program is provided with MIT license. See "LICENSE.md".
+#ifndef NOISE_H_
+#define NOISE_H_
+
+#include <stdint.h>
+#include <vector>
+
+#include "./common.h"
+
+  // The parameters of the noise used by default.
+#define NOISE_DEFAULT_CELL        (64)
+#define NOISE_DEFAULT_OCTAVES     (4)
+#define NOISE_DEFAULT_PERSISTENCE (0.5)
+#define NOISE_MAX_OCTAVES         (12)
+
+  // The pixels are independent by default. The value noise interpolates
+  // the random values of the lattice, the gradient noise interpolates the
+  // random slopes of the lattice.
+enum NOISE_TYPE {
+  NOISE_NONE,
+  NOISE_VALUE,
+  NOISE_GRADIENT,
+};
+
+  // The cell is the pixels between the lattice points of the first octave,
+  // every octave halves the cell and multiplies the amplitude by the
+  // persistence.
+struct Noise {
+  NOISE_TYPE type;
+  int cell;
+  int octaves;
+  double persistence;
+  Noise()
+    : type(NOISE_NONE),
+      cell(NOISE_DEFAULT_CELL),
+      octaves(NOISE_DEFAULT_OCTAVES),
+      persistence(NOISE_DEFAULT_PERSISTENCE) { }
+};
+
+bool IsValidNoise(const Noise& noise);
+
+  // The field of the canvas size repeats seamlessly, the lattice of every
+  // octave has the whole number of cells across the canvas. The value of a
+  // pixel depends only on the seed and the pixel position.
+class NoiseField {
+ public:
+  NoiseField();
+
+  void Init(const Noise& noise, uint32_t seed, const Vector2n& pixel);
+
+  // The values of the span from (x, y) to (x + num - 1, y), they are about
+  // from -1 to 1.
+  void Evaluate(int x, int y, int num, float* values) const;
+
+ private:
+  struct Octave {
+    int period_x;
+    int period_y;
+    float scale_x;
+    float scale_y;
+    float amplitude;
+    uint32_t key;
+  };
+  void EvaluateChunk(int x, int y, int num, float* values) const;
+
+ private:
+  NOISE_TYPE type_;
+  std::vector<Octave> octaves_;
+};
+
+#endif  // NOISE_H_
@@ -6,188 +6,139 @@
   // This program is provided with MIT license. See "LICENSE.md".
 #include <assert.h>
 #include <wchar.h>
-#include <windows.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <algorithm>
 #include <vector>
 
 #include "./palette.h"
-#include "./utility.h"
-
-#include "./resource.h"
+#include "./palette_file.h"
+#include "./raster.h"
+#include "./trace.h"
+#include "./common.h"
 
 Palette::Palette() = default;
 
-void Palette::Create(
-    HWND hwnd,
-    const Vector2n& grid,
-    bool read_file,
-    const wchar_t* file_name) {
+void Palette::Init(const Vector2n& grid) {
   // The palette size and color vector is set.
   grid_ = grid;
   color_num_ = grid_.x * grid_.y;
-  colors_.resize(color_num_);
-
-  // Window handle and size is acquired.
-  HWND hwnd_palette = GetDlgItem(hwnd, IDC_PIC_PALETTE);
-  RECT rc;
-  GetClientRect(hwnd_palette, &rc);
-  size_.x = (rc.right - rc.left);
-  size_.y = (rc.bottom - rc.top);
-
-  // The off-screen draw buffer is created.
-  hdc_offscreen_ = CreateCompatibleDC(nullptr);
-  HDC hdc = GetDC(hwnd_palette);
-  hdc_bitmap_ = CreateCompatibleBitmap(hdc, size_.x, size_.y);
-  ReleaseDC(hwnd_palette, hdc);
-  SelectObject(hdc_offscreen_, hdc_bitmap_);
-
-  // The colors are loaded.
-  if (read_file) {
-    if (!LoadColor(file_name)) {
-      MessageBox(hwnd, L"Failed to open the file", L"Error", MB_OK);
-    }
-  }
-
-  // Drawing tools are created.
-  grid_pen_ = CreatePen(PS_SOLID, 1, RGB(64, 64, 64));
-  select_pen_ = CreatePen(PS_SOLID, 2, RGB(255, 255, 255));
-  pens_.resize(color_num_);
-  brushes_.resize(color_num_);
-  COLORREF c;
-  for (int color_id = 0; color_id < color_num_; ++color_id) {
-    c = RGB(colors_[color_id].r, colors_[color_id].g, colors_[color_id].b);
-    pens_[color_id] = CreatePen(PS_SOLID, 1, c);
-    brushes_[color_id] = CreateSolidBrush(c);
-  }
+  assert((color_num_ > 0) && (color_num_ <= PALETTE_MAX_COLOR_NUM));
+  colors_.assign(color_num_, 0);
 
   // The default value is set.
   selected_color_id_ = 0;
 }
-void Palette::Paint(HWND hwnd) {
-  // Window handle and size is acquired.
-  HWND hwnd_palette = GetDlgItem(hwnd, IDC_PIC_PALETTE);
-
-  // The color cells are drawn to the off-screen buffer.
-  int x = 0;
-  int y = 0;
-  int x2 = 0;
-  int y2 = 0;
-  int color_id = 0;
-  SelectObject(hdc_offscreen_, grid_pen_);
-  for (int i = 0; i < grid_.y; ++i) {
-    for (int j = 0; j < grid_.x; ++j) {
-      // Draw target cell with tools.
-      x = static_cast<int>(size_.x * j / static_cast<double>(grid_.x));
-      y = static_cast<int>(size_.y * i / static_cast<double>(grid_.y));
-      x2 = static_cast<int>(size_.x * (j + 1) / static_cast<double>(grid_.x));
-      y2 = static_cast<int>(size_.y * (i + 1) / static_cast<double>(grid_.y));
-      SelectObject(hdc_offscreen_, brushes_[color_id]);
-      Rectangle(hdc_offscreen_, x, y, x2, y2);
-
-      // Target cell is changed.
-      ++color_id;
-    }
-  }
-
-  // The selected grid guide is drawn.
-  int ny = selected_color_id_ / grid_.x;
-  int nx = selected_color_id_ - ny * grid_.x;
-  x = static_cast<int>(size_.x * nx / static_cast<double>(grid_.x));
-  y = static_cast<int>(size_.y * ny / static_cast<double>(grid_.y));
-  x2 = static_cast<int>(size_.x * (nx + 1) / static_cast<double>(grid_.x));
-  y2 = static_cast<int>(size_.y * (ny + 1) / static_cast<double>(grid_.y));
-  SelectObject(hdc_offscreen_, select_pen_);
-  SelectObject(hdc_offscreen_, brushes_[selected_color_id_]);
-  Rectangle(hdc_offscreen_, x, y, x2, y2);
-
-  // Flip screen.
-  HDC hdc = GetDC(hwnd_palette);
-  BitBlt(hdc, 0, 0, size_.x, size_.y, hdc_offscreen_, 0, 0, SRCCOPY);
-  ReleaseDC(hwnd_palette, hdc);
-}
-void Palette::Destroy(HWND hwnd) {
-  // Drawing tools are deleted.
-  DeleteObject(grid_pen_);
-  DeleteObject(select_pen_);
-  for (int color_id = 0; color_id < color_num_; ++color_id) {
-    DeleteObject(pens_[color_id]);
-    DeleteObject(brushes_[color_id]);
-  }
-
-  // The off-screen draw buffer is released.
-  if (hdc_offscreen_) {
-    DeleteDC(hdc_offscreen_);
-    hdc_offscreen_ = nullptr;
+bool Palette::LoadColor(const wchar_t* file_name) {
+  int error_line = 0;
+  return LoadColor(file_name, &error_line);
+}
+bool Palette::LoadColor(const wchar_t* file_name, int* error_line) {
+  assert(error_line);
+  TRACE_SCOPE("Palette::LoadColor");
+
+  // The colors are replaced only when the whole file is read, the colors
+  // not in the file are black.
+  std::vector<uint32_t> colors(color_num_, 0);
+  int parsed_num = 0;
+  if (!LoadPaletteFile(
+      file_name,
+      &file_buffer_,
+      colors.data(),
+      color_num_,
+      &parsed_num,
+      error_line)) {
+    return false;
   }
-  if (hdc_bitmap_) {
-    DeleteObject(hdc_bitmap_);
-    hdc_bitmap_ = nullptr;
+#ifdef DEBUG
+  for (int color_id = 0; color_id < parsed_num; ++color_id) {
+    const RGBVecotr color = UnpackColor(colors[color_id]);
+    wprintf(L"color %d : %d, %d, %d\n", color_id,
+        color.r, color.g, color.b);
   }
-
-  // Warnings are prevented for non-used parameters.
-  UNREFERENCED_PARAMETER(hwnd);
-}
-
-bool Palette::PickupColor(HWND hwnd, int mouse_x, int mouse_y) {
-  // The relative mouse position is passed.
-  RECT rc;
-  GetWindowRect(GetDlgItem(hwnd, IDC_PIC_PALETTE), &rc);
-  POINT pt;
-  pt.x = rc.left;
-  pt.y = rc.top;
-  ScreenToClient(hwnd, &pt);
-  int x = mouse_x - pt.x;
-  int y = mouse_y - pt.y;
-
-  // Illegal cases.
-  if (x < 0) return false;
-  if (x > size_.x) return false;
-  if (y < 0) return false;
-  if (y > size_.y) return false;
-
-  // Position to select.
-  const int nx = static_cast<int>(grid_.x * x / static_cast<double>(size_.x));
-  const int ny = static_cast<int>(grid_.y * y / static_cast<double>(size_.y));
-  selected_color_id_ = ny * grid_.x + nx;
+#endif
+  colors_.swap(colors);
+  raster_.Invalidate();
   return true;
 }
+void Palette::SetColors(const uint32_t* colors, int color_num) {
+  assert(colors || (color_num == 0));
+  assert((color_num >= 0) && (color_num <= color_num_));
+  std::fill(colors_.begin(), colors_.end(), 0);
+  std::copy(colors, colors + color_num, colors_.begin());
+  raster_.Invalidate();
+}
+void Palette::SetSize(const Vector2n& size) {
+  // The frame buffer has one cell per color.
+  size_ = size;
+  raster_.Init(size_);
+  raster_.SetGrid(grid_);
+}
+void Palette::SetSelectedColorId(int color_id) {
+  assert((color_id >= 0) && (color_id < color_num_));
+
+  // The old and the new selected cells are drawn again.
+  const int old_x = selected_color_id_ % grid_.x;
+  const int old_y = selected_color_id_ / grid_.x;
+  raster_.InvalidateCells(Rect2n(old_x, old_y, old_x + 1, old_y + 1));
+  selected_color_id_ = color_id;
+  const int x = selected_color_id_ % grid_.x;
+  const int y = selected_color_id_ / grid_.x;
+  raster_.InvalidateCells(Rect2n(x, y, x + 1, y + 1));
+}
+
 RGBVecotr Palette::GetSelectedColor() const {
-  return colors_[selected_color_id_];
+  return UnpackColor(colors_[selected_color_id_]);
 }
 int Palette::GetSelectedColorId() const {
   return selected_color_id_;
 }
 RGBVecotr Palette::GetColor(int color_id) const {
+  return UnpackColor(colors_[color_id]);
+}
+uint32_t Palette::GetPackedColor(int color_id) const {
   return colors_[color_id];
 }
+const uint32_t* Palette::GetPackedColors() const {
+  return colors_.data();
+}
+int Palette::GetColorNum() const {
+  return color_num_;
+}
 Vector2n Palette::GetGrid() const {
   return grid_;
 }
-bool Palette::LoadColor(const wchar_t* file_name) {
-  FILE* fp = nullptr;
-  _wfopen_s(&fp, file_name, L"r");
-  if (fp == nullptr) {
-    return false;
-  }
-  int r = 0;
-  int g = 0;
-  int b = 0;
-  int color_id = 0;
-  while (fwscanf_s(fp, L"%d ,%d ,%d ,", &r, &g, &b) != EOF) {
-    if (color_id >= color_num_) return true;
-    colors_[color_id].r = r;
-    colors_[color_id].g = g;
-    colors_[color_id].b = b;
-#ifdef DEBUG
-    wprintf(L"color %d : %d, %d, %d\n", color_id, r, g, b);
-#endif
-    ++color_id;
-  }
-  fclose(fp);
-  return true;
+
+void Palette::Invalidate() {
+  raster_.Invalidate();
 }
-HBRUSH Palette::GetBrush(int color_id) const {
-  return brushes_[color_id];
+void Palette::Render() {
+  // Only the dirty cells are drawn with the grid lines.
+  const uint32_t kGridColor = Raster::MakeColor(RGBVecotr(64, 64, 64));
+  const uint32_t kSelectColor = Raster::MakeColor(RGBVecotr(255, 255, 255));
+  const int select_x = selected_color_id_ % grid_.x;
+  const int select_y = selected_color_id_ / grid_.x;
+  std::vector<uint32_t> cell_colors(grid_.x);
+  int begin = 0;
+  int end = 0;
+  for (int i = 0; i < grid_.y; ++i) {
+    if (!raster_.GetDirtyColumns(i, &begin, &end)) continue;
+    for (int j = begin; j < end; ++j) {
+      cell_colors[j] = colors_[i * grid_.x + j];
+    }
+    raster_.FillCells(i, begin, end, cell_colors.data());
+    for (int j = begin; j < end; ++j) {
+      raster_.FrameRect(raster_.GetCellRect(j, i), kGridColor, 1);
+    }
+
+    // The selected grid guide is drawn.
+    if ((i == select_y) && (select_x >= begin) && (select_x < end)) {
+      raster_.FrameRect(
+          raster_.GetCellRect(select_x, select_y), kSelectColor, 2);
+    }
+  }
+  raster_.EndFrame();
 }
-HPEN Palette::GetPen(int color_id) const {
-  return pens_[color_id];
+const Raster& Palette::GetRaster() const {
+  return raster_;
 }
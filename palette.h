@@ -8,49 +8,70 @@
 #define PALETTE_H_
 
 #include <wchar.h>
+#include <stdint.h>
+#ifdef _WIN32
 #include <windows.h>
+#endif
 #include <vector>
 
-#include "./utility.h"
+#include "./raster.h"
+
+#include "./common.h"
+
+  // The palette has up to 65536 colors, the canvas uses the 16 bit color
+  // indices for more than 256 colors.
+#define PALETTE_MAX_COLOR_NUM (65536)
 
 class Palette {
  public:
   Palette();
 
+  void Init(const Vector2n& grid);
+  // The text or the binary palette file is loaded. The error line is the
+  // malformed line of the text, 0 for the other errors.
+  bool LoadColor(const wchar_t* file_name);
+  bool LoadColor(const wchar_t* file_name, int* error_line);
+  // The colors are copied, the colors more than color_num are black.
+  void SetColors(const uint32_t* colors, int color_num);
+  void SetSize(const Vector2n& size);
+  void SetSelectedColorId(int color_id);
+
+#ifdef _WIN32
   void Create(
       HWND hwnd,
       const Vector2n& grid,
       bool read_file,
       const wchar_t* file_name);
   void Paint(HWND hwnd);
+  void Expose();
   void Destroy(HWND hwnd);
 
   bool PickupColor(HWND hwnd, int mouse_x, int mouse_y);
+#endif
 
   RGBVecotr GetSelectedColor() const;
   int GetSelectedColorId() const;
   RGBVecotr GetColor(int color_id) const;
-  Vector2n GetGrid() const;
 
-  HBRUSH GetBrush(int color_id) const;
-  HPEN GetPen(int color_id) const;
+  // The colors packed by PackColor, same as the pixels of the raster.
+  uint32_t GetPackedColor(int color_id) const;
+  const uint32_t* GetPackedColors() const;
+  int GetColorNum() const;
+  Vector2n GetGrid() const;
 
- private:
-  bool LoadColor(const wchar_t* file_name);
+  // The render draws only the cells changed since the last render.
+  void Invalidate();
+  void Render();
+  const Raster& GetRaster() const;
 
  private:
-  HDC hdc_offscreen_;
-  HBITMAP hdc_bitmap_;
-  HPEN grid_pen_;
-  HPEN select_pen_;
-  std::vector<HBRUSH> brushes_;
-  std::vector<HPEN> pens_;
-
   int selected_color_id_;
   int color_num_;
   Vector2n grid_;
   Vector2n size_;
-  std::vector<RGBVecotr> colors_;
+  std::vector<uint32_t> colors_;
+  std::vector<uint8_t> file_buffer_;
+  Raster raster_;
 };
 
 #endif  // PALETTE_H_
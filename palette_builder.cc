@@ -0,0 +1,340 @@
+  // @file palette_builder.cc
+  // @brief Palette extraction from the images.
+  // @author Mamoru Kaminaga
+  // @date 2026-10-17
+  // Copyright 2026 Mamoru Kaminaga
+  // This program is provided with MIT license. See "LICENSE.md".
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+
+#include "./palette_builder.h"
+#include "./cpu.h"
+#include "./thread_pool.h"
+#include "./trace.h"
+#include "./common.h"
+
+#ifdef CPU_X86
+#include <immintrin.h>
+#endif
+
+  // The pixels are assigned to the nearest colors in the tasks of this
+  // number of pixels.
+#define PALETTE_BUILDER_CHUNK (4096)
+
+  // The colors are padded to the multiple of the AVX2 lanes by the colors
+  // far from any pixel.
+#define PALETTE_BUILDER_LANES (8)
+#define PALETTE_BUILDER_FAR   (1.0e6f)
+
+namespace {
+  // The box of the median cut is the range of the samples. The channel is
+  // 0 for the blue, 1 for the green and 2 for the red.
+struct Box {
+  size_t begin;
+  size_t end;
+  int channel;
+  int range;
+};
+
+inline int GetChannel(uint32_t color, int channel) {
+  return static_cast<int>((color >> (channel * 8)) & 0xFF);
+}
+void MeasureBox(const uint32_t* samples, Box* box) {
+  int low[3] = {255, 255, 255};
+  int high[3] = {0, 0, 0};
+  for (size_t i = box->begin; i < box->end; ++i) {
+    for (int channel = 0; channel < 3; ++channel) {
+      const int value = GetChannel(samples[i], channel);
+      low[channel] = (value < low[channel]) ? value : low[channel];
+      high[channel] = (value > high[channel]) ? value : high[channel];
+    }
+  }
+  box->channel = 0;
+  box->range = high[0] - low[0];
+  for (int channel = 1; channel < 3; ++channel) {
+    if (high[channel] - low[channel] > box->range) {
+      box->channel = channel;
+      box->range = high[channel] - low[channel];
+    }
+  }
+}
+  // The box of the widest channel is cut at its median until there are
+  // color_num boxes or every box has one color.
+void CutMedian(
+    std::vector<uint32_t>* samples,
+    int color_num,
+    std::vector<Box>* boxes) {
+  TRACE_SCOPE("CutMedian");
+  uint32_t* data = samples->data();
+  Box whole = {0, samples->size(), 0, 0};
+  MeasureBox(data, &whole);
+  boxes->assign(1, whole);
+  while (static_cast<int>(boxes->size()) < color_num) {
+    int target = -1;
+    int widest = 0;
+    for (size_t i = 0; i < boxes->size(); ++i) {
+      if ((*boxes)[i].range > widest) {
+        target = static_cast<int>(i);
+        widest = (*boxes)[i].range;
+      }
+    }
+    if (target < 0) break;
+    Box& box = (*boxes)[target];
+    uint32_t* begin = &data[box.begin];
+    uint32_t* end = &data[box.end];
+    uint32_t* middle = begin + (end - begin) / 2;
+    const int channel = box.channel;
+    std::nth_element(begin, middle, end, [channel](uint32_t a, uint32_t b) {
+      return GetChannel(a, channel) < GetChannel(b, channel);
+    });
+
+    // The samples of the median value go to one box, so the boxes do not
+    // share the colors. The median may be the lowest value of the box.
+    const int median = GetChannel(*middle, channel);
+    uint32_t* split = std::partition(begin, end, [=](uint32_t color) {
+      return GetChannel(color, channel) < median;
+    });
+    if (split == begin) {
+      split = std::partition(begin, end, [=](uint32_t color) {
+        return GetChannel(color, channel) <= median;
+      });
+    }
+    Box upper = {static_cast<size_t>(split - data), box.end, 0, 0};
+    box.end = upper.begin;
+    MeasureBox(data, &box);
+    MeasureBox(data, &upper);
+    boxes->push_back(upper);
+  }
+}
+  // The nearest color of the pixel, the first one of the same distance.
+  // The SIMD kernels compute the same distances as the scalar code and keep
+  // the first color in every lane, so all find the same color.
+int FindNearest(
+    const float* red,
+    const float* green,
+    const float* blue,
+    int padded_num,
+    uint32_t pixel) {
+  const float r = static_cast<float>(GetChannel(pixel, 2));
+  const float g = static_cast<float>(GetChannel(pixel, 1));
+  const float b = static_cast<float>(GetChannel(pixel, 0));
+  int nearest = 0;
+  float nearest_distance = PALETTE_BUILDER_FAR * PALETTE_BUILDER_FAR;
+  for (int i = 0; i < padded_num; ++i) {
+    const float dr = red[i] - r;
+    const float dg = green[i] - g;
+    const float db = blue[i] - b;
+    const float distance = dr * dr + dg * dg + db * db;
+    if (distance < nearest_distance) {
+      nearest = i;
+      nearest_distance = distance;
+    }
+  }
+  return nearest;
+}
+#ifdef CPU_X86
+  // The lanes are reduced to the nearest color of the lowest id.
+int ReduceLanes(const float* distances, const int* ids, int lane_num) {
+  int nearest = ids[0];
+  float nearest_distance = distances[0];
+  for (int lane = 1; lane < lane_num; ++lane) {
+    if ((distances[lane] < nearest_distance) ||
+        ((distances[lane] == nearest_distance) && (ids[lane] < nearest))) {
+      nearest = ids[lane];
+      nearest_distance = distances[lane];
+    }
+  }
+  return nearest;
+}
+int FindNearestSse2(
+    const float* red,
+    const float* green,
+    const float* blue,
+    int padded_num,
+    uint32_t pixel) {
+  const __m128 r = _mm_set1_ps(static_cast<float>(GetChannel(pixel, 2)));
+  const __m128 g = _mm_set1_ps(static_cast<float>(GetChannel(pixel, 1)));
+  const __m128 b = _mm_set1_ps(static_cast<float>(GetChannel(pixel, 0)));
+  const __m128i four = _mm_set1_epi32(4);
+  __m128 best = _mm_set1_ps(PALETTE_BUILDER_FAR * PALETTE_BUILDER_FAR);
+  __m128i best_ids = _mm_setzero_si128();
+  __m128i ids = _mm_setr_epi32(0, 1, 2, 3);
+  for (int i = 0; i < padded_num; i += 4) {
+    const __m128 dr = _mm_sub_ps(_mm_loadu_ps(&red[i]), r);
+    const __m128 dg = _mm_sub_ps(_mm_loadu_ps(&green[i]), g);
+    const __m128 db = _mm_sub_ps(_mm_loadu_ps(&blue[i]), b);
+    const __m128 distance = _mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(dr, dr), _mm_mul_ps(dg, dg)),
+        _mm_mul_ps(db, db));
+    const __m128 nearer = _mm_cmplt_ps(distance, best);
+    const __m128i nearer_ids = _mm_castps_si128(nearer);
+    best = _mm_or_ps(_mm_and_ps(nearer, distance),
+        _mm_andnot_ps(nearer, best));
+    best_ids = _mm_or_si128(_mm_and_si128(nearer_ids, ids),
+        _mm_andnot_si128(nearer_ids, best_ids));
+    ids = _mm_add_epi32(ids, four);
+  }
+  float distances[4];
+  int lane_ids[4];
+  _mm_storeu_ps(distances, best);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(lane_ids), best_ids);
+  return ReduceLanes(distances, lane_ids, 4);
+}
+TARGET_AVX2 int FindNearestAvx2(
+    const float* red,
+    const float* green,
+    const float* blue,
+    int padded_num,
+    uint32_t pixel) {
+  const __m256 r = _mm256_set1_ps(static_cast<float>(GetChannel(pixel, 2)));
+  const __m256 g = _mm256_set1_ps(static_cast<float>(GetChannel(pixel, 1)));
+  const __m256 b = _mm256_set1_ps(static_cast<float>(GetChannel(pixel, 0)));
+  const __m256i eight = _mm256_set1_epi32(8);
+  __m256 best = _mm256_set1_ps(PALETTE_BUILDER_FAR * PALETTE_BUILDER_FAR);
+  __m256i best_ids = _mm256_setzero_si256();
+  __m256i ids = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  for (int i = 0; i < padded_num; i += 8) {
+    const __m256 dr = _mm256_sub_ps(_mm256_loadu_ps(&red[i]), r);
+    const __m256 dg = _mm256_sub_ps(_mm256_loadu_ps(&green[i]), g);
+    const __m256 db = _mm256_sub_ps(_mm256_loadu_ps(&blue[i]), b);
+    const __m256 distance = _mm256_add_ps(
+        _mm256_add_ps(_mm256_mul_ps(dr, dr), _mm256_mul_ps(dg, dg)),
+        _mm256_mul_ps(db, db));
+    const __m256 nearer = _mm256_cmp_ps(distance, best, _CMP_LT_OQ);
+    best = _mm256_blendv_ps(best, distance, nearer);
+    best_ids = _mm256_blendv_epi8(best_ids, ids, _mm256_castps_si256(nearer));
+    ids = _mm256_add_epi32(ids, eight);
+  }
+  float distances[8];
+  int lane_ids[8];
+  _mm256_storeu_ps(distances, best);
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(lane_ids), best_ids);
+  return ReduceLanes(distances, lane_ids, 8);
+}
+#endif
+inline int GetLuminance(uint32_t color) {
+  return 299 * GetChannel(color, 2) + 587 * GetChannel(color, 1) +
+    114 * GetChannel(color, 0);
+}
+}  // namespace
+
+void BuildPalette(
+    const uint32_t* pixels,
+    size_t pixel_num,
+    int color_num,
+    int iterations,
+    ThreadPool* pool,
+    std::vector<uint32_t>* colors) {
+  assert(pixels || (pixel_num == 0));
+  assert(color_num > 0);
+  assert(colors);
+  TRACE_SCOPE("BuildPalette");
+  colors->assign(color_num, 0);
+  if (pixel_num == 0) return;
+
+  // The means of the median cut boxes are the first colors.
+  std::vector<uint32_t> samples(pixels, pixels + pixel_num);
+  std::vector<Box> boxes;
+  CutMedian(&samples, color_num, &boxes);
+  const int box_num = static_cast<int>(boxes.size());
+  const int padded_num = (box_num + PALETTE_BUILDER_LANES - 1) /
+    PALETTE_BUILDER_LANES * PALETTE_BUILDER_LANES;
+  std::vector<float> red(padded_num, PALETTE_BUILDER_FAR);
+  std::vector<float> green(padded_num, PALETTE_BUILDER_FAR);
+  std::vector<float> blue(padded_num, PALETTE_BUILDER_FAR);
+  for (int i = 0; i < box_num; ++i) {
+    int64_t sum[3] = {0, 0, 0};
+    for (size_t j = boxes[i].begin; j < boxes[i].end; ++j) {
+      for (int channel = 0; channel < 3; ++channel) {
+        sum[channel] += GetChannel(samples[j], channel);
+      }
+    }
+    const double count = static_cast<double>(boxes[i].end - boxes[i].begin);
+    red[i] = static_cast<float>(sum[2] / count);
+    green[i] = static_cast<float>(sum[1] / count);
+    blue[i] = static_cast<float>(sum[0] / count);
+  }
+
+  // Every task sums the pixels of its nearest colors in the integers, so
+  // the means do not depend on the order of the tasks.
+  const size_t sample_num = samples.size();
+  const int task_num =
+    static_cast<int>((sample_num + PALETTE_BUILDER_CHUNK - 1) /
+        PALETTE_BUILDER_CHUNK);
+  std::vector<int> nearest(sample_num, -1);
+  std::vector<int64_t> sums(static_cast<size_t>(task_num) * box_num * 4);
+  std::vector<int64_t> change_nums(task_num);
+  auto find_nearest = FindNearest;
+#ifdef CPU_X86
+  find_nearest = CpuHasAvx2() ? FindNearestAvx2 : FindNearestSse2;
+#endif
+  auto task = [&](int task_id) {
+    TRACE_SCOPE("AssignColors");
+    int64_t* sum = &sums[static_cast<size_t>(task_id) * box_num * 4];
+    std::fill(sum, sum + box_num * 4, 0);
+    int64_t change_num = 0;
+    const size_t begin = static_cast<size_t>(task_id) * PALETTE_BUILDER_CHUNK;
+    const size_t end = (begin + PALETTE_BUILDER_CHUNK < sample_num) ?
+      (begin + PALETTE_BUILDER_CHUNK) : sample_num;
+    for (size_t i = begin; i < end; ++i) {
+      const uint32_t pixel = samples[i];
+      const int id = find_nearest(
+          red.data(), green.data(), blue.data(), padded_num, pixel);
+      if (id != nearest[i]) {
+        nearest[i] = id;
+        ++change_num;
+      }
+      sum[id * 4] += GetChannel(pixel, 2);
+      sum[id * 4 + 1] += GetChannel(pixel, 1);
+      sum[id * 4 + 2] += GetChannel(pixel, 0);
+      ++sum[id * 4 + 3];
+    }
+    change_nums[task_id] = change_num;
+  };
+  for (int iteration = 0; iteration < iterations; ++iteration) {
+    if (pool != nullptr) {
+      pool->Run(task_num, task);
+    } else {
+      for (int task_id = 0; task_id < task_num; ++task_id) task(task_id);
+    }
+
+    // The color without the pixels stays.
+    int64_t change_num = 0;
+    for (int task_id = 0; task_id < task_num; ++task_id) {
+      change_num += change_nums[task_id];
+    }
+    for (int i = 0; i < box_num; ++i) {
+      int64_t total[4] = {0, 0, 0, 0};
+      for (int task_id = 0; task_id < task_num; ++task_id) {
+        const int64_t* sum =
+          &sums[(static_cast<size_t>(task_id) * box_num + i) * 4];
+        for (int j = 0; j < 4; ++j) total[j] += sum[j];
+      }
+      if (total[3] == 0) continue;
+      const double count = static_cast<double>(total[3]);
+      red[i] = static_cast<float>(total[0] / count);
+      green[i] = static_cast<float>(total[1] / count);
+      blue[i] = static_cast<float>(total[2] / count);
+    }
+    if (change_num == 0) break;
+  }
+
+  // The colors are rounded and sorted from the dark colors.
+  for (int i = 0; i < box_num; ++i) {
+    RGBVecotr color;
+    color.r = static_cast<int>(red[i] + 0.5f);
+    color.g = static_cast<int>(green[i] + 0.5f);
+    color.b = static_cast<int>(blue[i] + 0.5f);
+    (*colors)[i] = PackColor(color);
+  }
+  std::sort(colors->begin(), colors->begin() + box_num,
+      [](uint32_t a, uint32_t b) {
+        const int luminance_a = GetLuminance(a);
+        const int luminance_b = GetLuminance(b);
+        return (luminance_a != luminance_b) ?
+          (luminance_a < luminance_b) : (a < b);
+      });
+}
@@ -0,0 +1,38 @@
+  // @file palette_builder.h
+  // @brief Palette extraction from the images.
+  // @author Mamoru Kaminaga
+  // @date 2026-10-17
+  // Copyright 2026 Mamoru Kaminaga
+  // This program is provided with MIT license. See "LICENSE.md".
+#ifndef PALETTE_BUILDER_H_
+#define PALETTE_BUILDER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "./thread_pool.h"
+
+#include "./common.h"
+
+  // The number of the pixels sampled from the image and the iterations of
+  // the k-means by default.
+#define PALETTE_BUILDER_DEFAULT_SAMPLES     (1 << 18)
+#define PALETTE_BUILDER_DEFAULT_ITERATIONS  (8)
+
+  // The pixels are reduced to color_num colors. The boxes of the median cut
+  // seed the k-means, the colors are moved to the means of their nearest
+  // pixels until no pixel changes the color or the iterations end. The
+  // nearest colors are found on the threads of the pool, the pool may be
+  // nullptr, the colors do not depend on the number of threads.
+  // The colors are sorted by the luminance, the colors more than the
+  // different pixels are black.
+void BuildPalette(
+    const uint32_t* pixels,
+    size_t pixel_num,
+    int color_num,
+    int iterations,
+    ThreadPool* pool,
+    std::vector<uint32_t>* colors);
+
+#endif  // PALETTE_BUILDER_H_
@@ -0,0 +1,219 @@
+  // @file palette_file.cc
+  // @brief Palette file readers and writers.
+  // @author Mamoru Kaminaga
+  // @date 2026-10-17
+  // Copyright 2026 Mamoru Kaminaga
+  // This program is provided with MIT license. See "LICENSE.md".
+#include <assert.h>
+#include <wchar.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "./palette_file.h"
+#include "./trace.h"
+#include "./common.h"
+
+namespace {
+inline bool IsSpace(char c) {
+  return (c == ' ') || (c == '\t');
+}
+inline bool IsLineEnd(char c) {
+  return (c == '\n') || (c == '\r');
+}
+  // The value from 0 to 255 is read, p is moved after the digits.
+bool ParseValue(const char** p, const char* end, int* value) {
+  const char* q = *p;
+  int v = 0;
+  while ((q < end) && (*q >= '0') && (*q <= '9')) {
+    v = v * 10 + (*q - '0');
+    if (v > 255) return false;
+    ++q;
+  }
+  if (q == *p) return false;
+  *p = q;
+  *value = v;
+  return true;
+}
+  // The color of one line is read, p is moved to the end of the line.
+bool ParseColor(const char** p, const char* end, uint32_t* color) {
+  int rgb[3] = {0};
+  const char* q = *p;
+  for (int i = 0; i < 3; ++i) {
+    while ((q < end) && IsSpace(*q)) ++q;
+    if (!ParseValue(&q, end, &rgb[i])) return false;
+    while ((q < end) && IsSpace(*q)) ++q;
+    const bool comma = (q < end) && (*q == ',');
+    if (comma) ++q;
+    if (!comma && (i < 2)) return false;
+  }
+  while ((q < end) && IsSpace(*q)) ++q;
+  if ((q < end) && !IsLineEnd(*q)) return false;
+  *color = PackColor(RGBVecotr(rgb[0], rgb[1], rgb[2]));
+  *p = q;
+  return true;
+}
+}  // namespace
+
+bool ParsePaletteText(
+    const char* text,
+    size_t size,
+    uint32_t* colors,
+    int color_num,
+    int* parsed_num,
+    int* error_line) {
+  assert(text || (size == 0));
+  assert(colors || (color_num == 0));
+  assert(parsed_num);
+  assert(error_line);
+  const char* p = text;
+  const char* end = text + size;
+  int line = 1;
+  int num = 0;
+  *parsed_num = 0;
+  *error_line = 0;
+
+  // The UTF-8 byte order mark is skipped.
+  if ((size >= 3) && (memcmp(p, "\xEF\xBB\xBF", 3) == 0)) p += 3;
+
+  while (p < end) {
+    // The blank line is skipped.
+    const char* q = p;
+    while ((q < end) && IsSpace(*q)) ++q;
+    if ((q < end) && !IsLineEnd(*q)) {
+      uint32_t color = 0;
+      if ((num >= color_num) || !ParseColor(&p, end, &color)) {
+        *parsed_num = num;
+        *error_line = line;
+        return false;
+      }
+      colors[num] = color;
+      ++num;
+    } else {
+      p = q;
+    }
+
+    // CR LF, LF and CR end the line.
+    if (p < end) {
+      if ((*p == '\r') && (p + 1 < end) && (p[1] == '\n')) ++p;
+      ++p;
+      ++line;
+    }
+  }
+  *parsed_num = num;
+  return true;
+}
+bool ParsePaletteBinary(
+    const uint8_t* data,
+    size_t size,
+    uint32_t* colors,
+    int color_num,
+    int* parsed_num) {
+  assert(data || (size == 0));
+  assert(colors || (color_num == 0));
+  assert(parsed_num);
+  *parsed_num = 0;
+
+  // The header is checked against the size.
+  if (size < PALETTE_BINARY_HEADER_SIZE) return false;
+  if (memcmp(data, PALETTE_BINARY_MAGIC, 4) != 0) return false;
+  uint32_t num = 0;
+  memcpy(&num, &data[4], 4);
+  if (num > static_cast<uint32_t>(color_num)) return false;
+  if (size != PALETTE_BINARY_HEADER_SIZE + static_cast<size_t>(num) * 3) {
+    return false;
+  }
+
+  const uint8_t* rgb = &data[PALETTE_BINARY_HEADER_SIZE];
+  for (uint32_t i = 0; i < num; ++i) {
+    colors[i] = (static_cast<uint32_t>(rgb[i * 3]) << 16) |
+      (static_cast<uint32_t>(rgb[i * 3 + 1]) << 8) | rgb[i * 3 + 2];
+  }
+  *parsed_num = static_cast<int>(num);
+  return true;
+}
+bool LoadPaletteFile(
+    const wchar_t* file_name,
+    std::vector<uint8_t>* buffer,
+    uint32_t* colors,
+    int color_num,
+    int* parsed_num,
+    int* error_line) {
+  assert(file_name);
+  assert(buffer);
+  assert(parsed_num);
+  assert(error_line);
+  *parsed_num = 0;
+  *error_line = 0;
+  {
+    TRACE_SCOPE("LoadFile");
+    if (!LoadFile(file_name, buffer)) return false;
+  }
+  TRACE_SCOPE("ParsePalette");
+
+  // The binary palette starts with the magic.
+  const size_t size = buffer->size();
+  if ((size >= 4) && (memcmp(buffer->data(), PALETTE_BINARY_MAGIC, 4) == 0)) {
+    return ParsePaletteBinary(
+        buffer->data(), size, colors, color_num, parsed_num);
+  }
+  return ParsePaletteText(
+      reinterpret_cast<const char*>(buffer->data()),
+      size,
+      colors,
+      color_num,
+      parsed_num,
+      error_line);
+}
+bool SavePaletteBinary(
+    const wchar_t* file_name,
+    const uint32_t* colors,
+    int color_num) {
+  assert(file_name);
+  assert(colors || (color_num == 0));
+
+  // The file is built in the memory and written by one call.
+  std::vector<uint8_t> data(PALETTE_BINARY_HEADER_SIZE + color_num * 3);
+  memcpy(&data[0], PALETTE_BINARY_MAGIC, 4);
+  const uint32_t num = static_cast<uint32_t>(color_num);
+  memcpy(&data[4], &num, 4);
+  uint8_t* rgb = &data[PALETTE_BINARY_HEADER_SIZE];
+  for (int i = 0; i < color_num; ++i) {
+    rgb[i * 3] = static_cast<uint8_t>(colors[i] >> 16);
+    rgb[i * 3 + 1] = static_cast<uint8_t>(colors[i] >> 8);
+    rgb[i * 3 + 2] = static_cast<uint8_t>(colors[i]);
+  }
+
+  FILE* fp = OpenFile(file_name, L"wb");
+  if (fp == nullptr) return false;
+  bool result = (fwrite(data.data(), data.size(), 1, fp) == 1);
+  if (fclose(fp) != 0) result = false;
+  return result;
+}
+bool SavePaletteText(
+    const wchar_t* file_name,
+    const uint32_t* colors,
+    int color_num) {
+  assert(file_name);
+  assert(colors || (color_num == 0));
+
+  // The text is built in the memory and written by one call.
+  std::string text;
+  char line[32];
+  for (int i = 0; i < color_num; ++i) {
+    const RGBVecotr color = UnpackColor(colors[i]);
+    snprintf(line, sizeof(line), "%d, %d, %d,\r\n",
+        color.r, color.g, color.b);
+    text += line;
+  }
+
+  FILE* fp = OpenFile(file_name, L"wb");
+  if (fp == nullptr) return false;
+  bool result = text.empty() ||
+    (fwrite(text.data(), text.size(), 1, fp) == 1);
+  if (fclose(fp) != 0) result = false;
+  return result;
+}
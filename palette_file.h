@@ -0,0 +1,64 @@
+  // @file palette_file.h
+  // @brief Palette file readers and writers.
+  // @author Mamoru Kaminaga
+  // @date 2026-10-17
+  // Copyright 2026 Mamoru Kaminaga
+  // This program is provided with MIT license. See "LICENSE.md".
+#ifndef PALETTE_FILE_H_
+#define PALETTE_FILE_H_
+
+#include <wchar.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "./common.h"
+
+  // The binary palette is the magic, the little endian 32 bit number of the
+  // colors and the R, G, B bytes of every color, up to 65536 colors.
+#define PALETTE_BINARY_MAGIC        "C1PL"
+#define PALETTE_BINARY_HEADER_SIZE  (8)
+
+  // The text palette has one color "R, G, B," per line, the values are 0 to
+  // 255 and the last comma may be omitted. The colors are packed by
+  // PackColor. The blank lines are skipped.
+  // On the malformed line or more colors than color_num, false is returned
+  // with the line number from 1.
+bool ParsePaletteText(
+    const char* text,
+    size_t size,
+    uint32_t* colors,
+    int color_num,
+    int* parsed_num,
+    int* error_line);
+
+  // The binary palette is copied without parsing.
+bool ParsePaletteBinary(
+    const uint8_t* data,
+    size_t size,
+    uint32_t* colors,
+    int color_num,
+    int* parsed_num);
+
+  // The file is read by one call into the buffer and parsed by the format
+  // found from its head. The error line is 0 unless a text line is wrong.
+bool LoadPaletteFile(
+    const wchar_t* file_name,
+    std::vector<uint8_t>* buffer,
+    uint32_t* colors,
+    int color_num,
+    int* parsed_num,
+    int* error_line);
+
+bool SavePaletteBinary(
+    const wchar_t* file_name,
+    const uint32_t* colors,
+    int color_num);
+
+  // The colors are written as the text palette.
+bool SavePaletteText(
+    const wchar_t* file_name,
+    const uint32_t* colors,
+    int color_num);
+
+#endif  // PALETTE_FILE_H_
@@ -0,0 +1,96 @@
+  // @file palette_win32.cc
+  // @brief Palette class, the Win32 drawing part.
+  // @author Mamoru Kaminaga
+  // @date 2017-11-17
+  // Copyright 2017 Mamoru Kaminaga
+  // This program is provided with MIT license. See "LICENSE.md".
+#include <assert.h>
+#include <wchar.h>
+#include <windows.h>
+#include <stdint.h>
+#include <vector>
+
+#include "./palette.h"
+#include "./raster.h"
+#include "./utility.h"
+
+#include "./resource.h"
+
+void Palette::Create(
+    HWND hwnd,
+    const Vector2n& grid,
+    bool read_file,
+    const wchar_t* file_name) {
+  // The palette size and color vector is set.
+  Init(grid);
+
+  // Window handle and size is acquired.
+  HWND hwnd_palette = GetDlgItem(hwnd, IDC_PIC_PALETTE);
+  RECT rc;
+  GetClientRect(hwnd_palette, &rc);
+  size_.x = (rc.right - rc.left);
+  size_.y = (rc.bottom - rc.top);
+
+  // The preview is sized to the window.
+  SetSize(size_);
+
+  // The colors are loaded.
+  if (read_file) {
+    int error_line = 0;
+    if (!LoadColor(file_name, &error_line)) {
+      wchar_t message[64] = L"Failed to open the file";
+      if (error_line > 0) {
+        swprintf(message, 64, L"Wrong color at line %d", error_line);
+      }
+      MessageBox(hwnd, message, L"Error", MB_OK);
+    }
+  }
+}
+void Palette::Paint(HWND hwnd) {
+  // Window handle and size is acquired.
+  HWND hwnd_palette = GetDlgItem(hwnd, IDC_PIC_PALETTE);
+
+  // Only the dirty cells are drawn, only the damage is copied.
+  Render();
+  Rect2n damage;
+  if (!raster_.TakeDamage(&damage)) return;
+  HDC hdc = GetDC(hwnd_palette);
+  BlitRaster(hdc, raster_, damage);
+  ReleaseDC(hwnd_palette, hdc);
+}
+void Palette::Expose() {
+  raster_.Expose();
+}
+void Palette::Destroy(HWND hwnd) {
+  // The frame buffer is released.
+  raster_.Init(Vector2n(0, 0));
+
+  // Warnings are prevented for non-used parameters.
+  UNREFERENCED_PARAMETER(hwnd);
+}
+
+bool Palette::PickupColor(HWND hwnd, int mouse_x, int mouse_y) {
+  // The relative mouse position is passed.
+  RECT rc;
+  GetWindowRect(GetDlgItem(hwnd, IDC_PIC_PALETTE), &rc);
+  POINT pt;
+  pt.x = rc.left;
+  pt.y = rc.top;
+  ScreenToClient(hwnd, &pt);
+  int x = mouse_x - pt.x;
+  int y = mouse_y - pt.y;
+
+  // Illegal cases.
+  if (x < 0) return false;
+  if (x > size_.x) return false;
+  if (y < 0) return false;
+  if (y > size_.y) return false;
+
+  // Position to select.
+  int nx = static_cast<int>(grid_.x * x / static_cast<double>(size_.x));
+  int ny = static_cast<int>(grid_.y * y / static_cast<double>(size_.y));
+  if (nx >= grid_.x) nx = grid_.x - 1;
+  if (ny >= grid_.y) ny = grid_.y - 1;
+  SetSelectedColorId(ny * grid_.x + nx);
+  return true;
+}
@@ -0,0 +1,175 @@
+  // @file pixel_store.cc
+  // @brief PixelStore class.
+  // @author Mamoru Kaminaga
+  // @date 2026-10-17
+  // Copyright 2026 Mamoru Kaminaga
+  // This program is provided with MIT license. See "LICENSE.md".
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+#include "./pixel_store.h"
+#include "./trace.h"
+#include "./common.h"
+
+namespace {
+  // The kernels are specialized for each width, so the shifts and masks
+  // are constants in the loops.
+template<int BITS>
+void StoreWords(uint64_t* words, int x, int num, const int* values) {
+  const int kPerWord = 64 / BITS;
+  const uint64_t kMask = (1ULL << BITS) - 1;
+  for (int i = 0; i < num; ++i) {
+    const int index = x + i;
+    uint64_t* word = &words[index / kPerWord];
+    const int shift = (index % kPerWord) * BITS;
+    *word = (*word & ~(kMask << shift)) |
+      ((static_cast<uint64_t>(values[i]) & kMask) << shift);
+  }
+}
+template<int BITS, class INDEX>
+void LoadWords(
+    const uint64_t* words,
+    int num,
+    const INDEX* table,
+    INDEX* values) {
+  const int kPerWord = 64 / BITS;
+  const uint64_t kMask = (1ULL << BITS) - 1;
+  int x = 0;
+  while (x < num) {
+    uint64_t word = *words++;
+    const int word_num = (num - x < kPerWord) ? (num - x) : kPerWord;
+    if (table != nullptr) {
+      for (int i = 0; i < word_num; ++i) {
+        values[x + i] = table[word & kMask];
+        word >>= BITS;
+      }
+    } else {
+      for (int i = 0; i < word_num; ++i) {
+        values[x + i] = static_cast<INDEX>(word & kMask);
+        word >>= BITS;
+      }
+    }
+    x += word_num;
+  }
+}
+
+typedef void (*StoreKernel)(uint64_t*, int, int, const int*);
+
+  // The load kernels of every width for the index type.
+template<class INDEX>
+struct LoadKernels {
+  typedef void (*Kernel)(const uint64_t*, int, const INDEX*, INDEX*);
+  static const Kernel kKernels[PIXEL_STORE_MAX_BITS + 1];
+};
+template<class INDEX>
+const typename LoadKernels<INDEX>::Kernel
+LoadKernels<INDEX>::kKernels[PIXEL_STORE_MAX_BITS + 1] = {
+  nullptr,
+  &LoadWords<1, INDEX>, &LoadWords<2, INDEX>, &LoadWords<3, INDEX>,
+  &LoadWords<4, INDEX>, &LoadWords<5, INDEX>, &LoadWords<6, INDEX>,
+  &LoadWords<7, INDEX>, &LoadWords<8, INDEX>, &LoadWords<9, INDEX>,
+  &LoadWords<10, INDEX>, &LoadWords<11, INDEX>, &LoadWords<12, INDEX>,
+  &LoadWords<13, INDEX>, &LoadWords<14, INDEX>, &LoadWords<15, INDEX>,
+  &LoadWords<16, INDEX>,
+};
+
+const StoreKernel kStoreKernels[PIXEL_STORE_MAX_BITS + 1] = {
+  nullptr,
+  &StoreWords<1>, &StoreWords<2>, &StoreWords<3>, &StoreWords<4>,
+  &StoreWords<5>, &StoreWords<6>, &StoreWords<7>, &StoreWords<8>,
+  &StoreWords<9>, &StoreWords<10>, &StoreWords<11>, &StoreWords<12>,
+  &StoreWords<13>, &StoreWords<14>, &StoreWords<15>, &StoreWords<16>,
+};
+}  // namespace
+
+PixelStore::PixelStore() : bits_(8), row_words_(0) { }
+
+void PixelStore::Init(const Vector2n& pixel, int bits) {
+  assert((bits > 0) && (bits <= PIXEL_STORE_MAX_BITS));
+  pixel_ = pixel;
+  bits_ = bits;
+  const size_t row_num = static_cast<size_t>(pixel_.y);
+  if (bits_ == 8) {
+    row_words_ = 0;
+    bytes_.assign(row_num * pixel_.x, 0);
+    words_.clear();
+  } else {
+    const int per_word = 64 / bits_;
+    row_words_ = (pixel_.x + per_word - 1) / per_word;
+    bytes_.clear();
+    words_.assign(row_num * row_words_, 0);
+  }
+  TRACE_ALLOC("PixelStore", static_cast<int64_t>(GetBytes()));
+}
+int PixelStore::GetBits() const {
+  return bits_;
+}
+size_t PixelStore::GetBytes() const {
+  return bytes_.size() + words_.size() * sizeof(uint64_t);
+}
+
+void PixelStore::StoreSpan(int x, int y, int num, const int* values) {
+  assert(values);
+  assert((x >= 0) && (x + num <= pixel_.x));
+  if (bits_ == 8) {
+    uint8_t* row = &bytes_[static_cast<size_t>(y) * pixel_.x + x];
+    for (int i = 0; i < num; ++i) row[i] = static_cast<uint8_t>(values[i]);
+    return;
+  }
+  kStoreKernels[bits_](
+      &words_[static_cast<size_t>(y) * row_words_], x, num, values);
+}
+int PixelStore::Load(int x, int y) const {
+  if (bits_ == 8) {
+    return bytes_[static_cast<size_t>(y) * pixel_.x + x];
+  }
+  const int per_word = 64 / bits_;
+  const uint64_t word =
+    words_[static_cast<size_t>(y) * row_words_ + x / per_word];
+  return static_cast<int>(
+      (word >> ((x % per_word) * bits_)) & ((1ULL << bits_) - 1));
+}
+void PixelStore::LoadRow(int y, const uint8_t* table, uint8_t* values) const {
+  LoadIndexRow(y, table, values);
+}
+void PixelStore::LoadRow(
+    int y,
+    const uint16_t* table,
+    uint16_t* values) const {
+  LoadIndexRow(y, table, values);
+}
+const uint8_t* PixelStore::GetRow(int y) const {
+  if (bits_ != 8) return nullptr;
+  return &bytes_[static_cast<size_t>(y) * pixel_.x];
+}
+
+int PixelStore::GetBitsFor(int value_num) {
+  int bits = 1;
+  while ((1 << bits) < value_num) ++bits;
+  return bits;
+}
+
+template<class INDEX>
+void PixelStore::LoadIndexRow(
+    int y,
+    const INDEX* table,
+    INDEX* values) const {
+  assert(values);
+  assert(table || (bits_ <= static_cast<int>(sizeof(INDEX) * 8)));
+  if (bits_ == 8) {
+    const uint8_t* row = &bytes_[static_cast<size_t>(y) * pixel_.x];
+    if (table != nullptr) {
+      for (int x = 0; x < pixel_.x; ++x) values[x] = table[row[x]];
+    } else if (sizeof(INDEX) == 1) {
+      memcpy(values, row, pixel_.x);
+    } else {
+      for (int x = 0; x < pixel_.x; ++x) values[x] = row[x];
+    }
+    return;
+  }
+  LoadKernels<INDEX>::kKernels[bits_](
+      &words_[static_cast<size_t>(y) * row_words_], pixel_.x, table, values);
+}
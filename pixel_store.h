@@ -0,0 +1,56 @@
+  // @file pixel_store.h
+  // @brief PixelStore class.
+  // @author Mamoru Kaminaga
+  // @date 2026-10-17
+  // Copyright 2026 Mamoru Kaminaga
+  // This program is provided with MIT license. See "LICENSE.md".
+#ifndef PIXEL_STORE_H_
+#define PIXEL_STORE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "./common.h"
+
+#define PIXEL_STORE_MAX_BITS  (16)
+
+  // The pixel values of the canvas stored in the given number of bits.
+  // 8 bits are stored as one byte per pixel. The other widths are packed
+  // into 64 bit words, 64 / bits values per word, and every row starts at
+  // a new word, so the different rows may be written at the same time.
+class PixelStore {
+ public:
+  PixelStore();
+
+  void Init(const Vector2n& pixel, int bits);
+  int GetBits() const;
+  size_t GetBytes() const;
+
+  void StoreSpan(int x, int y, int num, const int* values);
+  int Load(int x, int y) const;
+
+  // The row is unpacked through the table, the table is indexed by the
+  // stored values. The table may be nullptr when the stored values fit in
+  // the output, then they are copied as they are.
+  void LoadRow(int y, const uint8_t* table, uint8_t* values) const;
+  void LoadRow(int y, const uint16_t* table, uint16_t* values) const;
+
+  // The row of 8 bits values, nullptr for the other widths.
+  const uint8_t* GetRow(int y) const;
+
+  static int GetBitsFor(int value_num);
+
+ private:
+  template<class INDEX>
+  void LoadIndexRow(int y, const INDEX* table, INDEX* values) const;
+
+ private:
+  Vector2n pixel_;
+  int bits_;
+  int row_words_;
+  std::vector<uint8_t> bytes_;
+  std::vector<uint64_t> words_;
+};
+
+#endif  // PIXEL_STORE_H_
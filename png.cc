@@ -0,0 +1,296 @@
+  // @file png.cc
+  // @brief PNG file writer.
+  // @author Mamoru Kaminaga
+  // @date 2026-10-17
+  // Copyright 2026 Mamoru Kaminaga
+  // This program is provided with MIT license. See "LICENSE.md".
+#include <assert.h>
+#include <wchar.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <functional>
+#include <vector>
+
+#include "./png.h"
+#include "./deflate.h"
+#include "./thread_pool.h"
+#include "./trace.h"
+#include "./common.h"
+
+  // The rows are compressed in the chunks of about this number of bytes.
+#define PNG_CHUNK_BYTES (1 << 17)
+
+namespace {
+const uint8_t kSignature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+
+inline void PutBigEndian(uint32_t value, uint8_t* data) {
+  data[0] = static_cast<uint8_t>(value >> 24);
+  data[1] = static_cast<uint8_t>(value >> 16);
+  data[2] = static_cast<uint8_t>(value >> 8);
+  data[3] = static_cast<uint8_t>(value);
+}
+inline uint8_t Paeth(int a, int b, int c) {
+  const int p = a + b - c;
+  const int pa = abs(p - a);
+  const int pb = abs(p - b);
+  const int pc = abs(p - c);
+  if ((pa <= pb) && (pa <= pc)) return static_cast<uint8_t>(a);
+  return static_cast<uint8_t>((pb <= pc) ? b : c);
+}
+  // The row is filtered into the filter type byte and the filtered bytes.
+void FilterRow(
+    PNG_FILTER filter,
+    const uint8_t* row,
+    const uint8_t* prev,
+    int size,
+    int bpp,
+    uint8_t* out) {
+  out[0] = static_cast<uint8_t>(filter);
+  uint8_t* f = &out[1];
+  switch (filter) {
+    case PNG_FILTER_SUB:
+      for (int i = 0; i < size; ++i) {
+        f[i] = static_cast<uint8_t>(row[i] - ((i >= bpp) ? row[i - bpp] : 0));
+      }
+      break;
+    case PNG_FILTER_UP:
+      for (int i = 0; i < size; ++i) {
+        f[i] = static_cast<uint8_t>(row[i] - prev[i]);
+      }
+      break;
+    case PNG_FILTER_AVERAGE:
+      for (int i = 0; i < size; ++i) {
+        const int left = (i >= bpp) ? row[i - bpp] : 0;
+        f[i] = static_cast<uint8_t>(row[i] - ((left + prev[i]) >> 1));
+      }
+      break;
+    case PNG_FILTER_PAETH:
+      for (int i = 0; i < size; ++i) {
+        const int left = (i >= bpp) ? row[i - bpp] : 0;
+        const int corner = (i >= bpp) ? prev[i - bpp] : 0;
+        f[i] = static_cast<uint8_t>(row[i] - Paeth(left, prev[i], corner));
+      }
+      break;
+    default:
+      memcpy(f, row, size);
+      break;
+  }
+}
+  // The sum of the filtered bytes as the signed values.
+uint64_t GetFilterCost(const uint8_t* out, int size) {
+  uint64_t cost = 0;
+  for (int i = 1; i <= size; ++i) {
+    cost += (out[i] < 128) ? out[i] : (256 - out[i]);
+  }
+  return cost;
+}
+}  // namespace
+
+PngWriter::PngWriter()
+  : fp_(nullptr),
+    height_(0),
+    pixel_bytes_(0),
+    row_bytes_(0),
+    chunk_rows_(1),
+    row_num_(0),
+    filter_(PNG_FILTER_NONE),
+    level_(0),
+    adler_(1),
+    error_(false) { }
+PngWriter::~PngWriter() {
+  if (fp_ != nullptr) fclose(fp_);
+}
+
+bool PngWriter::Open(
+    const wchar_t* file_name,
+    int width,
+    int height,
+    int bit_number,
+    const uint32_t* colors,
+    int color_num,
+    const PngOption& option) {
+  assert(file_name);
+  assert((width > 0) && (height > 0));
+  assert((bit_number == 8) || (bit_number == 24));
+  assert((bit_number != 8) || ((color_num > 0) && (color_num <= 256)));
+  assert((color_num == 0) || colors);
+  assert((option.level >= 0) && (option.level <= DEFLATE_MAX_LEVEL));
+  const bool indexed = (bit_number == 8);
+
+  height_ = height;
+  pixel_bytes_ = bit_number / 8;
+  row_bytes_ = width * pixel_bytes_;
+  chunk_rows_ = PNG_CHUNK_BYTES / (row_bytes_ + 1);
+  if (chunk_rows_ < 1) chunk_rows_ = 1;
+  row_num_ = 0;
+  filter_ = option.filter;
+  level_ = option.level;
+  adler_ = 1;
+  error_ = false;
+  prev_row_.assign(row_bytes_, 0);
+  dictionary_.clear();
+
+  fp_ = OpenFile(file_name, L"wb");
+  if (fp_ == nullptr) return false;
+  if (fwrite(kSignature, sizeof(kSignature), 1, fp_) != 1) error_ = true;
+
+  // The header, 8 bits per sample without the interlace.
+  uint8_t header[13] = {0};
+  PutBigEndian(static_cast<uint32_t>(width), &header[0]);
+  PutBigEndian(static_cast<uint32_t>(height), &header[4]);
+  header[8] = 8;
+  header[9] = indexed ? 3 : 2;
+  WriteChunk("IHDR", header, sizeof(header));
+
+  // The palette of the indexed image.
+  if (indexed) {
+    std::vector<uint8_t> palette(color_num * 3);
+    for (int i = 0; i < color_num; ++i) {
+      palette[i * 3] = static_cast<uint8_t>(colors[i] >> 16);
+      palette[i * 3 + 1] = static_cast<uint8_t>(colors[i] >> 8);
+      palette[i * 3 + 2] = static_cast<uint8_t>(colors[i]);
+    }
+    WriteChunk("PLTE", palette.data(), palette.size());
+  }
+  return !error_;
+}
+int PngWriter::GetChunkRows() const {
+  return chunk_rows_;
+}
+bool PngWriter::WriteRows(const uint8_t* rows, int row_num, ThreadPool* pool) {
+  assert(fp_);
+  assert(rows);
+  assert(row_num_ + row_num <= height_);
+  const int chunk_num = (row_num + chunk_rows_ - 1) / chunk_rows_;
+  const bool last = (row_num_ + row_num == height_);
+  filtered_.resize(chunk_num);
+  compressed_.resize(chunk_num);
+  chunk_adler_.resize(chunk_num);
+  auto run = [pool](int task_num, const std::function<void(int)>& task) {
+    if (pool != nullptr) {
+      pool->Run(task_num, task);
+    } else {
+      for (int task_id = 0; task_id < task_num; ++task_id) task(task_id);
+    }
+  };
+
+  // The rows of every chunk are filtered, the row above the batch is
+  // kept from the last batch.
+  const int filtered_bytes = row_bytes_ + 1;
+  auto filter_task = [&](int chunk_id) {
+    TRACE_SCOPE("PngFilter");
+    const int r_begin = chunk_id * chunk_rows_;
+    const int r_end = (r_begin + chunk_rows_ < row_num) ?
+      (r_begin + chunk_rows_) : row_num;
+    std::vector<uint8_t>& filtered = filtered_[chunk_id];
+    filtered.resize(static_cast<size_t>(r_end - r_begin) * filtered_bytes);
+    std::vector<uint8_t> trial(
+        (filter_ == PNG_FILTER_ADAPTIVE) ? filtered_bytes : 0);
+    for (int r = r_begin; r < r_end; ++r) {
+      const uint8_t* row = &rows[static_cast<size_t>(r) * row_bytes_];
+      const uint8_t* prev = (r == 0) ?
+        prev_row_.data() : &rows[static_cast<size_t>(r - 1) * row_bytes_];
+      uint8_t* out =
+        &filtered[static_cast<size_t>(r - r_begin) * filtered_bytes];
+      if (filter_ != PNG_FILTER_ADAPTIVE) {
+        FilterRow(filter_, row, prev, row_bytes_, pixel_bytes_, out);
+        continue;
+      }
+      uint64_t best = UINT64_MAX;
+      for (int f = PNG_FILTER_NONE; f <= PNG_FILTER_PAETH; ++f) {
+        FilterRow(static_cast<PNG_FILTER>(f), row, prev, row_bytes_,
+            pixel_bytes_, trial.data());
+        const uint64_t cost = GetFilterCost(trial.data(), row_bytes_);
+        if (cost < best) {
+          best = cost;
+          memcpy(out, trial.data(), filtered_bytes);
+        }
+      }
+    }
+    chunk_adler_[chunk_id] =
+      UpdateAdler32(1, filtered.data(), filtered.size());
+  };
+  run(chunk_num, filter_task);
+
+  // Every chunk is compressed following the chunk before it, like pigz.
+  auto deflate_task = [&](int chunk_id) {
+    TRACE_SCOPE("Deflate");
+    const std::vector<uint8_t>& dictionary =
+      (chunk_id == 0) ? dictionary_ : filtered_[chunk_id - 1];
+    std::vector<uint8_t>& compressed = compressed_[chunk_id];
+    compressed.clear();
+    if ((row_num_ == 0) && (chunk_id == 0)) {
+      // The zlib header of the 32 KB window and the level.
+      const int kMethod = 0x78;
+      const int level_flag = (level_ < 2) ? 0 : (level_ < 6) ? 1 :
+        (level_ == 6) ? 2 : 3;
+      int flag = level_flag << 6;
+      flag += (31 - ((kMethod << 8) + flag) % 31) % 31;
+      compressed.push_back(static_cast<uint8_t>(kMethod));
+      compressed.push_back(static_cast<uint8_t>(flag));
+    }
+    const std::vector<uint8_t>& data = filtered_[chunk_id];
+    Deflate(
+        dictionary.data(),
+        dictionary.size(),
+        data.data(),
+        data.size(),
+        level_,
+        last && (chunk_id == chunk_num - 1),
+        &compressed);
+  };
+  run(chunk_num, deflate_task);
+
+  // The chunks are written in the order, the stream ends by the Adler-32
+  // of all the filtered bytes.
+  TRACE_SCOPE("PngWriteChunks");
+  for (int chunk_id = 0; chunk_id < chunk_num; ++chunk_id) {
+    std::vector<uint8_t>& compressed = compressed_[chunk_id];
+    adler_ = CombineAdler32(
+        adler_, chunk_adler_[chunk_id], filtered_[chunk_id].size());
+    if (last && (chunk_id == chunk_num - 1)) {
+      uint8_t adler[4];
+      PutBigEndian(adler_, adler);
+      compressed.insert(compressed.end(), adler, adler + 4);
+    }
+    if (!WriteChunk("IDAT", compressed.data(), compressed.size())) break;
+  }
+
+  // The last row and the last filtered bytes are kept for the next batch.
+  if (row_num > 0) {
+    memcpy(prev_row_.data(),
+        &rows[static_cast<size_t>(row_num - 1) * row_bytes_], row_bytes_);
+    const std::vector<uint8_t>& tail = filtered_[chunk_num - 1];
+    const size_t size = (tail.size() < DEFLATE_WINDOW_SIZE) ?
+      tail.size() : DEFLATE_WINDOW_SIZE;
+    dictionary_.assign(tail.end() - size, tail.end());
+  }
+  row_num_ += row_num;
+  return !error_;
+}
+bool PngWriter::Close() {
+  if (fp_ == nullptr) return false;
+  WriteChunk("IEND", nullptr, 0);
+  if (fclose(fp_) != 0) error_ = true;
+  fp_ = nullptr;
+
+  // All the rows must be written.
+  return !error_ && (row_num_ == height_);
+}
+
+bool PngWriter::WriteChunk(const char* type, const uint8_t* data, size_t size) {
+  // The length, the type, the data and the CRC of the type and the data.
+  uint8_t head[8];
+  PutBigEndian(static_cast<uint32_t>(size), head);
+  memcpy(&head[4], type, 4);
+  uint32_t crc = UpdateCrc32(0, &head[4], 4);
+  crc = UpdateCrc32(crc, data, size);
+  uint8_t tail[4];
+  PutBigEndian(crc, tail);
+  if (fwrite(head, sizeof(head), 1, fp_) != 1) error_ = true;
+  if ((size > 0) && (fwrite(data, size, 1, fp_) != 1)) error_ = true;
+  if (fwrite(tail, sizeof(tail), 1, fp_) != 1) error_ = true;
+  return !error_;
+}
@@ -0,0 +1,83 @@
+  // @file png.h
+  // @brief PNG file writer.
+  // @author Mamoru Kaminaga
+  // @date 2026-10-17
+  // Copyright 2026 Mamoru Kaminaga
+  // This program is provided with MIT license. See "LICENSE.md".
+#ifndef PNG_H_
+#define PNG_H_
+
+#include <wchar.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+
+#include "./thread_pool.h"
+
+#include "./common.h"
+
+  // The filter of the rows. The adaptive filter takes the filter of the
+  // smallest sum of the filtered bytes for every row. The canvas has no
+  // gradient to predict, so no filter gives the smallest file by default.
+enum PNG_FILTER {
+  PNG_FILTER_NONE,
+  PNG_FILTER_SUB,
+  PNG_FILTER_UP,
+  PNG_FILTER_AVERAGE,
+  PNG_FILTER_PAETH,
+  PNG_FILTER_ADAPTIVE,
+};
+
+struct PngOption {
+  PNG_FILTER filter;
+  int level;
+  PngOption() : filter(PNG_FILTER_NONE), level(6) { }
+};
+
+  // The PNG file is written from the top row in the batches of rows.
+  // The rows are filtered and compressed in the chunks of the fixed rows on
+  // the threads and joined into one zlib stream, so the file does not
+  // depend on the number of the threads. The bit number is 8 with the
+  // palette of up to 256 colors, or 24 for the RGB rows.
+class PngWriter {
+ public:
+  PngWriter();
+  ~PngWriter();
+
+  bool Open(
+      const wchar_t* file_name,
+      int width,
+      int height,
+      int bit_number,
+      const uint32_t* colors,
+      int color_num,
+      const PngOption& option);
+
+  // The batch of rows should be the multiple of the chunk rows, except
+  // the last batch.
+  int GetChunkRows() const;
+  bool WriteRows(const uint8_t* rows, int row_num, ThreadPool* pool);
+  bool Close();
+
+ private:
+  bool WriteChunk(const char* type, const uint8_t* data, size_t size);
+
+ private:
+  FILE* fp_;
+  int height_;
+  int pixel_bytes_;
+  int row_bytes_;
+  int chunk_rows_;
+  int row_num_;
+  PNG_FILTER filter_;
+  int level_;
+  uint32_t adler_;
+  bool error_;
+  std::vector<uint8_t> prev_row_;
+  std::vector<uint8_t> dictionary_;
+  std::vector<std::vector<uint8_t> > filtered_;
+  std::vector<std::vector<uint8_t> > compressed_;
+  std::vector<uint32_t> chunk_adler_;
+};
+
+#endif  // PNG_H_
@@ -0,0 +1,349 @@
+  // @file preview_pyramid.cc
+  // @brief Downsampled levels of the canvas for the preview.
+  // @author Mamoru Kaminaga
+  // @date 2026-10-17
+  // Copyright 2026 Mamoru Kaminaga
+  // This program is provided with MIT license. See "LICENSE.md".
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+
+#include "./preview_pyramid.h"
+#include "./cpu.h"
+#include "./palette.h"
+#include "./thread_pool.h"
+#include "./trace.h"
+#include "./common.h"
+
+#ifdef CPU_X86
+#include <emmintrin.h>
+#endif
+
+namespace {
+  // The conversion between the 8 bit sRGB and the 14 bit linear light.
+struct SrgbTable {
+  uint16_t to_linear[256];
+  uint8_t to_srgb[PREVIEW_PYRAMID_LINEAR_MAX + 1];
+  SrgbTable() {
+    for (int i = 0; i < 256; ++i) {
+      const double c = i / 255.0;
+      const double l = (c <= 0.04045) ?
+        (c / 12.92) : pow((c + 0.055) / 1.055, 2.4);
+      to_linear[i] =
+        static_cast<uint16_t>(l * PREVIEW_PYRAMID_LINEAR_MAX + 0.5);
+    }
+    for (int i = 0; i <= PREVIEW_PYRAMID_LINEAR_MAX; ++i) {
+      const double l = static_cast<double>(i) / PREVIEW_PYRAMID_LINEAR_MAX;
+      const double c = (l <= 0.0031308) ?
+        (l * 12.92) : (1.055 * pow(l, 1.0 / 2.4) - 0.055);
+      to_srgb[i] = static_cast<uint8_t>(c * 255.0 + 0.5);
+    }
+  }
+};
+const SrgbTable& GetSrgbTable() {
+  static const SrgbTable table;
+  return table;
+}
+uint64_t ToLinear(uint32_t color) {
+  const SrgbTable& table = GetSrgbTable();
+  return static_cast<uint64_t>(table.to_linear[(color >> 16) & 0xff]) |
+    (static_cast<uint64_t>(table.to_linear[(color >> 8) & 0xff]) << 16) |
+    (static_cast<uint64_t>(table.to_linear[color & 0xff]) << 32);
+}
+  // The sums of 4 channels of the canvas pixels from x to x_end - 1 are
+  // added to the 4 lanes of the sum.
+void AccumulateSpan(
+    const uint16_t* color_ids,
+    const uint64_t* linear_colors,
+    int x,
+    int x_end,
+    uint32_t* sum) {
+#ifdef CPU_X86
+  const __m128i zero = _mm_setzero_si128();
+  __m128i acc = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sum));
+  for (; x < x_end; ++x) {
+    const __m128i c = _mm_loadl_epi64(
+        reinterpret_cast<const __m128i*>(&linear_colors[color_ids[x]]));
+    acc = _mm_add_epi32(acc, _mm_unpacklo_epi16(c, zero));
+  }
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(sum), acc);
+#else
+  for (; x < x_end; ++x) {
+    const uint64_t c = linear_colors[color_ids[x]];
+    sum[0] += static_cast<uint32_t>(c & 0xffff);
+    sum[1] += static_cast<uint32_t>((c >> 16) & 0xffff);
+    sum[2] += static_cast<uint32_t>((c >> 32) & 0xffff);
+  }
+#endif
+}
+  // The average of the 2 x 2 pixels, the pixels out of the width are the
+  // last pixel.
+uint64_t Average4(uint64_t a, uint64_t b, uint64_t c, uint64_t d) {
+  uint64_t result = 0;
+  for (int shift = 0; shift < 48; shift += 16) {
+    const uint64_t sum = ((a >> shift) & 0xffff) + ((b >> shift) & 0xffff) +
+      ((c >> shift) & 0xffff) + ((d >> shift) & 0xffff);
+    result |= ((sum + 2) >> 2) << shift;
+  }
+  return result;
+}
+  // The row of the level from the column begin to end - 1 is made from the
+  // two rows of the level above of the width.
+void ReduceRow(
+    const uint64_t* above,
+    const uint64_t* below,
+    int width,
+    int begin,
+    int end,
+    uint64_t* pixels) {
+  int x = begin;
+#ifdef CPU_X86
+  // The two pixels are made from the four pixels of both rows, the 16 bit
+  // sums do not overflow.
+  const __m128i two = _mm_set1_epi16(2);
+  for (; (x + 2 <= end) && (2 * x + 4 <= width); x += 2) {
+    const __m128i a0 =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(&above[2 * x]));
+    const __m128i a1 =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(&above[2 * x + 2]));
+    const __m128i b0 =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(&below[2 * x]));
+    const __m128i b1 =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(&below[2 * x + 2]));
+    __m128i sum = _mm_add_epi16(
+        _mm_unpacklo_epi64(a0, a1), _mm_unpackhi_epi64(a0, a1));
+    sum = _mm_add_epi16(sum, _mm_unpacklo_epi64(b0, b1));
+    sum = _mm_add_epi16(sum, _mm_unpackhi_epi64(b0, b1));
+    sum = _mm_srli_epi16(_mm_add_epi16(sum, two), 2);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&pixels[x]), sum);
+  }
+#endif
+  for (; x < end; ++x) {
+    const int x0 = 2 * x;
+    const int x1 = (x0 + 1 < width) ? (x0 + 1) : x0;
+    pixels[x] = Average4(above[x0], above[x1], below[x0], below[x1]);
+  }
+}
+}  // namespace
+
+PreviewPyramid::PreviewPyramid()
+  : pixel_(0, 0),
+    base_shift_(1),
+    tile_num_(0, 0),
+    dirty_any_(false) { }
+
+void PreviewPyramid::Init(const Vector2n& pixel) {
+  assert(pixel.x > 0);
+  assert(pixel.y > 0);
+  pixel_ = pixel;
+
+  // The sizes are rounded up, the last pixels may cover less of the canvas.
+  base_shift_ = 1;
+  while ((((pixel.x - 1) >> base_shift_) + 1 > PREVIEW_PYRAMID_BASE_SIZE) ||
+      (((pixel.y - 1) >> base_shift_) + 1 > PREVIEW_PYRAMID_BASE_SIZE)) {
+    ++base_shift_;
+  }
+  sizes_.clear();
+  Vector2n size(((pixel.x - 1) >> base_shift_) + 1,
+      ((pixel.y - 1) >> base_shift_) + 1);
+  for (;;) {
+    sizes_.push_back(size);
+    if ((size.x == 1) && (size.y == 1)) break;
+    size = Vector2n((size.x + 1) / 2, (size.y + 1) / 2);
+  }
+  levels_.clear();
+  colors_.clear();
+  tile_num_.x = (sizes_[0].x + PREVIEW_PYRAMID_TILE - 1) / PREVIEW_PYRAMID_TILE;
+  tile_num_.y = (sizes_[0].y + PREVIEW_PYRAMID_TILE - 1) / PREVIEW_PYRAMID_TILE;
+  dirty_.assign(static_cast<size_t>(tile_num_.x) * tile_num_.y, 1);
+  dirty_any_ = true;
+}
+int PreviewPyramid::GetLevelNum() const {
+  return static_cast<int>(sizes_.size());
+}
+Vector2n PreviewPyramid::GetLevelSize(int level) const {
+  assert((level >= 0) && (level < GetLevelNum()));
+  return sizes_[level];
+}
+int PreviewPyramid::GetLevelShift(int level) const {
+  assert((level >= 0) && (level < GetLevelNum()));
+  return base_shift_ + level;
+}
+int PreviewPyramid::FindLevel(const Vector2n& size) const {
+  for (int level = 0; level < GetLevelNum(); ++level) {
+    if ((sizes_[level].x <= size.x) && (sizes_[level].y <= size.y)) {
+      return level;
+    }
+  }
+  return GetLevelNum() - 1;
+}
+
+void PreviewPyramid::Invalidate() {
+  std::fill(dirty_.begin(), dirty_.end(), 1);
+  dirty_any_ = true;
+}
+void PreviewPyramid::InvalidateRect(const Rect2n& rect) {
+  // The rectangle is clipped by the canvas and rounded out to the tiles.
+  const int tile_shift_pixels = PREVIEW_PYRAMID_TILE << base_shift_;
+  const int left = (rect.left > 0) ? rect.left : 0;
+  const int top = (rect.top > 0) ? rect.top : 0;
+  const int right = (rect.right < pixel_.x) ? rect.right : pixel_.x;
+  const int bottom = (rect.bottom < pixel_.y) ? rect.bottom : pixel_.y;
+  if ((left >= right) || (top >= bottom)) return;
+  for (int ty = top / tile_shift_pixels;
+      ty <= (bottom - 1) / tile_shift_pixels; ++ty) {
+    for (int tx = left / tile_shift_pixels;
+        tx <= (right - 1) / tile_shift_pixels; ++tx) {
+      dirty_[static_cast<size_t>(ty) * tile_num_.x + tx] = 1;
+    }
+  }
+  dirty_any_ = true;
+}
+
+void PreviewPyramid::Update(
+    const Palette& palette,
+    const RowLoader& load_row,
+    ThreadPool* pool) {
+  // The levels are built again when the palette has changed.
+  const int color_num = palette.GetColorNum();
+  const uint32_t* colors = palette.GetPackedColors();
+  if ((static_cast<int>(colors_.size()) != color_num) ||
+      !std::equal(colors_.begin(), colors_.end(), colors)) {
+    colors_.assign(colors, colors + color_num);
+    linear_colors_.resize(color_num);
+    for (int i = 0; i < color_num; ++i) linear_colors_[i] = ToLinear(colors[i]);
+    Invalidate();
+  }
+  if (levels_.empty()) {
+    levels_.resize(sizes_.size());
+    for (size_t i = 0; i < sizes_.size(); ++i) {
+      levels_[i].assign(static_cast<size_t>(sizes_[i].x) * sizes_[i].y, 0);
+    }
+  }
+  if (!dirty_any_) return;
+  TRACE_SCOPE("PreviewPyramid::Update");
+
+  // The rows of the tiles are divided among the threads, the canvas rows
+  // are loaded once for all the dirty tiles of the row.
+  auto task = [&](int tile_y) {
+    UpdateBase(load_row, tile_y);
+  };
+  if (pool != nullptr) {
+    pool->Run(tile_num_.y, task);
+  } else {
+    for (int tile_y = 0; tile_y < tile_num_.y; ++tile_y) task(tile_y);
+  }
+
+  // The smaller levels are made in the bounds of the dirty tiles.
+  Rect2n rect(sizes_[0].x, sizes_[0].y, 0, 0);
+  for (int ty = 0; ty < tile_num_.y; ++ty) {
+    for (int tx = 0; tx < tile_num_.x; ++tx) {
+      uint8_t& dirty = dirty_[static_cast<size_t>(ty) * tile_num_.x + tx];
+      if (dirty == 0) continue;
+      dirty = 0;
+      rect.left = std::min(rect.left, tx * PREVIEW_PYRAMID_TILE);
+      rect.top = std::min(rect.top, ty * PREVIEW_PYRAMID_TILE);
+      rect.right = std::max(rect.right, (tx + 1) * PREVIEW_PYRAMID_TILE);
+      rect.bottom = std::max(rect.bottom, (ty + 1) * PREVIEW_PYRAMID_TILE);
+    }
+  }
+  dirty_any_ = false;
+  for (int level = 1; level < GetLevelNum(); ++level) {
+    rect = Rect2n(rect.left / 2, rect.top / 2,
+        (rect.right + 1) / 2, (rect.bottom + 1) / 2);
+    Reduce(level, rect);
+  }
+}
+void PreviewPyramid::GetRow(
+    int level,
+    int y,
+    int begin,
+    int end,
+    uint32_t* colors) const {
+  assert((level >= 0) && (level < static_cast<int>(levels_.size())));
+  assert((y >= 0) && (y < sizes_[level].y));
+  assert((begin >= 0) && (end <= sizes_[level].x));
+  const SrgbTable& table = GetSrgbTable();
+  const uint64_t* pixels =
+    &levels_[level][static_cast<size_t>(y) * sizes_[level].x];
+  for (int x = begin; x < end; ++x) {
+    const uint64_t p = pixels[x];
+    colors[x] =
+      (static_cast<uint32_t>(table.to_srgb[p & 0xffff]) << 16) |
+      (static_cast<uint32_t>(table.to_srgb[(p >> 16) & 0xffff]) << 8) |
+      static_cast<uint32_t>(table.to_srgb[(p >> 32) & 0xffff]);
+  }
+}
+
+void PreviewPyramid::UpdateBase(const RowLoader& load_row, int tile_y) {
+  // The dirty tiles of the row are merged into the spans of the columns.
+  const Vector2n& size = sizes_[0];
+  std::vector<int> spans;
+  for (int tx = 0; tx < tile_num_.x; ++tx) {
+    if (dirty_[static_cast<size_t>(tile_y) * tile_num_.x + tx] == 0) continue;
+    const int begin = tx * PREVIEW_PYRAMID_TILE;
+    const int end = std::min(begin + PREVIEW_PYRAMID_TILE, size.x);
+    if (!spans.empty() && (spans.back() == begin)) {
+      spans.back() = end;
+    } else {
+      spans.push_back(begin);
+      spans.push_back(end);
+    }
+  }
+  if (spans.empty()) return;
+  TRACE_SCOPE("PreviewPyramid::Tiles");
+
+  // The sums of every pixel of the level are taken over the canvas pixels
+  // it covers, then rounded to the average.
+  const int cover = 1 << base_shift_;
+  std::vector<uint16_t> color_ids(pixel_.x);
+  std::vector<uint32_t> sums(static_cast<size_t>(size.x) * 4);
+  const int y_end = std::min((tile_y + 1) * PREVIEW_PYRAMID_TILE, size.y);
+  for (int y = tile_y * PREVIEW_PYRAMID_TILE; y < y_end; ++y) {
+    for (size_t i = 0; i < spans.size(); i += 2) {
+      std::fill(&sums[spans[i] * 4], &sums[spans[i + 1] * 4], 0);
+    }
+    const int canvas_y = y << base_shift_;
+    const int canvas_y_end = std::min(canvas_y + cover, pixel_.y);
+    for (int cy = canvas_y; cy < canvas_y_end; ++cy) {
+      load_row(cy, color_ids.data());
+      for (size_t i = 0; i < spans.size(); i += 2) {
+        for (int x = spans[i]; x < spans[i + 1]; ++x) {
+          const int canvas_x = x << base_shift_;
+          AccumulateSpan(color_ids.data(), linear_colors_.data(), canvas_x,
+              std::min(canvas_x + cover, pixel_.x), &sums[x * 4]);
+        }
+      }
+    }
+    uint64_t* pixels = &levels_[0][static_cast<size_t>(y) * size.x];
+    for (size_t i = 0; i < spans.size(); i += 2) {
+      for (int x = spans[i]; x < spans[i + 1]; ++x) {
+        const uint32_t count = static_cast<uint32_t>(
+            (std::min((x + 1) << base_shift_, pixel_.x) - (x << base_shift_)) *
+            (canvas_y_end - canvas_y));
+        const uint32_t* sum = &sums[x * 4];
+        pixels[x] = static_cast<uint64_t>((sum[0] + count / 2) / count) |
+          (static_cast<uint64_t>((sum[1] + count / 2) / count) << 16) |
+          (static_cast<uint64_t>((sum[2] + count / 2) / count) << 32);
+      }
+    }
+  }
+}
+void PreviewPyramid::Reduce(int level, const Rect2n& rect) {
+  const Vector2n& above_size = sizes_[level - 1];
+  const Vector2n& size = sizes_[level];
+  const int right = std::min(rect.right, size.x);
+  const int bottom = std::min(rect.bottom, size.y);
+  const std::vector<uint64_t>& above = levels_[level - 1];
+  for (int y = rect.top; y < bottom; ++y) {
+    const int y0 = 2 * y;
+    const int y1 = (y0 + 1 < above_size.y) ? (y0 + 1) : y0;
+    ReduceRow(
+        &above[static_cast<size_t>(y0) * above_size.x],
+        &above[static_cast<size_t>(y1) * above_size.x],
+        above_size.x, rect.left, right,
+        &levels_[level][static_cast<size_t>(y) * size.x]);
+  }
+}
@@ -0,0 +1,83 @@
+  // @file preview_pyramid.h
+  // @brief Downsampled levels of the canvas for the preview.
+  // @author Mamoru Kaminaga
+  // @date 2026-10-17
+  // Copyright 2026 Mamoru Kaminaga
+  // This program is provided with MIT license. See "LICENSE.md".
+#ifndef PREVIEW_PYRAMID_H_
+#define PREVIEW_PYRAMID_H_
+
+#include <stdint.h>
+#include <functional>
+#include <vector>
+
+#include "./palette.h"
+#include "./thread_pool.h"
+
+#include "./common.h"
+
+  // The first level is the largest half of the canvas not larger than this
+  // number of pixels in both directions.
+#define PREVIEW_PYRAMID_BASE_SIZE   (1024)
+
+  // The first level is invalidated by the tiles of this number of pixels.
+#define PREVIEW_PYRAMID_TILE        (32)
+
+  // The levels hold the colors in the linear light of 14 bits per channel,
+  // so the sum of four pixels fits in 16 bits.
+#define PREVIEW_PYRAMID_LINEAR_MAX  (16383)
+
+  // The pyramid of the canvas, every level is the half of the level above
+  // by the box filter of the colors in the linear light, down to 1 x 1.
+  // The first level is the canvas reduced by the power of 2 at once. The
+  // levels are built again only for the tiles invalidated since the last
+  // update, or all of them when the palette has changed.
+class PreviewPyramid {
+ public:
+  // The color ids of the canvas row y are loaded into the buffer of the
+  // canvas width, the loader is called on the threads of the pool.
+  typedef std::function<void(int, uint16_t*)> RowLoader;
+
+  PreviewPyramid();
+
+  // The sizes of the levels are set, the levels are allocated by the first
+  // update.
+  void Init(const Vector2n& pixel);
+  int GetLevelNum() const;
+  Vector2n GetLevelSize(int level) const;
+
+  // The level is the canvas reduced by 1 << shift.
+  int GetLevelShift(int level) const;
+
+  // The finest level which fits in the size.
+  int FindLevel(const Vector2n& size) const;
+
+  // The rectangle is of the canvas pixels.
+  void Invalidate();
+  void InvalidateRect(const Rect2n& rect);
+
+  void Update(const Palette& palette, const RowLoader& load_row,
+      ThreadPool* pool);
+
+  // The packed colors of the level row from the column begin to end - 1.
+  void GetRow(int level, int y, int begin, int end, uint32_t* colors) const;
+
+ private:
+  void UpdateBase(const RowLoader& load_row, int tile_y);
+  void Reduce(int level, const Rect2n& rect);
+
+ private:
+  Vector2n pixel_;
+  int base_shift_;
+  std::vector<Vector2n> sizes_;
+
+  // The pixel is the 16 bit channels of R, G, B and 0 from the low bits.
+  std::vector<std::vector<uint64_t> > levels_;
+  std::vector<uint64_t> linear_colors_;
+  std::vector<uint32_t> colors_;
+  Vector2n tile_num_;
+  std::vector<uint8_t> dirty_;
+  bool dirty_any_;
+};
+
+#endif  // PREVIEW_PYRAMID_H_
@@ -0,0 +1,319 @@
+  // @file random.cc
+  // @brief SIMD counter based random numbers.
+  // @author Mamoru Kaminaga
+  // @date 2026-10-17
+  // Copyright 2026 Mamoru Kaminaga
+  // This program is provided with MIT license. See "LICENSE.md".
+#include <assert.h>
+#include <stdint.h>
+
+#include "./random.h"
+#include "./cpu.h"
+#include "./sampler.h"
+
+#ifdef CPU_X86
+#include <emmintrin.h>
+#include <immintrin.h>
+#endif
+
+  // The constants of Philox4x32.
+#define PHILOX_M0         (0xD2511F53U)
+#define PHILOX_M1         (0xCD9E8D57U)
+#define PHILOX_W0         (0x9E3779B9U)
+#define PHILOX_W1         (0xBB67AE85U)
+#define PHILOX_ROUND_NUM  (10)
+
+namespace {
+  // The kernel fills whole groups of the values.
+typedef void (*GroupKernel)(
+    const uint32_t key[2],
+    uint64_t group,
+    int group_num,
+    uint32_t* values);
+
+#ifndef CPU_X86
+  // The scalar kernel, one block at a time.
+void PhiloxScalar(const uint32_t key[2], uint64_t block, uint32_t out[4]) {
+  uint32_t c0 = static_cast<uint32_t>(block);
+  uint32_t c1 = static_cast<uint32_t>(block >> 32);
+  uint32_t c2 = 0;
+  uint32_t c3 = 0;
+  uint32_t k0 = key[0];
+  uint32_t k1 = key[1];
+  for (int round = 0; round < PHILOX_ROUND_NUM; ++round) {
+    const uint64_t p0 = static_cast<uint64_t>(PHILOX_M0) * c0;
+    const uint64_t p1 = static_cast<uint64_t>(PHILOX_M1) * c2;
+    c0 = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ k0;
+    c1 = static_cast<uint32_t>(p1);
+    c2 = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ k1;
+    c3 = static_cast<uint32_t>(p0);
+    k0 += PHILOX_W0;
+    k1 += PHILOX_W1;
+  }
+  out[0] = c0;
+  out[1] = c1;
+  out[2] = c2;
+  out[3] = c3;
+}
+void FillScalar(
+    const uint32_t key[2],
+    uint64_t group,
+    int group_num,
+    uint32_t* values) {
+  uint32_t out[4];
+  for (int i = 0; i < group_num; ++i) {
+    for (int lane = 0; lane < RANDOM_LANE_NUM; ++lane) {
+      PhiloxScalar(key, (group + i) * RANDOM_LANE_NUM + lane, out);
+      for (int word = 0; word < 4; ++word) {
+        values[word * RANDOM_LANE_NUM + lane] = out[word];
+      }
+    }
+    values += RANDOM_GROUP_SIZE;
+  }
+}
+
+#else
+  // The SSE2 kernel, the eight blocks are computed as two halves.
+inline void MulHiLo128(__m128i a, __m128i m, __m128i* hi, __m128i* lo) {
+  const __m128i even = _mm_shuffle_epi32(
+      _mm_mul_epu32(a, m), _MM_SHUFFLE(3, 1, 2, 0));
+  const __m128i odd = _mm_shuffle_epi32(
+      _mm_mul_epu32(_mm_srli_epi64(a, 32), m), _MM_SHUFFLE(3, 1, 2, 0));
+  *lo = _mm_unpacklo_epi32(even, odd);
+  *hi = _mm_unpackhi_epi32(even, odd);
+}
+void Philox128(const uint32_t key[2], uint64_t block, __m128i c[4]) {
+  const __m128i m0 = _mm_set1_epi32(static_cast<int>(PHILOX_M0));
+  const __m128i m1 = _mm_set1_epi32(static_cast<int>(PHILOX_M1));
+  c[0] = _mm_add_epi32(
+      _mm_set1_epi32(static_cast<int>(block)), _mm_setr_epi32(0, 1, 2, 3));
+  c[1] = _mm_set1_epi32(static_cast<int>(block >> 32));
+  c[2] = _mm_setzero_si128();
+  c[3] = _mm_setzero_si128();
+  uint32_t k0 = key[0];
+  uint32_t k1 = key[1];
+  __m128i hi0, lo0, hi1, lo1;
+  for (int round = 0; round < PHILOX_ROUND_NUM; ++round) {
+    MulHiLo128(c[0], m0, &hi0, &lo0);
+    MulHiLo128(c[2], m1, &hi1, &lo1);
+    c[0] = _mm_xor_si128(
+        _mm_xor_si128(hi1, c[1]), _mm_set1_epi32(static_cast<int>(k0)));
+    c[1] = lo1;
+    c[2] = _mm_xor_si128(
+        _mm_xor_si128(hi0, c[3]), _mm_set1_epi32(static_cast<int>(k1)));
+    c[3] = lo0;
+    k0 += PHILOX_W0;
+    k1 += PHILOX_W1;
+  }
+}
+void FillSse2(
+    const uint32_t key[2],
+    uint64_t group,
+    int group_num,
+    uint32_t* values) {
+  __m128i c[4];
+  for (int i = 0; i < group_num; ++i) {
+    const uint64_t block = (group + i) * RANDOM_LANE_NUM;
+    for (int half = 0; half < 2; ++half) {
+      Philox128(key, block + half * 4, c);
+      for (int word = 0; word < 4; ++word) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(
+              &values[word * RANDOM_LANE_NUM + half * 4]), c[word]);
+      }
+    }
+    values += RANDOM_GROUP_SIZE;
+  }
+}
+
+  // The AVX2 kernel, the eight blocks are computed at once.
+TARGET_AVX2 inline void MulHiLo256(
+    __m256i a,
+    __m256i m,
+    __m256i* hi,
+    __m256i* lo) {
+  const __m256i even = _mm256_shuffle_epi32(
+      _mm256_mul_epu32(a, m), _MM_SHUFFLE(3, 1, 2, 0));
+  const __m256i odd = _mm256_shuffle_epi32(
+      _mm256_mul_epu32(_mm256_srli_epi64(a, 32), m),
+      _MM_SHUFFLE(3, 1, 2, 0));
+  *lo = _mm256_unpacklo_epi32(even, odd);
+  *hi = _mm256_unpackhi_epi32(even, odd);
+}
+TARGET_AVX2 inline void Philox256(
+    const uint32_t key[2],
+    uint64_t block,
+    __m256i c[4]) {
+  const __m256i m0 = _mm256_set1_epi32(static_cast<int>(PHILOX_M0));
+  const __m256i m1 = _mm256_set1_epi32(static_cast<int>(PHILOX_M1));
+  c[0] = _mm256_add_epi32(
+      _mm256_set1_epi32(static_cast<int>(block)),
+      _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+  c[1] = _mm256_set1_epi32(static_cast<int>(block >> 32));
+  c[2] = _mm256_setzero_si256();
+  c[3] = _mm256_setzero_si256();
+  uint32_t k0 = key[0];
+  uint32_t k1 = key[1];
+  __m256i hi0, lo0, hi1, lo1;
+  for (int round = 0; round < PHILOX_ROUND_NUM; ++round) {
+    MulHiLo256(c[0], m0, &hi0, &lo0);
+    MulHiLo256(c[2], m1, &hi1, &lo1);
+    c[0] = _mm256_xor_si256(
+        _mm256_xor_si256(hi1, c[1]),
+        _mm256_set1_epi32(static_cast<int>(k0)));
+    c[1] = lo1;
+    c[2] = _mm256_xor_si256(
+        _mm256_xor_si256(hi0, c[3]),
+        _mm256_set1_epi32(static_cast<int>(k1)));
+    c[3] = lo0;
+    k0 += PHILOX_W0;
+    k1 += PHILOX_W1;
+  }
+}
+TARGET_AVX2 void FillAvx2(
+    const uint32_t key[2],
+    uint64_t group,
+    int group_num,
+    uint32_t* values) {
+  __m256i c[4];
+  for (int i = 0; i < group_num; ++i) {
+    Philox256(key, (group + i) * RANDOM_LANE_NUM, c);
+    for (int word = 0; word < 4; ++word) {
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(
+            &values[word * RANDOM_LANE_NUM]), c[word]);
+    }
+    values += RANDOM_GROUP_SIZE;
+  }
+}
+
+  // The random values are mapped to the buckets in the same registers,
+  // the alias table is read by gathers.
+TARGET_AVX2 inline __m256i Bucket256(
+    __m256i random,
+    __m256i grid,
+    const uint32_t* thresholds,
+    const int* aliases) {
+  // The 32 x 32 bit products, the upper half is the column.
+  const __m256i even = _mm256_mul_epu32(random, grid);
+  const __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(random, 32), grid);
+  const __m256i column = _mm256_blend_epi32(
+      _mm256_srli_epi64(even, 32), odd, 0xAA);
+  const __m256i coin = _mm256_blend_epi32(
+      even, _mm256_slli_epi64(odd, 32), 0xAA);
+  const __m256i threshold = _mm256_i32gather_epi32(
+      reinterpret_cast<const int*>(thresholds), column, 4);
+  const __m256i alias = _mm256_i32gather_epi32(aliases, column, 4);
+
+  // The unsigned comparison by flipping the sign bits.
+  const __m256i sign = _mm256_set1_epi32(INT32_MIN);
+  const __m256i accept = _mm256_cmpgt_epi32(
+      _mm256_xor_si256(threshold, sign), _mm256_xor_si256(coin, sign));
+  return _mm256_blendv_epi8(alias, column, accept);
+}
+TARGET_AVX2 void SampleBucketsAvx2(
+    const uint32_t key[2],
+    const BucketSampler& sampler,
+    uint64_t group,
+    int group_num,
+    int* bucket_ids) {
+  const __m256i grid = _mm256_set1_epi32(sampler.GetGrid());
+  const uint32_t* thresholds = sampler.GetThresholds();
+  const int* aliases = sampler.GetAliases();
+  __m256i c[4];
+  for (int i = 0; i < group_num; ++i) {
+    Philox256(key, (group + i) * RANDOM_LANE_NUM, c);
+    for (int word = 0; word < 4; ++word) {
+      const __m256i bucket = Bucket256(c[word], grid, thresholds, aliases);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(
+            &bucket_ids[word * RANDOM_LANE_NUM]), bucket);
+    }
+    bucket_ids += RANDOM_GROUP_SIZE;
+  }
+}
+#endif
+
+GroupKernel SelectKernel() {
+#ifdef CPU_X86
+  return CpuHasAvx2() ? &FillAvx2 : &FillSse2;
+#else
+  return &FillScalar;
+#endif
+}
+}  // namespace
+
+PixelRandom::PixelRandom() {
+  Seed(0);
+}
+
+void PixelRandom::Seed(uint32_t seed) {
+  key_[0] = seed;
+  key_[1] = 0;
+}
+void PixelRandom::Fill(uint64_t first, uint32_t* values, int num) const {
+  assert(values);
+  static const GroupKernel kernel = SelectKernel();
+
+  // The whole groups are filled in place, the partial groups are copied.
+  uint32_t group_values[RANDOM_GROUP_SIZE];
+  uint64_t index = first;
+  int done = 0;
+  while (done < num) {
+    const uint64_t group = index / RANDOM_GROUP_SIZE;
+    const int offset = static_cast<int>(index % RANDOM_GROUP_SIZE);
+    const int group_num = (num - done) / RANDOM_GROUP_SIZE;
+    if ((offset == 0) && (group_num > 0)) {
+      kernel(key_, group, group_num, &values[done]);
+      done += group_num * RANDOM_GROUP_SIZE;
+      index += group_num * RANDOM_GROUP_SIZE;
+    } else {
+      kernel(key_, group, 1, group_values);
+      int copy_num = RANDOM_GROUP_SIZE - offset;
+      if (copy_num > num - done) copy_num = num - done;
+      for (int i = 0; i < copy_num; ++i) {
+        values[done + i] = group_values[offset + i];
+      }
+      done += copy_num;
+      index += copy_num;
+    }
+  }
+}
+void PixelRandom::SampleBuckets(
+    const BucketSampler& sampler,
+    uint64_t first,
+    int* bucket_ids,
+    int num) const {
+  assert(bucket_ids);
+#ifdef CPU_X86
+  if (CpuHasAvx2()) {
+    // The head up to the group boundary is sampled by the scalar path.
+    int head = static_cast<int>(
+        (RANDOM_GROUP_SIZE - first % RANDOM_GROUP_SIZE) % RANDOM_GROUP_SIZE);
+    if (head > num) head = num;
+    const int group_num = (num - head) / RANDOM_GROUP_SIZE;
+    if (group_num > 0) {
+      SampleBucketsAvx2(
+          key_,
+          sampler,
+          (first + head) / RANDOM_GROUP_SIZE,
+          group_num,
+          &bucket_ids[head]);
+      const int body = group_num * RANDOM_GROUP_SIZE;
+      uint32_t* values = reinterpret_cast<uint32_t*>(bucket_ids);
+      Fill(first, values, head);
+      Fill(first + head + body, &values[head + body], num - head - body);
+      for (int i = 0; i < head; ++i) {
+        bucket_ids[i] = sampler.Sample(values[i]);
+      }
+      for (int i = head + body; i < num; ++i) {
+        bucket_ids[i] = sampler.Sample(values[i]);
+      }
+      return;
+    }
+  }
+#endif
+  // The values are generated into the output and mapped in place.
+  uint32_t* values = reinterpret_cast<uint32_t*>(bucket_ids);
+  Fill(first, values, num);
+  for (int i = 0; i < num; ++i) {
+    bucket_ids[i] = sampler.Sample(values[i]);
+  }
+}
@@ -0,0 +1,40 @@
+  // @file random.h
+  // @brief SIMD counter based random numbers.
+  // @author Mamoru Kaminaga
+  // @date 2026-10-17
+  // Copyright 2026 Mamoru Kaminaga
+  // This program is provided with MIT license. See "LICENSE.md".
+#ifndef RANDOM_H_
+#define RANDOM_H_
+
+#include <stdint.h>
+
+#include "./sampler.h"
+
+  // The pixels are keyed in groups of 32, one Philox block gives 4 values
+  // and 8 blocks are computed together.
+#define RANDOM_LANE_NUM   (8)
+#define RANDOM_GROUP_SIZE (32)
+
+  // Philox4x32-10 random numbers keyed by the seed and the pixel index.
+  // The value of a pixel does not depend on the other pixels, so any part
+  // of the canvas is generated in any order on any thread with the same
+  // result. The AVX2, SSE2 and scalar kernels produce the same values.
+class PixelRandom {
+ public:
+  PixelRandom();
+
+  void Seed(uint32_t seed);
+
+  void Fill(uint64_t first, uint32_t* values, int num) const;
+  void SampleBuckets(
+      const BucketSampler& sampler,
+      uint64_t first,
+      int* bucket_ids,
+      int num) const;
+
+ private:
+  uint32_t key_[2];
+};
+
+#endif  // RANDOM_H_
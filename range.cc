@@ -4,149 +4,126 @@
   // @date 2017-11-17
   // Copyright 2017 Mamoru Kaminaga
   // This program is provided with MIT license. See "LICENSE.md".
+#include <assert.h>
 #include <wchar.h>
-#include <windows.h>
-#include <gdiplus.h>
+#include <stdint.h>
 #include <vector>
-#include <memory>
 
 #include "./range.h"
-#include "./utility.h"
-
-#include "./resource.h"
-
-Range::Range() = default;
-
-void Range::Create(HWND hwnd, int grid, const wchar_t* file_name) {
-  // The palette size and color vector is set.
+#include "./palette.h"
+#include "./raster.h"
+#include "./common.h"
+
+Range::Range()
+  : grid_(0),
+    color_num_(0),
+    selected_grid_id_(0),
+    curve_(false) { }
+
+void Range::Init(int grid) {
+  // The range size and color vector is set.
   selected_grid_id_ = 0;
-  grid_ = grid;
+  grid_ = (grid < RANGE_MAX_GRID) ? grid : RANGE_MAX_GRID;
   color_num_ = grid_;
-  color_id_.resize(grid_);
-
-  // Window handle and size is acquired.
-  HWND hwnd_palette = GetDlgItem(hwnd, IDC_PIC_RANGE);
-  RECT rc;
-  GetClientRect(hwnd_palette, &rc);
-  size_.x = (rc.right - rc.left);
-  size_.y = (rc.bottom - rc.top);
-
-  // The off-screen draw buffer is created.
-  hdc_offscreen_ = CreateCompatibleDC(nullptr);
-  HDC hdc = GetDC(hwnd_palette);
-  hdc_bitmap_ = CreateCompatibleBitmap(hdc, size_.x, size_.y);
-  ReleaseDC(hwnd_palette, hdc);
-  SelectObject(hdc_offscreen_, hdc_bitmap_);
-
-  // Drawing tools are created, initial brush color is black.
-  grid_pen_ = CreatePen(PS_SOLID, 1, RGB(64, 64, 64));
-  select_pen_ = CreatePen(PS_SOLID, 2, RGB(255, 255, 255));
-
-  // The GDI+ object is created.
-  Gdiplus::GdiplusStartupInput gdi_startup_info;
-  Gdiplus::GdiplusStartup(&gdi_token_, &gdi_startup_info, nullptr);
-  graph_image_.reset(new Gdiplus::Image(file_name));
-
-  // The default value is set.
-  selected_grid_id_ = 0;
+  color_id_.assign(grid_, 0);
 }
-void Range::Paint(HWND hwnd, const Palette& palette) {
-  // Window handle and size is acquired.
-  HWND hwnd_palette = GetDlgItem(hwnd, IDC_PIC_RANGE);
-
-  // The color cells are drawn to the off-screen buffer.
-  int x = 0;
-  int x2 = 0;
-  SelectObject(hdc_offscreen_, grid_pen_);
-  for (int grid_id = 0; grid_id < grid_; ++grid_id) {
-    // Draw target cell with tools.
-    x = static_cast<int>(size_.x * grid_id / static_cast<double>(grid_));
-    x2 = static_cast<int>(size_.x * (grid_id + 1) / static_cast<double>(grid_));
-    SelectObject(hdc_offscreen_, palette.GetBrush(color_id_[grid_id]));
-    Rectangle(hdc_offscreen_, x, 0, x2, size_.y);
-  }
-
-  // The selected grid guide is drawn.
-  int nx = selected_grid_id_;
-  x = static_cast<int>(size_.x * nx / static_cast<double>(grid_));
-  x2 = static_cast<int>(size_.x * (nx + 1) / static_cast<double>(grid_));
-  SelectObject(hdc_offscreen_, select_pen_);
-  SelectObject(hdc_offscreen_, palette.GetBrush(color_id_[selected_grid_id_]));
-  Rectangle(hdc_offscreen_, x, 0, x2, size_.y);
-
-  // The image of distribution graph is drawn.
-  Gdiplus::Graphics graphics(hdc_offscreen_);
-  graphics.DrawImage(graph_image_.get(), 0, 0, size_.x, size_.y);
-
-  // Flip screen.
-  HDC hdc = GetDC(hwnd_palette);
-  BitBlt(hdc, 0, 0, size_.x, size_.y, hdc_offscreen_, 0, 0, SRCCOPY);
-  ReleaseDC(hwnd_palette, hdc);
+void Range::SetColorId(int grid_id, int color_id) {
+  // Store color id.
+  color_id_[grid_id] = color_id;
+  raster_.InvalidateCells(Rect2n(grid_id, 0, grid_id + 1, 1));
 }
-void Range::Destroy(HWND hwnd) {
-  // Drawing tools are deleted.
-  DeleteObject(grid_pen_);
-  DeleteObject(select_pen_);
-
-  // The off-screen draw buffer is released.
-  if (hdc_offscreen_) {
-    DeleteDC(hdc_offscreen_);
-    hdc_offscreen_ = nullptr;
-  }
-  if (hdc_bitmap_) {
-    DeleteObject(hdc_bitmap_);
-    hdc_bitmap_ = nullptr;
-  }
-
-  // The GDI+ object is deleted.
-  graph_image_.reset(nullptr);
-  Gdiplus::GdiplusShutdown(gdi_token_);
-
-  // Warnings are prevented for non-used parameters.
-  UNREFERENCED_PARAMETER(hwnd);
+void Range::SetSize(const Vector2n& size) {
+  // The frame buffer has one cell per grid.
+  size_ = size;
+  raster_.Init(size_);
+  raster_.SetGrid(Vector2n(grid_, 1));
+  if (curve_) MakeCurve();
 }
-
-bool Range::SelectGrid(HWND hwnd, int mouse_x, int mouse_y) {
-  // The relative mouse position is passed.
-  RECT rc;
-  GetWindowRect(GetDlgItem(hwnd, IDC_PIC_RANGE), &rc);
-  POINT pt;
-  pt.x = rc.left;
-  pt.y = rc.top;
-  ScreenToClient(hwnd, &pt);
-  int x = mouse_x - pt.x;
-  int y = mouse_y - pt.y;
-
-  // Illegal cases.
-  if (x < 0) return false;
-  if (x > size_.x) return false;
-  if (y < 0) return false;
-  if (y > size_.y) return false;
-
-  // Position to select.
-  const int nx = static_cast<int>(grid_ * x / static_cast<double>(size_.x));
-  selected_grid_id_ = nx;
-  return true;
+void Range::SetSelectedGridId(int grid_id) {
+  assert((grid_id >= 0) && (grid_id < grid_));
+
+  // The old and the new selected cells are drawn again.
+  raster_.InvalidateCells(
+      Rect2n(selected_grid_id_, 0, selected_grid_id_ + 1, 1));
+  selected_grid_id_ = grid_id;
+  raster_.InvalidateCells(Rect2n(grid_id, 0, grid_id + 1, 1));
 }
-void Range::SetColor(HWND hwnd, const Palette& palette) {
-  // Store color id.
-  color_id_[selected_grid_id_] = palette.GetSelectedColorId();
 
-  // Warnings are prevented for non-used parameters.
-  UNREFERENCED_PARAMETER(hwnd);
+void Range::SetDistribution(const Distribution& distribution) {
+  assert(IsValidDistribution(distribution));
+  distribution_ = distribution;
+  curve_ = true;
+  MakeCurve();
 }
-void Range::SetAllColor(HWND hwnd, const Palette& palette) {
-  for (int grid_id = 0; grid_id < grid_; ++grid_id) {
-    // Store color id.
-    color_id_[grid_id] = palette.GetSelectedColorId();
-  }
 
-  // Warnings are prevented for non-used parameters.
-  UNREFERENCED_PARAMETER(hwnd);
-}
 int Range::GetColorId(int grid_id) const {
   return color_id_[grid_id];
 }
 int Range::GetGrid() const {
   return grid_;
 }
+const Distribution& Range::GetDistribution() const {
+  return distribution_;
+}
+
+void Range::Invalidate() {
+  raster_.Invalidate();
+}
+void Range::Render(const Palette& palette) {
+  // Only the dirty cells are drawn with the grid lines.
+  const uint32_t kGridColor = Raster::MakeColor(RGBVecotr(64, 64, 64));
+  const uint32_t kSelectColor = Raster::MakeColor(RGBVecotr(255, 255, 255));
+  int begin = 0;
+  int end = 0;
+  if (!raster_.GetDirtyColumns(0, &begin, &end)) {
+    raster_.EndFrame();
+    return;
+  }
+  std::vector<uint32_t> cell_colors(grid_);
+  for (int grid_id = begin; grid_id < end; ++grid_id) {
+    cell_colors[grid_id] = palette.GetPackedColor(color_id_[grid_id]);
+  }
+  raster_.FillCells(0, begin, end, cell_colors.data());
+  for (int grid_id = begin; grid_id < end; ++grid_id) {
+    raster_.FrameRect(raster_.GetCellRect(grid_id, 0), kGridColor, 1);
+  }
+
+  // The selected grid guide is drawn.
+  if ((selected_grid_id_ >= begin) && (selected_grid_id_ < end)) {
+    raster_.FrameRect(
+        raster_.GetCellRect(selected_grid_id_, 0), kSelectColor, 2);
+  }
+  raster_.EndFrame();
+}
+const Raster& Range::GetRaster() const {
+  return raster_;
+}
+
+void Range::MakeCurve() {
+  if ((size_.x <= 0) || (size_.y <= 0)) return;
+
+  // The density of every column is scaled to the height, the area under
+  // the curve is lightened and the curve is drawn dark.
+  const uint32_t kFillColor = 0x50ffffff;
+  const uint32_t kLineColor = 0xc0000000;
+  const int kLineWidth = 2;
+  std::vector<double> densities;
+  GetDensities(distribution_, size_.x, &densities);
+  double max_density = 0.0;
+  for (int x = 0; x < size_.x; ++x) {
+    if (densities[x] > max_density) max_density = densities[x];
+  }
+  std::vector<uint32_t> overlay(static_cast<size_t>(size_.x) * size_.y, 0);
+  const double scale = (max_density > 0.0) ?
+    (size_.y * 0.9 / max_density) : 0.0;
+  for (int x = 0; x < size_.x; ++x) {
+    int top = size_.y - static_cast<int>(densities[x] * scale + 0.5);
+    if (top < 0) top = 0;
+    for (int y = top; y < size_.y; ++y) {
+      overlay[static_cast<size_t>(y) * size_.x + x] =
+        (y < top + kLineWidth) ? kLineColor : kFillColor;
+    }
+  }
+  raster_.SetOverlay(overlay.data());
+  raster_.Invalidate();
+}
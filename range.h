@@ -8,45 +8,68 @@
 #define RANGE_H_
 
 #include <wchar.h>
+#ifdef _WIN32
 #include <windows.h>
-#include <gdiplus.h>
+#endif
 #include <vector>
-#include <memory>
 
+#include "./distribution.h"
 #include "./palette.h"
+#include "./raster.h"
 
-#include "./utility.h"
+#include "./common.h"
+
+  // The bucket ids of the canvas are stored in up to 16 bits, so the grid
+  // is limited to this number.
+#define RANGE_MAX_GRID  (65536)
 
 class Range {
  public:
   Range();
 
+  // The grid more than RANGE_MAX_GRID is limited to it.
+  void Init(int grid);
+  void SetColorId(int grid_id, int color_id);
+  void SetSize(const Vector2n& size);
+  void SetSelectedGridId(int grid_id);
+
+  // The distribution decides the probabilities of the grids. Its density
+  // is drawn over the cells instead of the graph image, the cells are the
+  // buckets dividing its range equally.
+  void SetDistribution(const Distribution& distribution);
+
+#ifdef _WIN32
   void Create(HWND hwnd, int grid, const wchar_t* file_name);
   void Paint(HWND hwnd, const Palette& palette);
+  void Expose();
   void Destroy(HWND hwnd);
 
   bool SelectGrid(HWND hwnd, int mouse_x, int mouse_y);
   void SetColor(HWND hwnd, const Palette& palette);
   void SetAllColor(HWND hwnd, const Palette& palette);
+#endif
 
   int GetColorId(int grid_id) const;
   int GetGrid() const;
+  const Distribution& GetDistribution() const;
 
- private:
-  HDC hdc_offscreen_;
-  HBITMAP hdc_bitmap_;
-  HPEN grid_pen_;
-  HPEN select_pen_;
+  // The render draws only the cells changed since the last render.
+  void Invalidate();
+  void Render(const Palette& palette);
+  const Raster& GetRaster() const;
 
-  // Data for GDI+.
-  ULONG_PTR gdi_token_;
-  std::unique_ptr<Gdiplus::Image> graph_image_;
+ private:
+  void MakeCurve();
 
+ private:
   int grid_;
   int color_num_;
   int selected_grid_id_;
   Vector2n size_;
   std::vector<int> color_id_;
+  Distribution distribution_;
+  bool curve_;
+  Raster raster_;
 };
 
 #endif  // RANGE_H_
@@ -0,0 +1,128 @@
+  // @file range_win32.cc
+  // @brief Range class, the Win32 drawing part.
+  // @author Mamoru Kaminaga
+  // @date 2017-11-17
+  // Copyright 2017 Mamoru Kaminaga
+  // This program is provided with MIT license. See "LICENSE.md".
+#include <wchar.h>
+#include <windows.h>
+#include <gdiplus.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+#include "./range.h"
+#include "./raster.h"
+#include "./utility.h"
+
+#include "./resource.h"
+
+void Range::Create(HWND hwnd, int grid, const wchar_t* file_name) {
+  // The palette size and color vector is set.
+  Init(grid);
+
+  // Window handle and size is acquired.
+  HWND hwnd_palette = GetDlgItem(hwnd, IDC_PIC_RANGE);
+  RECT rc;
+  GetClientRect(hwnd_palette, &rc);
+  size_.x = (rc.right - rc.left);
+  size_.y = (rc.bottom - rc.top);
+
+  // The preview is sized to the window.
+  SetSize(size_);
+
+  // The graph image is scaled by GDI+ only once, the result is blended
+  // over the cells by the frame buffer.
+  ULONG_PTR gdi_token = 0;
+  Gdiplus::GdiplusStartupInput gdi_startup_info;
+  Gdiplus::GdiplusStartup(&gdi_token, &gdi_startup_info, nullptr);
+  {
+    Gdiplus::Image graph_image(file_name);
+    Gdiplus::Bitmap overlay(size_.x, size_.y, PixelFormat32bppARGB);
+    {
+      Gdiplus::Graphics graphics(&overlay);
+      graphics.Clear(Gdiplus::Color(0, 0, 0, 0));
+      graphics.DrawImage(&graph_image, 0, 0, size_.x, size_.y);
+    }
+    Gdiplus::Rect rect(0, 0, size_.x, size_.y);
+    Gdiplus::BitmapData data;
+    if (overlay.LockBits(
+        &rect,
+        Gdiplus::ImageLockModeRead,
+        PixelFormat32bppARGB,
+        &data) == Gdiplus::Ok) {
+      std::vector<uint32_t> pixels(size_.x * size_.y);
+      for (int y = 0; y < size_.y; ++y) {
+        memcpy(
+            &pixels[y * size_.x],
+            static_cast<const uint8_t*>(data.Scan0) + y * data.Stride,
+            size_.x * sizeof(uint32_t));
+      }
+      overlay.UnlockBits(&data);
+      raster_.SetOverlay(pixels.data());
+    }
+  }
+  Gdiplus::GdiplusShutdown(gdi_token);
+}
+void Range::Paint(HWND hwnd, const Palette& palette) {
+  // Window handle and size is acquired.
+  HWND hwnd_palette = GetDlgItem(hwnd, IDC_PIC_RANGE);
+
+  // Only the dirty cells are drawn, only the damage is copied.
+  Render(palette);
+  Rect2n damage;
+  if (!raster_.TakeDamage(&damage)) return;
+  HDC hdc = GetDC(hwnd_palette);
+  BlitRaster(hdc, raster_, damage);
+  ReleaseDC(hwnd_palette, hdc);
+}
+void Range::Expose() {
+  raster_.Expose();
+}
+void Range::Destroy(HWND hwnd) {
+  // The frame buffer is released.
+  raster_.Init(Vector2n(0, 0));
+
+  // Warnings are prevented for non-used parameters.
+  UNREFERENCED_PARAMETER(hwnd);
+}
+
+bool Range::SelectGrid(HWND hwnd, int mouse_x, int mouse_y) {
+  // The relative mouse position is passed.
+  RECT rc;
+  GetWindowRect(GetDlgItem(hwnd, IDC_PIC_RANGE), &rc);
+  POINT pt;
+  pt.x = rc.left;
+  pt.y = rc.top;
+  ScreenToClient(hwnd, &pt);
+  int x = mouse_x - pt.x;
+  int y = mouse_y - pt.y;
+
+  // Illegal cases.
+  if (x < 0) return false;
+  if (x > size_.x) return false;
+  if (y < 0) return false;
+  if (y > size_.y) return false;
+
+  // Position to select.
+  int nx = static_cast<int>(grid_ * x / static_cast<double>(size_.x));
+  if (nx >= grid_) nx = grid_ - 1;
+  SetSelectedGridId(nx);
+  return true;
+}
+void Range::SetColor(HWND hwnd, const Palette& palette) {
+  // Store color id.
+  SetColorId(selected_grid_id_, palette.GetSelectedColorId());
+
+  // Warnings are prevented for non-used parameters.
+  UNREFERENCED_PARAMETER(hwnd);
+}
+void Range::SetAllColor(HWND hwnd, const Palette& palette) {
+  for (int grid_id = 0; grid_id < grid_; ++grid_id) {
+    // Store color id.
+    SetColorId(grid_id, palette.GetSelectedColorId());
+  }
+
+  // Warnings are prevented for non-used parameters.
+  UNREFERENCED_PARAMETER(hwnd);
+}
@@ -0,0 +1,233 @@
+  // @file raster.cc
+  // @brief Raster class.
+  // @author Mamoru Kaminaga
+  // @date 2026-10-17
+  // Copyright 2026 Mamoru Kaminaga
+  // This program is provided with MIT license. See "LICENSE.md".
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+#include "./raster.h"
+#include "./cpu.h"
+#include "./common.h"
+
+#ifdef CPU_X86
+#include <emmintrin.h>
+#endif
+
+namespace {
+  // The span of the pixels is filled by one color.
+void FillSpan(uint32_t* pixels, int num, uint32_t color) {
+  int x = 0;
+#ifdef CPU_X86
+  const __m128i c = _mm_set1_epi32(static_cast<int>(color));
+  for (; x + 16 <= num; x += 16) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&pixels[x]), c);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&pixels[x + 4]), c);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&pixels[x + 8]), c);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&pixels[x + 12]), c);
+  }
+  for (; x + 4 <= num; x += 4) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&pixels[x]), c);
+  }
+#endif
+  for (; x < num; ++x) pixels[x] = color;
+}
+  // The edges of the cells, same as the size * i / grid of the old panels.
+void MakeEdges(int size, int grid, std::vector<int>* edges) {
+  edges->resize(grid + 1);
+  for (int i = 0; i <= grid; ++i) {
+    (*edges)[i] = static_cast<int>(static_cast<int64_t>(size) * i / grid);
+  }
+}
+  // The overlay is blended over the span, the alpha is 0 to 255.
+void BlendSpan(uint32_t* pixels, const uint32_t* overlay, int num) {
+  for (int x = 0; x < num; ++x) {
+    const uint32_t o = overlay[x];
+    const uint32_t a = o >> 24;
+    if (a == 0) continue;
+    const uint32_t p = pixels[x];
+    uint32_t result = 0;
+    for (int shift = 0; shift < 24; shift += 8) {
+      const uint32_t c = ((p >> shift) & 0xff) * (255 - a) +
+        ((o >> shift) & 0xff) * a;
+      result |= ((c + 127) / 255) << shift;
+    }
+    pixels[x] = result;
+  }
+}
+}  // namespace
+
+Raster::Raster()
+  : size_(0, 0),
+    grid_(0, 0),
+    cell_num_(0),
+    frame_cell_num_(0) { }
+
+void Raster::Init(const Vector2n& size) {
+  assert(size.x >= 0);
+  assert(size.y >= 0);
+  size_ = size;
+  pixels_.assign(static_cast<size_t>(size.x) * size.y, 0);
+  overlay_.clear();
+  damage_ = Rect2n();
+  if ((grid_.x > 0) && (grid_.y > 0)) SetGrid(grid_);
+}
+void Raster::SetGrid(const Vector2n& grid) {
+  assert(grid.x > 0);
+  assert(grid.y > 0);
+  grid_ = grid;
+  MakeEdges(size_.x, grid.x, &edge_x_);
+  MakeEdges(size_.y, grid.y, &edge_y_);
+  dirty_begin_.resize(grid.y);
+  dirty_end_.resize(grid.y);
+  Invalidate();
+}
+Vector2n Raster::GetSize() const {
+  return size_;
+}
+Vector2n Raster::GetGrid() const {
+  return grid_;
+}
+const uint32_t* Raster::GetPixels() const {
+  return pixels_.data();
+}
+
+bool Raster::IsRowVisible(int row) const {
+  assert((row >= 0) && (row < grid_.y));
+  return edge_y_[row] < edge_y_[row + 1];
+}
+Rect2n Raster::GetCellRect(int column, int row) const {
+  assert((column >= 0) && (column < grid_.x));
+  assert((row >= 0) && (row < grid_.y));
+  return Rect2n(
+      edge_x_[column], edge_y_[row], edge_x_[column + 1], edge_y_[row + 1]);
+}
+
+void Raster::Invalidate() {
+  InvalidateCells(Rect2n(0, 0, grid_.x, grid_.y));
+}
+void Raster::InvalidateCells(const Rect2n& cells) {
+  // The cells are clipped by the grid, the span of the row is extended.
+  const int left = (cells.left > 0) ? cells.left : 0;
+  const int top = (cells.top > 0) ? cells.top : 0;
+  const int right = (cells.right < grid_.x) ? cells.right : grid_.x;
+  const int bottom = (cells.bottom < grid_.y) ? cells.bottom : grid_.y;
+  if ((left >= right) || (top >= bottom)) return;
+  for (int row = top; row < bottom; ++row) {
+    if (dirty_begin_[row] >= dirty_end_[row]) {
+      dirty_begin_[row] = left;
+      dirty_end_[row] = right;
+      continue;
+    }
+    if (left < dirty_begin_[row]) dirty_begin_[row] = left;
+    if (right > dirty_end_[row]) dirty_end_[row] = right;
+  }
+}
+void Raster::Expose() {
+  damage_ = Rect2n(0, 0, size_.x, size_.y);
+}
+bool Raster::GetDirtyColumns(int row, int* begin, int* end) const {
+  assert(begin);
+  assert(end);
+  if (!IsRowVisible(row)) return false;
+  *begin = dirty_begin_[row];
+  *end = dirty_end_[row];
+  return *begin < *end;
+}
+
+void Raster::FillCells(int row, int begin, int end, const uint32_t* colors) {
+  assert(colors);
+  assert((begin >= 0) && (end <= grid_.x));
+  if (!IsRowVisible(row) || (begin >= end)) return;
+
+  // The first line is filled span by span, the others are its copies.
+  const int y_begin = edge_y_[row];
+  const int y_end = edge_y_[row + 1];
+  const int x_begin = edge_x_[begin];
+  const int x_end = edge_x_[end];
+  uint32_t* line = &pixels_[static_cast<size_t>(y_begin) * size_.x];
+  for (int column = begin; column < end; ++column) {
+    const int x = edge_x_[column];
+    const int width = edge_x_[column + 1] - x;
+    if (width == 0) continue;
+    FillSpan(&line[x], width, colors[column]);
+    ++cell_num_;
+  }
+  for (int y = y_begin + 1; y < y_end; ++y) {
+    memcpy(&pixels_[static_cast<size_t>(y) * size_.x + x_begin],
+        &line[x_begin], (x_end - x_begin) * sizeof(uint32_t));
+  }
+  Composite(Rect2n(x_begin, y_begin, x_end, y_end));
+}
+void Raster::FillRect(const Rect2n& rect, uint32_t color) {
+  // The rectangle is clipped by the frame buffer.
+  const int left = (rect.left > 0) ? rect.left : 0;
+  const int top = (rect.top > 0) ? rect.top : 0;
+  const int right = (rect.right < size_.x) ? rect.right : size_.x;
+  const int bottom = (rect.bottom < size_.y) ? rect.bottom : size_.y;
+  if ((left >= right) || (top >= bottom)) return;
+  for (int y = top; y < bottom; ++y) {
+    FillSpan(&pixels_[static_cast<size_t>(y) * size_.x + left],
+        right - left, color);
+  }
+  Composite(Rect2n(left, top, right, bottom));
+}
+void Raster::FrameRect(const Rect2n& rect, uint32_t color, int width) {
+  assert(width > 0);
+  FillRect(Rect2n(rect.left, rect.top, rect.right, rect.top + width), color);
+  FillRect(
+      Rect2n(rect.left, rect.bottom - width, rect.right, rect.bottom), color);
+  FillRect(
+      Rect2n(rect.left, rect.top, rect.left + width, rect.bottom), color);
+  FillRect(
+      Rect2n(rect.right - width, rect.top, rect.right, rect.bottom), color);
+}
+
+void Raster::EndFrame() {
+  for (int row = 0; row < grid_.y; ++row) {
+    dirty_begin_[row] = 0;
+    dirty_end_[row] = 0;
+  }
+  frame_cell_num_ = cell_num_;
+  cell_num_ = 0;
+}
+int Raster::GetFrameCellNum() const {
+  return frame_cell_num_;
+}
+bool Raster::TakeDamage(Rect2n* damage) {
+  assert(damage);
+  *damage = damage_;
+  damage_ = Rect2n();
+  return (damage->left < damage->right) && (damage->top < damage->bottom);
+}
+void Raster::SetOverlay(const uint32_t* overlay) {
+  assert(overlay);
+  overlay_.assign(overlay, overlay + static_cast<size_t>(size_.x) * size_.y);
+}
+
+uint32_t Raster::MakeColor(const RGBVecotr& color) {
+  return PackColor(color);
+}
+
+void Raster::Composite(const Rect2n& rect) {
+  // The overlay is blended over the new pixels.
+  if (!overlay_.empty()) {
+    for (int y = rect.top; y < rect.bottom; ++y) {
+      const size_t offset = static_cast<size_t>(y) * size_.x + rect.left;
+      BlendSpan(&pixels_[offset], &overlay_[offset], rect.right - rect.left);
+    }
+  }
+
+  // The damage is the bounding rectangle of the drawn pixels.
+  if ((damage_.left >= damage_.right) || (damage_.top >= damage_.bottom)) {
+    damage_ = rect;
+    return;
+  }
+  if (rect.left < damage_.left) damage_.left = rect.left;
+  if (rect.top < damage_.top) damage_.top = rect.top;
+  if (rect.right > damage_.right) damage_.right = rect.right;
+  if (rect.bottom > damage_.bottom) damage_.bottom = rect.bottom;
+}
@@ -0,0 +1,82 @@
+  // @file raster.h
+  // @brief Raster class.
+  // @author Mamoru Kaminaga
+  // @date 2026-10-17
+  // Copyright 2026 Mamoru Kaminaga
+  // This program is provided with MIT license. See "LICENSE.md".
+#ifndef RASTER_H_
+#define RASTER_H_
+
+#include <stdint.h>
+#include <vector>
+
+#include "./common.h"
+
+  // The 32 bit frame buffer of the preview panels, the pixel is 0x00RRGGBB
+  // same as the top-down 32 bit DIB. The panel is divided into the grid of
+  // cells, the cell edges are computed once when the grid is set.
+  //
+  // The dirty cells are tracked as one span of columns per row, only they
+  // are drawn by the next frame. The damage is the rectangle of the pixels
+  // changed since it was taken, only it has to be copied to the screen.
+class Raster {
+ public:
+  Raster();
+
+  void Init(const Vector2n& size);
+  void SetGrid(const Vector2n& grid);
+  Vector2n GetSize() const;
+  Vector2n GetGrid() const;
+  const uint32_t* GetPixels() const;
+
+  // The cell rows smaller than a pixel are not visible.
+  bool IsRowVisible(int row) const;
+  Rect2n GetCellRect(int column, int row) const;
+
+  // The cells are marked to be drawn by the next frame.
+  void Invalidate();
+  void InvalidateCells(const Rect2n& cells);
+
+  // The whole frame buffer is copied again without drawing any cell.
+  void Expose();
+
+  // The dirty columns from begin to end - 1 of the visible row.
+  bool GetDirtyColumns(int row, int* begin, int* end) const;
+
+  // The cells from the column begin to end - 1 are filled, colors has one
+  // color per column of the row.
+  void FillCells(int row, int begin, int end, const uint32_t* colors);
+  void FillRect(const Rect2n& rect, uint32_t color);
+
+  // The frame of the width is drawn inside the rectangle.
+  void FrameRect(const Rect2n& rect, uint32_t color, int width);
+
+  // The dirty cells are cleared and the drawn cells are counted.
+  void EndFrame();
+  int GetFrameCellNum() const;
+  bool TakeDamage(Rect2n* damage);
+
+  // The non premultiplied 0xAARRGGBB image is blended over every pixel
+  // drawn, it must be the same size as the frame buffer.
+  void SetOverlay(const uint32_t* overlay);
+
+  static uint32_t MakeColor(const RGBVecotr& color);
+
+ private:
+  void Composite(const Rect2n& rect);
+
+ private:
+  Vector2n size_;
+  Vector2n grid_;
+  std::vector<int> edge_x_;
+  std::vector<int> edge_y_;
+  std::vector<int> dirty_begin_;
+  std::vector<int> dirty_end_;
+  std::vector<uint32_t> pixels_;
+  std::vector<uint32_t> overlay_;
+  Rect2n damage_;
+  int cell_num_;
+  int frame_cell_num_;
+};
+
+#endif  // RASTER_H_
@@ -0,0 +1,324 @@
+  // @file remapper.cc
+  // @brief Nearest palette color lookup of the truecolor images.
+  // @author Mamoru Kaminaga
+  // @date 2026-10-17
+  // Copyright 2026 Mamoru Kaminaga
+  // This program is provided with MIT license. See "LICENSE.md".
+#include <assert.h>
+#include <stdint.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "./remapper.h"
+#include "./palette.h"
+#include "./thread_pool.h"
+#include "./trace.h"
+#include "./common.h"
+
+#define REMAPPER_CELL_SHIFT (8 - REMAPPER_CELL_BITS)
+
+  // The cell of one color holds its id with this bit.
+#define REMAPPER_SINGLE     (0x80000000U)
+
+namespace {
+inline int GetRed(uint32_t color) {
+  return static_cast<int>((color >> 16) & 0xFF);
+}
+inline int GetGreen(uint32_t color) {
+  return static_cast<int>((color >> 8) & 0xFF);
+}
+inline int GetBlue(uint32_t color) {
+  return static_cast<int>(color & 0xFF);
+}
+inline int GetCell(uint32_t color) {
+  return ((GetRed(color) >> REMAPPER_CELL_SHIFT) << (REMAPPER_CELL_BITS * 2)) |
+    ((GetGreen(color) >> REMAPPER_CELL_SHIFT) << REMAPPER_CELL_BITS) |
+    (GetBlue(color) >> REMAPPER_CELL_SHIFT);
+}
+  // The nearest and the farthest squared distances of the value from the
+  // channel range of the cell.
+inline void MeasureChannel(
+    int value,
+    int low,
+    int high,
+    int* nearest,
+    int* farthest) {
+  const int near = (value < low) ? (low - value) :
+    ((value > high) ? (value - high) : 0);
+  const int far = (value - low > high - value) ?
+    (value - low) : (high - value);
+  *nearest += near * near;
+  *farthest += far * far;
+}
+inline int Clamp(int value) {
+  return (value < 0) ? 0 : ((value > 255) ? 255 : value);
+}
+  // The cells of the red value of the level of the bits are built from the
+  // colors of their parent cells in the level above. The color may be the
+  // nearest in the cell only when its nearest point is not farther than the
+  // farthest point of the best color, the colors of the cell are a part of
+  // the colors of the parent cell.
+void BuildCells(
+    int bits,
+    int red_cell,
+    const std::vector<uint32_t>& parent_offsets,
+    const std::vector<uint32_t>& parent_entries,
+    std::vector<uint32_t>* counts,
+    std::vector<uint32_t>* entries) {
+  const int side = 1 << bits;
+  const int size = 1 << (8 - bits);
+  counts->assign(side * side, 0);
+  entries->clear();
+  std::vector<int> nearest;
+  const int red_low = red_cell * size;
+  for (int g = 0; g < side; ++g) {
+    for (int b = 0; b < side; ++b) {
+      const int parent = ((red_cell >> 1) << ((bits - 1) * 2)) |
+        ((g >> 1) << (bits - 1)) | (b >> 1);
+      const uint32_t* colors = &parent_entries[parent_offsets[parent]];
+      const int color_num =
+        static_cast<int>(parent_offsets[parent + 1] - parent_offsets[parent]);
+      const int green_low = g * size;
+      const int blue_low = b * size;
+      nearest.assign(color_num, 0);
+      int bound = INT32_MAX;
+      for (int i = 0; i < color_num; ++i) {
+        int farthest = 0;
+        MeasureChannel(GetRed(colors[i]), red_low, red_low + size - 1,
+            &nearest[i], &farthest);
+        MeasureChannel(GetGreen(colors[i]), green_low, green_low + size - 1,
+            &nearest[i], &farthest);
+        MeasureChannel(GetBlue(colors[i]), blue_low, blue_low + size - 1,
+            &nearest[i], &farthest);
+        bound = (farthest < bound) ? farthest : bound;
+      }
+      uint32_t& count = (*counts)[g * side + b];
+      for (int i = 0; i < color_num; ++i) {
+        if (nearest[i] > bound) continue;
+        entries->push_back(colors[i]);
+        ++count;
+      }
+    }
+  }
+}
+}  // namespace
+
+Remapper::Remapper() { }
+
+void Remapper::Init(const Palette& palette, ThreadPool* pool) {
+  TRACE_SCOPE("Remapper::Init");
+  const int color_num = palette.GetColorNum();
+  assert((color_num > 0) && (color_num <= REMAPPER_MAX_COLOR_NUM));
+  colors_.resize(color_num);
+  for (int i = 0; i < color_num; ++i) {
+    colors_[i] = (static_cast<uint32_t>(i) << 24) |
+      (palette.GetPackedColor(i) & 0x00FFFFFF);
+  }
+
+  // The levels of the cells are halved from the whole cube, every task
+  // builds the cells of one red value and they are joined in the order of
+  // the cells.
+  // The same color of the larger id is never the nearest.
+  std::vector<uint32_t> offsets(2, 0);
+  std::vector<uint32_t> entries;
+  for (int i = 0; i < color_num; ++i) {
+    bool found = false;
+    for (size_t j = 0; !found && (j < entries.size()); ++j) {
+      found = ((entries[j] & 0x00FFFFFF) == (colors_[i] & 0x00FFFFFF));
+    }
+    if (!found) entries.push_back(colors_[i]);
+  }
+  offsets[1] = static_cast<uint32_t>(entries.size());
+  std::vector<uint32_t> level_offsets;
+  std::vector<uint32_t> level_entries;
+  for (int bits = 1; bits <= REMAPPER_CELL_BITS; ++bits) {
+    const int side = 1 << bits;
+    std::vector<std::vector<uint32_t> > counts(side);
+    std::vector<std::vector<uint32_t> > slices(side);
+    auto task = [&](int red_cell) {
+      BuildCells(bits, red_cell, offsets, entries,
+          &counts[red_cell], &slices[red_cell]);
+    };
+    if (pool != nullptr) {
+      pool->Run(side, task);
+    } else {
+      for (int i = 0; i < side; ++i) task(i);
+    }
+    level_offsets.assign(side * side * side + 1, 0);
+    level_entries.clear();
+    int cell = 0;
+    for (int i = 0; i < side; ++i) {
+      for (size_t j = 0; j < counts[i].size(); ++j) {
+        level_offsets[cell + 1] = level_offsets[cell] + counts[i][j];
+        ++cell;
+      }
+      level_entries.insert(
+          level_entries.end(), slices[i].begin(), slices[i].end());
+    }
+    offsets.swap(level_offsets);
+    entries.swap(level_entries);
+  }
+
+  // Most cells have one color, it is found without reading the entries.
+  // The other cells hold the offset of the number of the colors followed
+  // by the colors.
+  const size_t cell_num = offsets.size() - 1;
+  cells_.resize(cell_num);
+  entries_.clear();
+  for (size_t i = 0; i < cell_num; ++i) {
+    const uint32_t num = offsets[i + 1] - offsets[i];
+    if (num == 1) {
+      cells_[i] = REMAPPER_SINGLE | (entries[offsets[i]] >> 24);
+      continue;
+    }
+    cells_[i] = static_cast<uint32_t>(entries_.size());
+    entries_.push_back(num);
+    entries_.insert(entries_.end(),
+        entries.begin() + offsets[i], entries.begin() + offsets[i + 1]);
+  }
+}
+uint8_t Remapper::Find(uint32_t color) const {
+  const uint32_t cell = cells_[GetCell(color)];
+  if (cell & REMAPPER_SINGLE) return static_cast<uint8_t>(cell);
+  const uint32_t* entry = &entries_[cell + 1];
+  const uint32_t* end = entry + entries_[cell];
+
+  // The first color of the same distance is kept.
+  const int red = GetRed(color);
+  const int green = GetGreen(color);
+  const int blue = GetBlue(color);
+  uint32_t nearest = *entry;
+  int nearest_distance = INT32_MAX;
+  for (; entry < end; ++entry) {
+    const int dr = GetRed(*entry) - red;
+    const int dg = GetGreen(*entry) - green;
+    const int db = GetBlue(*entry) - blue;
+    const int distance = dr * dr + dg * dg + db * db;
+    const bool nearer = (distance < nearest_distance);
+    nearest = nearer ? *entry : nearest;
+    nearest_distance = nearer ? distance : nearest_distance;
+  }
+  return static_cast<uint8_t>(nearest >> 24);
+}
+void Remapper::MapRow(
+    const uint32_t* colors,
+    int num,
+    uint8_t* color_ids) const {
+  assert(colors || (num == 0));
+  assert(color_ids || (num == 0));
+
+  // The runs of the same color are looked up once.
+  uint32_t last_color = 0;
+  uint8_t last_id = Find(last_color);
+  for (int i = 0; i < num; ++i) {
+    const uint32_t color = colors[i] & 0x00FFFFFF;
+    if (color != last_color) {
+      last_color = color;
+      last_id = Find(color);
+    }
+    color_ids[i] = last_id;
+  }
+}
+void Remapper::MapImage(
+    const Vector2n& pixel,
+    const uint32_t* colors,
+    bool dither,
+    ThreadPool* pool,
+    uint8_t* color_ids) const {
+  assert(colors);
+  assert(color_ids);
+  TRACE_SCOPE("Remapper::MapImage");
+  const size_t width = static_cast<size_t>(pixel.x);
+  if (!dither) {
+    auto task = [&](int y) {
+      MapRow(&colors[y * width], pixel.x, &color_ids[y * width]);
+    };
+    if (pool != nullptr) {
+      pool->Run(pixel.y, task);
+    } else {
+      for (int y = 0; y < pixel.y; ++y) task(y);
+    }
+    return;
+  }
+
+  // The row y reads the errors from the row y - 1 and writes the errors to
+  // the row y + 1. Two error rows are enough, the row reusing the errors of
+  // the row y - 1 is behind it by the wavefront, the row 0 reads the zeros
+  // not written yet. The errors are 16 times of the colors with a pixel of
+  // the margin on both ends.
+  const size_t error_size = (width + 2) * 3;
+  std::vector<int> errors(error_size * 2, 0);
+  std::vector<std::atomic<int> > progress(pixel.y);
+  for (int y = 0; y < pixel.y; ++y) progress[y].store(0);
+  auto task = [&](int y) {
+    DitherRow(y, pixel, colors,
+        &errors[(y % 2) * error_size],
+        &errors[((y + 1) % 2) * error_size],
+        (y > 0) ? &progress[y - 1] : nullptr,
+        &progress[y],
+        color_ids);
+  };
+
+  // The tasks are taken in the order of the rows, the row waits only for
+  // the row already running.
+  if (pool != nullptr) {
+    pool->Run(pixel.y, task);
+  } else {
+    for (int y = 0; y < pixel.y; ++y) task(y);
+  }
+}
+
+void Remapper::DitherRow(
+    int y,
+    const Vector2n& pixel,
+    const uint32_t* colors,
+    const int* error_in,
+    int* error_out,
+    const std::atomic<int>* progress_above,
+    std::atomic<int>* progress,
+    uint8_t* color_ids) const {
+  const int width = pixel.x;
+  const uint32_t* row = &colors[static_cast<size_t>(y) * width];
+  uint8_t* ids = &color_ids[static_cast<size_t>(y) * width];
+  int carry[3] = {0, 0, 0};
+  for (int x0 = 0; x0 < width; x0 += REMAPPER_WAVEFRONT_BLOCK) {
+    const int x1 = (x0 + REMAPPER_WAVEFRONT_BLOCK < width) ?
+      (x0 + REMAPPER_WAVEFRONT_BLOCK) : width;
+
+    // The errors of the pixel x are complete when the row above has done
+    // the pixel x + 1.
+    if (progress_above != nullptr) {
+      const int need = (x1 + 1 < width) ? (x1 + 1) : width;
+      while (progress_above->load(std::memory_order_acquire) < need) {
+        std::this_thread::yield();
+      }
+    }
+    if (x0 == 0) {
+      for (int i = 0; i < 6; ++i) error_out[i] = 0;
+    }
+    for (int x = x0; x < x1; ++x) {
+      const uint32_t color = row[x];
+      int value[3] = {GetRed(color), GetGreen(color), GetBlue(color)};
+      int* out = &error_out[(x + 1) * 3];
+      for (int c = 0; c < 3; ++c) {
+        const int error = carry[c] + error_in[(x + 1) * 3 + c];
+        value[c] = Clamp(value[c] + ((error + 8) >> 4));
+      }
+      const uint8_t id = Find(static_cast<uint32_t>(
+          (value[0] << 16) | (value[1] << 8) | value[2]));
+      ids[x] = id;
+      const uint32_t chosen = colors_[id];
+      const int chosen_value[3] = {
+        GetRed(chosen), GetGreen(chosen), GetBlue(chosen)};
+      for (int c = 0; c < 3; ++c) {
+        const int error = value[c] - chosen_value[c];
+        carry[c] = error * 7;
+        out[3 + c] = error;
+        out[c] += error * 5;
+        out[c - 3] += error * 3;
+      }
+    }
+    progress->store(x1, std::memory_order_release);
+  }
+}
@@ -0,0 +1,76 @@
+  // @file remapper.h
+  // @brief Nearest palette color lookup of the truecolor images.
+  // @author Mamoru Kaminaga
+  // @date 2026-10-17
+  // Copyright 2026 Mamoru Kaminaga
+  // This program is provided with MIT license. See "LICENSE.md".
+#ifndef REMAPPER_H_
+#define REMAPPER_H_
+
+#include <stdint.h>
+#include <atomic>
+#include <vector>
+
+#include "./palette.h"
+#include "./thread_pool.h"
+
+#include "./common.h"
+
+  // The remapped images are 8 bit, the palette has up to this number of
+  // colors.
+#define REMAPPER_MAX_COLOR_NUM  (256)
+
+  // The lookup table divides the RGB cube into the cells of this number of
+  // the upper bits of every channel.
+#define REMAPPER_CELL_BITS      (6)
+
+  // The dithered row publishes its progress every this number of pixels.
+#define REMAPPER_WAVEFRONT_BLOCK  (64)
+
+  // The colors are mapped to the nearest palette colors by the squared
+  // distance of RGB, the lowest color id of the same distance. Every cell
+  // of the lookup table lists the palette colors which may be the nearest
+  // to some color of the cell, so only they are tested.
+class Remapper {
+ public:
+  Remapper();
+
+  // The table is built from the colors of the palette, the coarse cells
+  // first and the finer cells from them. The cells are divided among the
+  // threads of the pool, the pool may be nullptr.
+  void Init(const Palette& palette, ThreadPool* pool);
+  uint8_t Find(uint32_t color) const;
+  void MapRow(const uint32_t* colors, int num, uint8_t* color_ids) const;
+
+  // The image of the packed colors from the top row is mapped. The error
+  // diffusion of Floyd-Steinberg spreads the errors to the next pixels.
+  // The rows of the dithering run on the threads as a wavefront in the
+  // blocks of REMAPPER_WAVEFRONT_BLOCK pixels, a block starts after the row
+  // above has done the next block, so every row stays about one block
+  // behind. The color ids do not depend on the number of threads.
+  void MapImage(
+      const Vector2n& pixel,
+      const uint32_t* colors,
+      bool dither,
+      ThreadPool* pool,
+      uint8_t* color_ids) const;
+
+ private:
+  void DitherRow(
+      int y,
+      const Vector2n& pixel,
+      const uint32_t* colors,
+      const int* error_in,
+      int* error_out,
+      const std::atomic<int>* progress_above,
+      std::atomic<int>* progress,
+      uint8_t* color_ids) const;
+
+ private:
+  // The entry is the color id in the upper 8 bits and the packed color.
+  std::vector<uint32_t> colors_;
+  std::vector<uint32_t> cells_;
+  std::vector<uint32_t> entries_;
+};
+
+#endif  // REMAPPER_H_
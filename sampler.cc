@@ -0,0 +1,71 @@
+  // @file sampler.cc
+  // @brief Range bucket sampler.
+  // @author Mamoru Kaminaga
+  // @date 2026-10-17
+  // Copyright 2026 Mamoru Kaminaga
+  // This program is provided with MIT license. See "LICENSE.md".
+#include <assert.h>
+#include <stdint.h>
+#include <vector>
+
+#include "./sampler.h"
+#include "./distribution.h"
+
+BucketSampler::BucketSampler() : grid_(0) { }
+
+void BucketSampler::Init(int grid) {
+  Init(grid, Distribution());
+}
+void BucketSampler::Init(int grid, const Distribution& distribution) {
+  assert(grid > 0);
+  grid_ = grid;
+
+  // The probability of each bucket, the last bucket takes the tail.
+  GetBucketProbabilities(distribution, grid_, &probability_);
+
+  // The alias table is built by Vose's method.
+  std::vector<double> scaled(grid_);
+  std::vector<int> small;
+  std::vector<int> large;
+  for (int grid_id = 0; grid_id < grid_; ++grid_id) {
+    scaled[grid_id] = probability_[grid_id] * grid_;
+    if (scaled[grid_id] < 1.0) {
+      small.push_back(grid_id);
+    } else {
+      large.push_back(grid_id);
+    }
+  }
+  threshold_.assign(grid_, UINT32_MAX);
+  alias_.resize(grid_);
+  for (int grid_id = 0; grid_id < grid_; ++grid_id) {
+    alias_[grid_id] = grid_id;
+  }
+  while (!small.empty() && !large.empty()) {
+    const int less = small.back();
+    small.pop_back();
+    const int more = large.back();
+    const double threshold = scaled[less] * 4294967296.0;
+    threshold_[less] = (threshold < 4294967295.0) ?
+      static_cast<uint32_t>(threshold) : UINT32_MAX;
+    alias_[less] = more;
+    scaled[more] -= 1.0 - scaled[less];
+    if (scaled[more] < 1.0) {
+      large.pop_back();
+      small.push_back(more);
+    }
+  }
+
+  // The rest columns are full by the rounding error, aliased to themselves.
+}
+double BucketSampler::GetProbability(int grid_id) const {
+  return probability_[grid_id];
+}
+int BucketSampler::GetGrid() const {
+  return grid_;
+}
+const uint32_t* BucketSampler::GetThresholds() const {
+  return threshold_.data();
+}
+const int* BucketSampler::GetAliases() const {
+  return alias_.data();
+}
@@ -0,0 +1,45 @@
+  // @file sampler.h
+  // @brief Range bucket sampler.
+  // @author Mamoru Kaminaga
+  // @date 2026-10-17
+  // Copyright 2026 Mamoru Kaminaga
+  // This program is provided with MIT license. See "LICENSE.md".
+#ifndef SAMPLER_H_
+#define SAMPLER_H_
+
+#include <stdint.h>
+#include <vector>
+
+#include "./distribution.h"
+
+  // The bucket is drawn from one uniform 32 bit integer. The probability of
+  // each bucket is precomputed from the distribution as a Walker alias
+  // table, so the sampling costs one multiplication and one comparison
+  // whatever the distribution is. The default is the normal distribution.
+class BucketSampler {
+ public:
+  BucketSampler();
+
+  void Init(int grid);
+  void Init(int grid, const Distribution& distribution);
+  double GetProbability(int grid_id) const;
+  int GetGrid() const;
+  const uint32_t* GetThresholds() const;
+  const int* GetAliases() const;
+
+  inline int Sample(uint32_t random) const {
+    // The upper half selects the column and the lower half is the coin.
+    const uint64_t product = static_cast<uint64_t>(random) * grid_;
+    const int column = static_cast<int>(product >> 32);
+    const uint32_t coin = static_cast<uint32_t>(product);
+    return (coin < threshold_[column]) ? column : alias_[column];
+  }
+
+ private:
+  int grid_;
+  std::vector<double> probability_;
+  std::vector<uint32_t> threshold_;
+  std::vector<int> alias_;
+};
+
+#endif  // SAMPLER_H_
@@ -0,0 +1,154 @@
+  // @file sequence.cc
+  // @brief Pipelined export of the frame sequence.
+  // @author Mamoru Kaminaga
+  // @date 2026-10-17
+  // Copyright 2026 Mamoru Kaminaga
+  // This program is provided with MIT license. See "LICENSE.md".
+#include <assert.h>
+#include <wchar.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "./sequence.h"
+#include "./canvas.h"
+#include "./exporter.h"
+#include "./palette.h"
+#include "./range.h"
+#include "./thread_pool.h"
+#include "./trace.h"
+#include "./common.h"
+
+  // The frame numbers of the file names have this number of digits at
+  // least.
+#define SEQUENCE_FRAME_DIGITS (4)
+
+namespace {
+  // The frame passed between the stages, the ids are the slots of the
+  // canvases and the images.
+struct Frame {
+  int frame_id;
+  int canvas_id;
+  int image_id;
+};
+}  // namespace
+
+std::wstring MakeFrameFileName(const wchar_t* file_name, int frame_id) {
+  assert(file_name);
+  assert(frame_id >= 0);
+  std::wstring number = std::to_wstring(frame_id);
+  if (number.size() < SEQUENCE_FRAME_DIGITS) {
+    number.insert(0, SEQUENCE_FRAME_DIGITS - number.size(), L'0');
+  }
+
+  // The dot in the directory names is not the extension.
+  const std::wstring name(file_name);
+  const size_t separator = name.find_last_of(L"/\\");
+  size_t dot = name.find_last_of(L'.');
+  if ((dot == std::wstring::npos) ||
+      ((separator != std::wstring::npos) && (dot < separator))) {
+    dot = name.size();
+  }
+  return name.substr(0, dot) + L"_" + number + name.substr(dot);
+}
+bool ExportSequence(
+    const wchar_t* file_name,
+    const Canvas& canvas,
+    const Palette& palette,
+    const Range& range,
+    const SequenceOption& option,
+    ThreadPool* pool) {
+  TRACE_SCOPE("ExportSequence");
+  assert(file_name);
+  assert(option.queue_size > 0);
+
+  // Every stage holds one frame and the queue before it holds the others,
+  // so the slots are enough for the stages not to wait for each other
+  // unless the queue is full.
+  const int slot_num = option.queue_size + 2;
+  // The canvases take only the settings of the canvas, not its pixels and
+  // previews.
+  std::vector<Canvas> canvases(slot_num);
+  std::vector<std::vector<uint8_t> > images(slot_num);
+  BoundedQueue<int> free_canvases(slot_num);
+  BoundedQueue<int> free_images(slot_num);
+  BoundedQueue<Frame> generated(option.queue_size);
+  BoundedQueue<Frame> encoded(option.queue_size);
+  for (int i = 0; i < slot_num; ++i) {
+    canvases[i].Init(canvas.GetPixels(), canvas.GetStorage());
+    canvases[i].SetNoise(canvas.GetNoise());
+    canvases[i].SetThreadPool(pool);
+    free_canvases.Push(i);
+    free_images.Push(i);
+  }
+
+  // The failed stage closes all the queues, the other stages stop at the
+  // next push or pop.
+  std::atomic<bool> error(false);
+  auto fail = [&]() {
+    error = true;
+    free_canvases.Close();
+    free_images.Close();
+    generated.Close();
+    encoded.Close();
+  };
+
+  // The pool runs the jobs of the generation and the encoding one by one,
+  // both use all the threads. The writing overlaps with them.
+  std::thread encoder([&]() {
+    Frame frame;
+    while (generated.Pop(&frame)) {
+      if (!free_images.Pop(&frame.image_id)) break;
+      bool result = false;
+      {
+        TRACE_SCOPE("Sequence::Encode");
+        result = EncodeBitmapWin(canvases[frame.canvas_id], palette,
+            option.bit_number, pool, &images[frame.image_id]);
+      }
+      free_canvases.Push(frame.canvas_id);
+      if (!result) {
+        fail();
+        break;
+      }
+      if (!encoded.Push(frame)) break;
+    }
+    encoded.Close();
+  });
+  std::thread writer([&]() {
+    Frame frame;
+    while (encoded.Pop(&frame)) {
+      TRACE_SCOPE("Sequence::Write");
+      const std::vector<uint8_t>& image = images[frame.image_id];
+      FILE* fp = OpenFile(
+          MakeFrameFileName(file_name, frame.frame_id).c_str(), L"wb");
+      bool result = (fp != nullptr) &&
+        (fwrite(image.data(), 1, image.size(), fp) == image.size());
+      if (fp != nullptr) result = (fclose(fp) == 0) && result;
+      if (!result) {
+        fail();
+        break;
+      }
+      free_images.Push(frame.image_id);
+    }
+  });
+
+  // The frames are generated on this thread.
+  for (int frame_id = 0; frame_id < option.frame_num; ++frame_id) {
+    Frame frame = {frame_id, 0, 0};
+    if (!free_canvases.Pop(&frame.canvas_id)) break;
+    {
+      TRACE_SCOPE("Sequence::Generate");
+      const uint32_t seed = option.seed +
+        static_cast<uint32_t>(frame_id) * option.seed_step;
+      canvases[frame.canvas_id].Update(palette, range, seed);
+    }
+    if (!generated.Push(frame)) break;
+  }
+  generated.Close();
+  encoder.join();
+  writer.join();
+  return !error;
+}
@@ -0,0 +1,58 @@
+  // @file sequence.h
+  // @brief Pipelined export of the frame sequence.
+  // @author Mamoru Kaminaga
+  // @date 2026-10-17
+  // Copyright 2026 Mamoru Kaminaga
+  // This program is provided with MIT license. See "LICENSE.md".
+#ifndef SEQUENCE_H_
+#define SEQUENCE_H_
+
+#include <wchar.h>
+#include <stdint.h>
+#include <string>
+
+#include "./canvas.h"
+#include "./palette.h"
+#include "./range.h"
+#include "./thread_pool.h"
+
+#include "./common.h"
+
+  // The number of frames waiting between the stages by default.
+#define SEQUENCE_DEFAULT_QUEUE  (2)
+
+  // The frame i is generated by the seed + i * seed_step. The bit number
+  // of the files is 8, 24 or 32.
+struct SequenceOption {
+  int frame_num;
+  uint32_t seed;
+  uint32_t seed_step;
+  int bit_number;
+  int queue_size;
+  SequenceOption()
+    : frame_num(1),
+      seed(0),
+      seed_step(1),
+      bit_number(8),
+      queue_size(SEQUENCE_DEFAULT_QUEUE) { }
+};
+
+  // The frame number is put before the extension, "out.bmp" is
+  // "out_0000.bmp" for the first frame.
+std::wstring MakeFrameFileName(const wchar_t* file_name, int frame_id);
+
+  // The frames are generated, encoded into the bitmap files in the memory
+  // and written by the three stages running at the same time. The stages
+  // are connected by the queues of queue_size frames, the full queue stops
+  // the stage before it, so the time is near the slowest stage and the
+  // memory is bounded. The canvas gives the size, the storage and the
+  // noise of the frames, it is copied for the frames in flight.
+bool ExportSequence(
+    const wchar_t* file_name,
+    const Canvas& canvas,
+    const Palette& palette,
+    const Range& range,
+    const SequenceOption& option,
+    ThreadPool* pool);
+
+#endif  // SEQUENCE_H_
@@ -0,0 +1,133 @@
+  // @file statistics.cc
+  // @brief Statistical checks of the generated canvas.
+  // @author Mamoru Kaminaga
+  // @date 2026-10-17
+  // Copyright 2026 Mamoru Kaminaga
+  // This program is provided with MIT license. See "LICENSE.md".
+#include <assert.h>
+#include <stdint.h>
+#include <cmath>
+#include <vector>
+
+#include "./statistics.h"
+
+#define GAMMA_ITERATION_MAX   (1000)
+#define GAMMA_EPSILON         (1e-14)
+#define KOLMOGOROV_TERM_MAX   (100)
+#define KOLMOGOROV_EPSILON    (1e-12)
+
+namespace {
+  // The regularized upper incomplete gamma function Q(a, x).
+double GammaQ(double a, double x) {
+  if (x <= 0.0) return 1.0;
+  const double log_front = -x + a * std::log(x) - std::lgamma(a);
+  if (x < a + 1.0) {
+    // The series of P(a, x) converges quickly.
+    double term = 1.0 / a;
+    double sum = term;
+    for (int n = 1; n < GAMMA_ITERATION_MAX; ++n) {
+      term *= x / (a + n);
+      sum += term;
+      if (std::fabs(term) < std::fabs(sum) * GAMMA_EPSILON) break;
+    }
+    return 1.0 - sum * std::exp(log_front);
+  }
+
+  // The continued fraction of Q(a, x) by the modified Lentz's method.
+  const double tiny = 1e-300;
+  double b = x + 1.0 - a;
+  double c = 1.0 / tiny;
+  double d = 1.0 / b;
+  double h = d;
+  for (int n = 1; n < GAMMA_ITERATION_MAX; ++n) {
+    const double an = -n * (n - a);
+    b += 2.0;
+    d = an * d + b;
+    if (std::fabs(d) < tiny) d = tiny;
+    c = b + an / c;
+    if (std::fabs(c) < tiny) c = tiny;
+    d = 1.0 / d;
+    const double delta = d * c;
+    h *= delta;
+    if (std::fabs(delta - 1.0) < GAMMA_EPSILON) break;
+  }
+  return h * std::exp(log_front);
+}
+}  // namespace
+
+FitResult TestCounts(
+    const std::vector<int64_t>& counts,
+    const std::vector<double>& probabilities) {
+  assert(counts.size() == probabilities.size());
+
+  int64_t total = 0;
+  for (size_t i = 0; i < counts.size(); ++i) total += counts[i];
+
+  // The classes are pooled until the expectation is large enough.
+  FitResult result;
+  if (total == 0) return result;
+  const double kMinExpectation = 5.0;
+  int class_num = 0;
+  double observed = 0.0;
+  double expected = 0.0;
+  for (size_t i = 0; i < counts.size(); ++i) {
+    observed += static_cast<double>(counts[i]);
+    expected += probabilities[i] * total;
+    const bool last = (i + 1 == counts.size());
+    if ((expected < kMinExpectation) && !last) continue;
+    if (expected > 0.0) {
+      result.chi_square += (observed - expected) * (observed - expected) /
+        expected;
+      ++class_num;
+    }
+    observed = 0.0;
+    expected = 0.0;
+  }
+  result.freedom = (class_num > 1) ? (class_num - 1) : 0;
+  result.p_value = ChiSquareTail(result.chi_square, result.freedom);
+  return result;
+}
+KsResult TestCumulative(
+    const std::vector<int64_t>& counts,
+    const std::vector<double>& probabilities) {
+  assert(counts.size() == probabilities.size());
+
+  int64_t total = 0;
+  for (size_t i = 0; i < counts.size(); ++i) total += counts[i];
+
+  KsResult result;
+  if (total == 0) return result;
+  double observed = 0.0;
+  double expected = 0.0;
+  for (size_t i = 0; i < counts.size(); ++i) {
+    observed += static_cast<double>(counts[i]) / total;
+    expected += probabilities[i];
+    const double distance = std::fabs(observed - expected);
+    if (distance > result.distance) result.distance = distance;
+  }
+
+  // The scale of the distance has the correction for the small samples.
+  const double root = std::sqrt(static_cast<double>(total));
+  result.p_value =
+    KolmogorovTail((root + 0.12 + 0.11 / root) * result.distance);
+  return result;
+}
+double ChiSquareTail(double chi_square, int freedom) {
+  if (freedom <= 0) return 1.0;
+  return GammaQ(0.5 * freedom, 0.5 * chi_square);
+}
+double KolmogorovTail(double lambda) {
+  // The alternating series does not converge for the small lambda, where
+  // the probability is 1.
+  if (lambda < 0.2) return 1.0;
+  double sum = 0.0;
+  double sign = 1.0;
+  for (int j = 1; j <= KOLMOGOROV_TERM_MAX; ++j) {
+    const double term = sign * std::exp(-2.0 * j * j * lambda * lambda);
+    sum += term;
+    if (std::fabs(term) <= KOLMOGOROV_EPSILON * std::fabs(sum)) break;
+    sign = -sign;
+  }
+  sum *= 2.0;
+  return (sum < 0.0) ? 0.0 : ((sum > 1.0) ? 1.0 : sum);
+}
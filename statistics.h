@@ -0,0 +1,47 @@
+  // @file statistics.h
+  // @brief Statistical checks of the generated canvas.
+  // @author Mamoru Kaminaga
+  // @date 2026-10-17
+  // Copyright 2026 Mamoru Kaminaga
+  // This program is provided with MIT license. See "LICENSE.md".
+#ifndef STATISTICS_H_
+#define STATISTICS_H_
+
+#include <stdint.h>
+#include <vector>
+
+  // The result of Pearson's chi-square goodness of fit test.
+struct FitResult {
+  double chi_square;
+  int freedom;
+  double p_value;
+  FitResult() : chi_square(0.0), freedom(0), p_value(1.0) { }
+};
+
+  // The observed counts are tested against the expected probabilities.
+  // Classes expected less than 5 times are pooled with their neighbors.
+FitResult TestCounts(
+    const std::vector<int64_t>& counts,
+    const std::vector<double>& probabilities);
+
+  // The result of the Kolmogorov-Smirnov test of the ordered classes.
+struct KsResult {
+  double distance;
+  double p_value;
+  KsResult() : distance(0.0), p_value(1.0) { }
+};
+
+  // The largest distance between the observed and the expected cumulative
+  // fractions at the class boundaries. The p-value is of the continuous
+  // distribution, so it is conservative for the classes.
+KsResult TestCumulative(
+    const std::vector<int64_t>& counts,
+    const std::vector<double>& probabilities);
+
+  // The upper tail probability of the chi-square distribution.
+double ChiSquareTail(double chi_square, int freedom);
+
+  // The upper tail probability of the Kolmogorov distribution.
+double KolmogorovTail(double lambda);
+
+#endif  // STATISTICS_H_
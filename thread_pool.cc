@@ -0,0 +1,110 @@
+  // @file thread_pool.cc
+  // @brief Thread pool class.
+  // @author Mamoru Kaminaga
+  // @date 2026-10-17
+  // Copyright 2026 Mamoru Kaminaga
+  // This program is provided with MIT license. See "LICENSE.md".
+#include <assert.h>
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "./thread_pool.h"
+
+ThreadPool::ThreadPool()
+  : task_(nullptr),
+    task_num_(0),
+    next_task_id_(0),
+    working_num_(0),
+    job_id_(0),
+    exit_(false) { }
+ThreadPool::~ThreadPool() {
+  Destroy();
+}
+
+void ThreadPool::Create(int thread_num) {
+  assert(threads_.empty());
+
+  // The calling thread is counted as one of the threads.
+  exit_ = false;
+  for (int i = 1; i < thread_num; ++i) {
+    threads_.push_back(std::thread(&ThreadPool::Work, this));
+  }
+}
+void ThreadPool::Destroy() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    exit_ = true;
+  }
+  start_.notify_all();
+  for (size_t i = 0; i < threads_.size(); ++i) {
+    threads_[i].join();
+  }
+  threads_.clear();
+}
+
+void ThreadPool::Run(int task_num, const std::function<void(int)>& task) {
+  if (task_num <= 0) return;
+
+  // Small jobs and the pool without workers are run on this thread.
+  if (threads_.empty() || (task_num == 1)) {
+    for (int task_id = 0; task_id < task_num; ++task_id) task(task_id);
+    return;
+  }
+
+  // The jobs from the different threads are run one by one.
+  std::lock_guard<std::mutex> run_lock(run_mutex_);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    task_ = &task;
+    task_num_ = task_num;
+    next_task_id_ = 0;
+    working_num_ = static_cast<int>(threads_.size());
+    ++job_id_;
+  }
+  start_.notify_all();
+  RunTasks();
+
+  // The workers may still run the last tasks.
+  std::unique_lock<std::mutex> lock(mutex_);
+  finish_.wait(lock, [this] { return working_num_ == 0; });
+  task_ = nullptr;
+}
+int ThreadPool::GetThreadNum() const {
+  return static_cast<int>(threads_.size()) + 1;
+}
+int ThreadPool::GetHardwareThreadNum() {
+  const int thread_num = static_cast<int>(std::thread::hardware_concurrency());
+  return (thread_num > 0) ? thread_num : 1;
+}
+
+void ThreadPool::Work() {
+  uint64_t job_id = 0;
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      start_.wait(lock, [this, job_id] {
+          return exit_ || (job_id_ != job_id);
+      });
+      if (exit_) return;
+      job_id = job_id_;
+    }
+    RunTasks();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      --working_num_;
+    }
+    finish_.notify_one();
+  }
+}
+void ThreadPool::RunTasks() {
+  for (;;) {
+    const int task_id = next_task_id_.fetch_add(1);
+    if (task_id >= task_num_) return;
+    (*task_)(task_id);
+  }
+}
@@ -0,0 +1,142 @@
+  // @file thread_pool.h
+  // @brief Thread pool class.
+  // @author Mamoru Kaminaga
+  // @date 2026-10-17
+  // Copyright 2026 Mamoru Kaminaga
+  // This program is provided with MIT license. See "LICENSE.md".
+#ifndef THREAD_POOL_H_
+#define THREAD_POOL_H_
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+  // The workers run the indexed tasks of one job at a time, the calling
+  // thread works as one of the threads. A task must not run another job.
+class ThreadPool {
+ public:
+  ThreadPool();
+  ~ThreadPool();
+
+  void Create(int thread_num);
+  void Destroy();
+
+  // The tasks from 0 to task_num - 1 are run, returns when all are done.
+  void Run(int task_num, const std::function<void(int)>& task);
+  int GetThreadNum() const;
+
+  static int GetHardwareThreadNum();
+
+ private:
+  void Work();
+  void RunTasks();
+
+ private:
+  std::vector<std::thread> threads_;
+  std::mutex run_mutex_;
+  std::mutex mutex_;
+  std::condition_variable start_;
+  std::condition_variable finish_;
+  const std::function<void(int)>* task_;
+  int task_num_;
+  std::atomic<int> next_task_id_;
+  int working_num_;
+  uint64_t job_id_;
+  bool exit_;
+};
+
+  // The queue between the stages of a pipeline. Push waits while the queue
+  // is full, so the fast stage does not run ahead of the slow stage. Pop
+  // waits while the queue is empty. After Close, Push fails and Pop fails
+  // once the queue is empty.
+template<class T>
+class BoundedQueue {
+ public:
+  explicit BoundedQueue(size_t capacity)
+    : capacity_(capacity),
+      closed_(false) { }
+
+  bool Push(const T& item) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_full_.wait(lock, [this] {
+        return closed_ || (items_.size() < capacity_);
+    });
+    if (closed_) return false;
+    items_.push_back(item);
+    lock.unlock();
+    not_empty_.notify_one();
+    return true;
+  }
+  bool Pop(T* item) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_empty_.wait(lock, [this] { return closed_ || !items_.empty(); });
+    if (items_.empty()) return false;
+    *item = items_.front();
+    items_.pop_front();
+    lock.unlock();
+    not_full_.notify_one();
+    return true;
+  }
+  void Close() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      closed_ = true;
+    }
+    not_full_.notify_all();
+    not_empty_.notify_all();
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable not_full_;
+  std::condition_variable not_empty_;
+  std::deque<T> items_;
+  size_t capacity_;
+  bool closed_;
+};
+
+  // The control of a long job shared with the other threads. The job
+  // checks the cancel between its steps and counts the steps done, the
+  // others read the progress and cancel it. Reset is called before the job
+  // starts, the job sets the number of its steps.
+class JobControl {
+ public:
+  JobControl()
+    : canceled_(false),
+      step_num_(0),
+      done_num_(0) { }
+  void Reset() {
+    canceled_ = false;
+    SetStepNum(0);
+  }
+  void SetStepNum(int step_num) {
+    done_num_ = 0;
+    step_num_ = step_num;
+  }
+  void Cancel() {
+    canceled_ = true;
+  }
+  bool IsCanceled() const {
+    return canceled_;
+  }
+  void Advance() {
+    ++done_num_;
+  }
+  // The ratio of the steps done, from 0 to 1.
+  double GetProgress() const {
+    const int step_num = step_num_;
+    return (step_num > 0) ? (static_cast<double>(done_num_) / step_num) : 0.0;
+  }
+
+ private:
+  std::atomic<bool> canceled_;
+  std::atomic<int> step_num_;
+  std::atomic<int> done_num_;
+};
+
+#endif  // THREAD_POOL_H_
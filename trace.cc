@@ -0,0 +1,167 @@
+  // @file trace.cc
+  // @brief Trace spans and counters of the hot paths.
+  // @author Mamoru Kaminaga
+  // @date 2026-10-17
+  // Copyright 2026 Mamoru Kaminaga
+  // This program is provided with MIT license. See "LICENSE.md".
+#include <wchar.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "./trace.h"
+#include "./common.h"
+
+#ifdef ENABLE_TRACE
+namespace {
+  // The span has the duration, the counter has the value.
+enum TRACE_PHASE {
+  TRACE_PHASE_SPAN,
+  TRACE_PHASE_COUNTER,
+  TRACE_PHASE_ALLOC,
+};
+
+struct TraceEvent {
+  const char* name;
+  TRACE_PHASE phase;
+  int64_t time;
+  int64_t value;
+};
+
+  // The events of one thread, only the thread writes them while recording.
+struct TraceBuffer {
+  int thread_id;
+  std::vector<TraceEvent> events;
+};
+
+typedef std::chrono::steady_clock TraceClock;
+
+  // The buffers are made again for every recording, the thread finds its
+  // buffer out of date by the generation.
+std::atomic<bool> recording(false);
+std::atomic<uint64_t> generation(0);
+std::mutex trace_mutex;
+std::vector<std::unique_ptr<TraceBuffer> > buffers;
+std::map<std::string, int64_t> alloc_totals;
+std::wstring trace_file_name;
+TraceClock::time_point start_time;
+thread_local TraceBuffer* thread_buffer = nullptr;
+thread_local uint64_t thread_generation = 0;
+
+  // The nanoseconds from the start.
+inline int64_t GetTime() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      TraceClock::now() - start_time).count();
+}
+TraceBuffer* GetBuffer() {
+  const uint64_t current = generation.load(std::memory_order_acquire);
+  if ((thread_buffer == nullptr) || (thread_generation != current)) {
+    std::lock_guard<std::mutex> lock(trace_mutex);
+    buffers.push_back(std::unique_ptr<TraceBuffer>(new TraceBuffer()));
+    thread_buffer = buffers.back().get();
+    thread_buffer->thread_id = static_cast<int>(buffers.size());
+    thread_generation = current;
+  }
+  return thread_buffer;
+}
+void AddEvent(const char* name, TRACE_PHASE phase, int64_t time,
+    int64_t value) {
+  TraceEvent event = {name, phase, time, value};
+  GetBuffer()->events.push_back(event);
+}
+  // The names are the literals of the code, only the quotes and the
+  // backslashes are escaped.
+void WriteName(FILE* fp, const char* name) {
+  for (const char* p = name; *p != '\0'; ++p) {
+    if ((*p == '"') || (*p == '\\')) fputc('\\', fp);
+    fputc(*p, fp);
+  }
+}
+}  // namespace
+
+bool TraceStart(const wchar_t* file_name) {
+  std::lock_guard<std::mutex> lock(trace_mutex);
+  if (recording.load()) return false;
+  buffers.clear();
+  alloc_totals.clear();
+  trace_file_name = file_name;
+  start_time = TraceClock::now();
+  generation.fetch_add(1, std::memory_order_release);
+  recording.store(true, std::memory_order_release);
+  return true;
+}
+bool TraceStop() {
+  // The other threads must not record any more.
+  if (!recording.exchange(false)) return false;
+  std::lock_guard<std::mutex> lock(trace_mutex);
+  FILE* fp = OpenFile(trace_file_name.c_str(), L"w");
+  if (fp == nullptr) return false;
+
+  // The times are microseconds. The thread names are the metadata.
+  fprintf(fp, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+  bool first = true;
+  for (size_t i = 0; i < buffers.size(); ++i) {
+    const TraceBuffer& buffer = *buffers[i];
+    fprintf(fp, "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, "
+        "\"tid\": %d, \"args\": {\"name\": \"thread %d\"}}",
+        first ? "" : ",\n", buffer.thread_id, buffer.thread_id);
+    first = false;
+    for (size_t j = 0; j < buffer.events.size(); ++j) {
+      const TraceEvent& event = buffer.events[j];
+      fprintf(fp, ",\n{\"name\": \"");
+      WriteName(fp, event.name);
+      if (event.phase == TRACE_PHASE_SPAN) {
+        fprintf(fp, "\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, "
+            "\"ts\": %.3f, \"dur\": %.3f}",
+            buffer.thread_id, event.time / 1000.0, event.value / 1000.0);
+      } else {
+        fprintf(fp, "\", \"ph\": \"C\", \"pid\": 1, \"tid\": %d, "
+            "\"ts\": %.3f, \"args\": {\"%s\": %lld}}",
+            buffer.thread_id, event.time / 1000.0,
+            (event.phase == TRACE_PHASE_ALLOC) ? "bytes" : "value",
+            static_cast<long long>(event.value));
+      }
+    }
+  }
+  fprintf(fp, "\n]}\n");
+  buffers.clear();
+  return fclose(fp) == 0;
+}
+
+TraceScope::TraceScope(const char* name)
+  : name_(name),
+    begin_(recording.load(std::memory_order_relaxed) ? GetTime() : -1) { }
+TraceScope::~TraceScope() {
+  if ((begin_ < 0) || !recording.load(std::memory_order_relaxed)) return;
+  const int64_t end = GetTime();
+  AddEvent(name_, TRACE_PHASE_SPAN, begin_, end - begin_);
+}
+
+void TraceCounter(const char* name, int64_t value) {
+  if (!recording.load(std::memory_order_relaxed)) return;
+  AddEvent(name, TRACE_PHASE_COUNTER, GetTime(), value);
+}
+void TraceAlloc(const char* name, int64_t bytes) {
+  if (!recording.load(std::memory_order_relaxed)) return;
+  int64_t total = 0;
+  {
+    std::lock_guard<std::mutex> lock(trace_mutex);
+    total = (alloc_totals[name] += bytes);
+  }
+  AddEvent(name, TRACE_PHASE_ALLOC, GetTime(), total);
+}
+#else
+bool TraceStart(const wchar_t* file_name) {
+  UNREFERENCED_PARAMETER(file_name);
+  return false;
+}
+bool TraceStop() {
+  return false;
+}
+#endif
@@ -0,0 +1,58 @@
+  // @file trace.h
+  // @brief Trace spans and counters of the hot paths.
+  // @author Mamoru Kaminaga
+  // @date 2026-10-17
+  // Copyright 2026 Mamoru Kaminaga
+  // This program is provided with MIT license. See "LICENSE.md".
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <wchar.h>
+#include <stdint.h>
+
+#include "./common.h"
+
+  // The spans and the counters are recorded into the buffer of every thread
+  // and written as the Chrome trace-event JSON, chrome://tracing and
+  // Perfetto open it. They are compiled only with ENABLE_TRACE, otherwise
+  // the macros are empty and their arguments are not evaluated.
+  // The names must be the string literals.
+#ifdef ENABLE_TRACE
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b)  TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) \
+  TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(name)
+#define TRACE_COUNTER(name, value)  TraceCounter(name, value)
+#define TRACE_ALLOC(name, bytes)    TraceAlloc(name, bytes)
+#else
+#define TRACE_SCOPE(name)
+#define TRACE_COUNTER(name, value)
+#define TRACE_ALLOC(name, bytes)
+#endif
+
+  // The recording starts, the events are written to the file by TraceStop.
+  // TraceStop is called while no other thread records the events.
+  // False is returned when the tracing is not compiled.
+bool TraceStart(const wchar_t* file_name);
+bool TraceStop();
+
+#ifdef ENABLE_TRACE
+  // The span from the construction to the destruction.
+class TraceScope {
+ public:
+  explicit TraceScope(const char* name);
+  ~TraceScope();
+
+ private:
+  const char* name_;
+  int64_t begin_;
+};
+
+void TraceCounter(const char* name, int64_t value);
+
+  // The bytes are added to the total of the name, the total is recorded as
+  // the counter.
+void TraceAlloc(const char* name, int64_t bytes);
+#endif
+
+#endif  // TRACE_H_